@@ -91,6 +91,23 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether savestates only store the memory pages which changed since a base snapshot, which is
+# written next to the savestates the first time. Savestates are smaller and faster to create, but
+# they can't be loaded without the snapshot.
+# 0 (default): Off, 1: On
+use_incremental_savestates =
+
+# Whether snapshots of the emulation are kept in memory so that it can be stepped back (rewound)
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between two rewind snapshots. Default is 60 (1 second)
+rewind_frame_interval =
+
+# Maximum memory used by the rewind snapshots, in MiB. The oldest snapshots are dropped to stay
+# within it. Default is 256
+rewind_buffer_size =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0: OpenGL, 1 (default): GLES
@@ -116,6 +133,18 @@ use_asynchronous_gpu_emulation =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to shade vertices on multiple threads when hardware shaders are not used
+# 0 (default): Off, 1: On
+use_parallel_vertex_shading =
+
+# Number of vertices the shader JIT runs at once using SIMD. Requires a CPU with AVX2
+# 1 (default): One vertex at a time, 4: Four vertices, 8: Eight vertices
+shader_jit_batch_size =
+
+# Whether the software renderer splits the screen into tiles that are drawn on multiple threads
+# 0 (default): Off, 1: On
+use_parallel_rasterization =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
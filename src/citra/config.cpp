@@ -106,6 +106,13 @@ void Config::ReadValues() {
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.use_incremental_savestates =
+        sdl2_config->GetBoolean("Core", "use_incremental_savestates", false);
+    Settings::values.enable_rewind = sdl2_config->GetBoolean("Core", "enable_rewind", false);
+    Settings::values.rewind_frame_interval =
+        sdl2_config->GetInteger("Core", "rewind_frame_interval", 60);
+    Settings::values.rewind_buffer_size =
+        sdl2_config->GetInteger("Core", "rewind_buffer_size", 512);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -121,6 +128,12 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_parallel_vertex_shading =
+        sdl2_config->GetBoolean("Renderer", "use_parallel_vertex_shading", false);
+    Settings::values.shader_jit_batch_size =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "shader_jit_batch_size", 1));
+    Settings::values.use_parallel_rasterization =
+        sdl2_config->GetBoolean("Renderer", "use_parallel_rasterization", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.use_frame_limit = sdl2_config->GetBoolean("Renderer", "use_frame_limit", true);
@@ -97,6 +97,23 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether savestates only store the memory pages which changed since a base snapshot, which is
+# written next to the savestates the first time. Savestates are smaller and faster to create, but
+# they can't be loaded without the snapshot.
+# 0 (default): Off, 1: On
+use_incremental_savestates =
+
+# Whether snapshots of the emulation are kept in memory so that it can be stepped back (rewound)
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between two rewind snapshots. Default is 60 (1 second)
+rewind_frame_interval =
+
+# Maximum memory used by the rewind snapshots, in MiB. The oldest snapshots are dropped to stay
+# within it. Default is 512
+rewind_buffer_size =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -122,6 +139,18 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to shade vertices on multiple threads when hardware shaders are not used
+# 0 (default): Off, 1: On
+use_parallel_vertex_shading =
+
+# Number of vertices the shader JIT runs at once using SIMD. Requires a CPU with AVX2
+# 1 (default): One vertex at a time, 4: Four vertices, 8: Eight vertices
+shader_jit_batch_size =
+
+# Whether the software renderer splits the screen into tiles that are drawn on multiple threads
+# 0 (default): Off, 1: On
+use_parallel_rasterization =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
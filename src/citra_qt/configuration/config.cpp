@@ -57,7 +57,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 23> default_hotkeys{
+const std::array<UISettings::Shortcut, 24> default_hotkeys{
     {{QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral("\\"), Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::ApplicationShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"), Qt::WindowShortcut}},
@@ -70,6 +70,7 @@ const std::array<UISettings::Shortcut, 23> default_hotkeys{
      {QStringLiteral("Load File"),                QStringLiteral("Main Window"), {QStringLiteral("Ctrl+O"), Qt::WindowShortcut}},
      {QStringLiteral("Remove Amiibo"),            QStringLiteral("Main Window"), {QStringLiteral("F3"), Qt::ApplicationShortcut}},
      {QStringLiteral("Restart Emulation"),        QStringLiteral("Main Window"), {QStringLiteral("F6"), Qt::WindowShortcut}},
+     {QStringLiteral("Rewind"),                   QStringLiteral("Main Window"), {QStringLiteral("Ctrl+R"), Qt::ApplicationShortcut}},
      {QStringLiteral("Rotate Screens Upright"),   QStringLiteral("Main Window"), {QStringLiteral("F8"), Qt::WindowShortcut}},
      {QStringLiteral("Stop Emulation"),           QStringLiteral("Main Window"), {QStringLiteral("F5"), Qt::WindowShortcut}},
      {QStringLiteral("Swap Screens"),             QStringLiteral("Main Window"), {QStringLiteral("F9"), Qt::WindowShortcut}},
@@ -296,6 +297,13 @@ void Config::ReadCoreValues() {
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
     Settings::values.cpu_clock_percentage =
         ReadSetting(QStringLiteral("cpu_clock_percentage"), 100).toInt();
+    Settings::values.use_incremental_savestates =
+        ReadSetting(QStringLiteral("use_incremental_savestates"), false).toBool();
+    Settings::values.enable_rewind = ReadSetting(QStringLiteral("enable_rewind"), false).toBool();
+    Settings::values.rewind_frame_interval =
+        ReadSetting(QStringLiteral("rewind_frame_interval"), 60).toInt();
+    Settings::values.rewind_buffer_size =
+        ReadSetting(QStringLiteral("rewind_buffer_size"), 512).toInt();
 
     qt_config->endGroup();
 }
@@ -480,6 +488,12 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), false).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.use_parallel_vertex_shading =
+        ReadSetting(QStringLiteral("use_parallel_vertex_shading"), false).toBool();
+    Settings::values.shader_jit_batch_size =
+        static_cast<u16>(ReadSetting(QStringLiteral("shader_jit_batch_size"), 1).toInt());
+    Settings::values.use_parallel_rasterization =
+        ReadSetting(QStringLiteral("use_parallel_rasterization"), false).toBool();
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting(QStringLiteral("resolution_factor"), 1).toInt());
@@ -844,6 +858,12 @@ void Config::SaveCoreValues() {
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
     WriteSetting(QStringLiteral("cpu_clock_percentage"), Settings::values.cpu_clock_percentage,
                  100);
+    WriteSetting(QStringLiteral("use_incremental_savestates"),
+                 Settings::values.use_incremental_savestates, false);
+    WriteSetting(QStringLiteral("enable_rewind"), Settings::values.enable_rewind, false);
+    WriteSetting(QStringLiteral("rewind_frame_interval"), Settings::values.rewind_frame_interval,
+                 60);
+    WriteSetting(QStringLiteral("rewind_buffer_size"), Settings::values.rewind_buffer_size, 512);
 
     qt_config->endGroup();
 }
@@ -981,6 +1001,12 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  false);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("use_parallel_vertex_shading"),
+                 Settings::values.use_parallel_vertex_shading, false);
+    WriteSetting(QStringLiteral("shader_jit_batch_size"), Settings::values.shader_jit_batch_size,
+                 1);
+    WriteSetting(QStringLiteral("use_parallel_rasterization"),
+                 Settings::values.use_parallel_rasterization, false);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
     WriteSetting(QStringLiteral("resolution_factor"), Settings::values.resolution_factor, 1);
     WriteSetting(QStringLiteral("use_frame_limit"), Settings::values.use_frame_limit, true);
@@ -282,8 +282,13 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    rewind_snapshot_label = new QLabel();
+    rewind_snapshot_label->setToolTip(
+        tr("Time taken by the slowest rewind snapshot since the last update. Snapshots taking "
+           "longer than a frame cause stutter."));
 
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    for (auto& label :
+         {emu_speed_label, game_fps_label, emu_frametime_label, rewind_snapshot_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -422,6 +427,13 @@ void GMainWindow::InitializeSaveStateMenuActions() {
     connect(ui.menu_Save_State->menuAction(), &QAction::hovered, this,
             &GMainWindow::UpdateSaveStates);
 
+    // Save states are written in the background
+    connect(this, &GMainWindow::SaveStateCompleted, this, &GMainWindow::OnSaveStateCompleted,
+            Qt::QueuedConnection);
+    Core::System::GetInstance().SetSaveStateCallback([this](u32 slot, const std::string& error) {
+        emit SaveStateCompleted(slot, QString::fromStdString(error));
+    });
+
     UpdateSaveStates();
 }
 
@@ -520,6 +532,13 @@ void GMainWindow::InitializeHotkeys() {
             &QShortcut::activated, ui.action_Enable_Frame_Advancing, &QAction::trigger);
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Advance Frame"), this),
             &QShortcut::activated, ui.action_Advance_Frame, &QAction::trigger);
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Rewind"), this),
+            &QShortcut::activated, this, [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestRewind();
+                    Core::System::GetInstance().frame_limiter.AdvanceFrame();
+                }
+            });
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Load Amiibo"), this),
             &QShortcut::activated, this, [&] {
                 if (ui.action_Load_Amiibo->isEnabled()) {
@@ -1122,6 +1141,7 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    rewind_snapshot_label->setVisible(false);
 
     UpdateSaveStates();
 
@@ -1677,6 +1697,16 @@ void GMainWindow::OnSaveState() {
     newest_slot = action->data().toUInt();
 }
 
+void GMainWindow::OnSaveStateCompleted(u32 slot, const QString& error) {
+    if (!error.isEmpty()) {
+        QMessageBox::critical(this, tr("Error Saving State"),
+                              tr("Could not save the state to slot %1: %2").arg(slot).arg(error));
+        return;
+    }
+    statusBar()->showMessage(tr("Saved the state to slot %1").arg(slot), 3000);
+    UpdateSaveStates();
+}
+
 void GMainWindow::OnLoadState() {
     QAction* action = qobject_cast<QAction*>(sender());
     assert(action);
@@ -2028,10 +2058,13 @@ void GMainWindow::UpdateStatusBar() {
     }
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
+    rewind_snapshot_label->setText(
+        tr("Rewind: %1 ms").arg(results.rewind_snapshot_time * 1000.0, 0, 'f', 2));
 
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+    rewind_snapshot_label->setVisible(Settings::values.enable_rewind);
 }
 
 void GMainWindow::HideMouseCursor() {
@@ -2343,6 +2376,9 @@ void GMainWindow::RetranslateStatusBar() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    rewind_snapshot_label->setToolTip(
+        tr("Time taken by the slowest rewind snapshot since the last update. Snapshots taking "
+           "longer than a frame cause stutter."));
 
     multiplayer_state->retranslateUi();
 }
@@ -98,6 +98,9 @@ signals:
      */
     void EmulationStopping();
 
+    /// Signal that is emitted from a background thread when a save state has been written
+    void SaveStateCompleted(u32 slot, QString error);
+
     void UpdateProgress(std::size_t written, std::size_t total);
     void CIAInstallReport(Service::AM::InstallStatus status, QString filepath);
     void CIAInstallFinished();
@@ -169,6 +172,7 @@ private slots:
     void OnPauseGame();
     void OnStopGame();
     void OnSaveState();
+    void OnSaveStateCompleted(u32 slot, const QString& error);
     void OnLoadState();
     void OnMenuReportCompatibility();
     /// Called whenever a user selects a game in the game list widget.
@@ -243,6 +247,7 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* rewind_snapshot_label = nullptr;
     QTimer status_bar_update_timer;
 
     MultiplayerState* multiplayer_state = nullptr;
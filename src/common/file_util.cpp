@@ -43,8 +43,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(__APPLE__)
@@ -1045,4 +1047,101 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() = default;
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    // The mapping keeps the file alive, so the file handle isn't needed anymore
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        LOG_ERROR(Common_Filesystem, "CreateFileMapping failed on {}: {}", filename,
+                  GetLastErrorMsg());
+        return;
+    }
+
+    data = static_cast<const u8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        LOG_ERROR(Common_Filesystem, "MapViewOfFile failed on {}: {}", filename,
+                  GetLastErrorMsg());
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return;
+    }
+    size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || file_info.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    // The mapping keeps the file alive, so the descriptor isn't needed anymore
+    void* const view = mmap(nullptr, static_cast<std::size_t>(file_info.st_size), PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "mmap failed on {}: {}", filename, GetLastErrorMsg());
+        return;
+    }
+
+    data = static_cast<const u8*>(view);
+    size = static_cast<std::size_t>(file_info.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) noexcept {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+#ifdef _WIN32
+    std::swap(mapping, other.mapping);
+#endif
+}
+
+void MappedFile::Close() {
+    if (data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(const_cast<u8*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
 } // namespace FileUtil
@@ -369,6 +369,43 @@ private:
     friend class boost::serialization::access;
 };
 
+// Read-only memory mapping of a whole file. The contents are paged in on demand, so opening a large
+// file is cheap when only part of it is used.
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    void Swap(MappedFile& other) noexcept;
+
+    void Close();
+
+    // Empty files can't be mapped, so they are never considered open
+    bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    const u8* GetData() const {
+        return data;
+    }
+
+    std::size_t GetSize() const {
+        return size;
+    }
+
+private:
+    const u8* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
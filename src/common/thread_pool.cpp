@@ -0,0 +1,101 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t num_workers, std::string name) : name{std::move(name)} {
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_condition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t num_tasks, const std::function<void(std::size_t)>& func) {
+    if (num_tasks == 0) {
+        return;
+    }
+    if (num_tasks == 1 || workers.empty()) {
+        for (std::size_t task = 0; task < num_tasks; ++task) {
+            func(task);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        ASSERT_MSG(!job_open, "ThreadPool::ParallelFor is not reentrant");
+        job = &func;
+        job_size = num_tasks;
+        next_task = 0;
+        ++job_generation;
+        job_open = true;
+    }
+    work_condition.notify_all();
+
+    RunTasks();
+
+    // Once the job is closed no further worker can join it, so waiting for the active workers to
+    // leave guarantees that nobody touches func after we return.
+    std::unique_lock lock{mutex};
+    job_open = false;
+    done_condition.wait(lock, [this] { return active_workers == 0; });
+    job = nullptr;
+}
+
+std::size_t ThreadPool::DefaultWorkerCount() {
+    // Leave room for the emulation thread, which also runs tasks, and the GPU thread
+    const std::size_t hardware_threads = std::thread::hardware_concurrency();
+    return hardware_threads > 2 ? hardware_threads - 2 : 0;
+}
+
+void ThreadPool::WorkerLoop(std::size_t index) {
+    const std::string thread_name = name + ':' + std::to_string(index);
+    SetCurrentThreadName(thread_name.c_str());
+
+    u64 seen_generation = 0;
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_condition.wait(lock, [this, seen_generation] {
+            return stop || (job_open && job_generation != seen_generation);
+        });
+        if (stop) {
+            return;
+        }
+
+        seen_generation = job_generation;
+        ++active_workers;
+        lock.unlock();
+
+        RunTasks();
+
+        lock.lock();
+        if (--active_workers == 0) {
+            done_condition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunTasks() {
+    for (std::size_t task = next_task++; task < job_size; task = next_task++) {
+        (*job)(task);
+    }
+}
+
+} // namespace Common
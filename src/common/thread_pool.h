@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A fixed set of worker threads used to split data-parallel work, such as shading a batch of
+ * vertices, into independent tasks.
+ *
+ * Tasks are handed out dynamically, so uneven tasks are balanced between the threads. The thread
+ * calling ParallelFor takes part in running the tasks, so a pool with zero workers simply runs
+ * everything on the calling thread.
+ */
+class ThreadPool {
+public:
+    /// Creates a pool with the given number of worker threads, named "<name>:<index>"
+    ThreadPool(std::size_t num_workers, std::string name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Returns the number of threads that run tasks, including the calling thread
+    std::size_t NumThreads() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Runs func(task) for every task in [0, num_tasks) and blocks until all of them have finished.
+     * Tasks may run in any order and on any thread. Only one thread may call this at a time.
+     */
+    void ParallelFor(std::size_t num_tasks, const std::function<void(std::size_t)>& func);
+
+    /// Returns a worker count suitable for a pool shared with the emulation and GPU threads
+    static std::size_t DefaultWorkerCount();
+
+private:
+    void WorkerLoop(std::size_t index);
+    void RunTasks();
+
+    std::vector<std::thread> workers;
+    std::string name;
+
+    std::mutex mutex;
+    std::condition_variable work_condition;
+    std::condition_variable done_condition;
+
+    // The fields below are only modified while holding mutex
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::size_t job_size = 0;
+    u64 job_generation = 0;
+    bool job_open = false;
+    std::size_t active_workers = 0;
+    bool stop = false;
+
+    std::atomic_size_t next_task{};
+};
+
+} // namespace Common
@@ -4,204 +4,202 @@
 
 #pragma once
 
-#include <algorithm>
 #include <array>
 #include <deque>
 #include <boost/serialization/deque.hpp>
 #include <boost/serialization/split_member.hpp>
+#include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/common_types.h"
 
 namespace Common {
 
+/// Links of an object in a ThreadQueueList. The queued objects have it as their `queue_hook`.
+template <class T>
+struct ThreadQueueHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+    /// Priority level the object is queued in, or -1 if it isn't queued
+    unsigned int priority = -1;
+};
+
+/**
+ * Queues of objects for each priority level. The objects are linked through their `queue_hook`
+ * member rather than stored, so that no allocation is needed, and the non-empty levels are kept in
+ * a bitmap, so that all the operations take constant time. An object can only be in one queue at
+ * a time.
+ */
 template <class T, unsigned int N>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
-
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
-
-    // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
-        }
+    static_assert(NUM_QUEUES <= 64, "The priority levels must fit in the bitmap");
 
-        return -1;
-    }
+    ThreadQueueList() = default;
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
-        }
+    ThreadQueueList(const ThreadQueueList&) = delete;
+    ThreadQueueList& operator=(const ThreadQueueList&) = delete;
 
-        return T();
+    // Only for debugging, returns priority level.
+    Priority contains(const T* object) const {
+        return object->queue_hook.priority;
     }
 
-    T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+    T* get_first() const {
+        if (nonempty == 0) {
+            return nullptr;
         }
-
-        return T();
+        return queues[LeastSignificantSetBit(nonempty)].head;
     }
 
-    T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
+    T* pop_first() {
+        T* const object = get_first();
+        if (object != nullptr) {
+            unlink(object);
         }
-
-        return T();
+        return object;
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
-    }
-
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+    T* pop_first_better(Priority priority) {
+        const u64 better = nonempty & ((u64(1) << priority) - 1);
+        if (better == 0) {
+            return nullptr;
+        }
+        T* const object = queues[LeastSignificantSetBit(better)].head;
+        unlink(object);
+        return object;
+    }
+
+    void push_front(Priority priority, T* object) {
+        auto& hook = object->queue_hook;
+        DEBUG_ASSERT_MSG(hook.priority == static_cast<Priority>(-1), "Object queued twice");
+        Queue& cur = queues[priority];
+        hook.priority = priority;
+        hook.prev = nullptr;
+        hook.next = cur.head;
+        if (cur.head != nullptr) {
+            cur.head->queue_hook.prev = object;
+        } else {
+            cur.tail = object;
+            nonempty |= u64(1) << priority;
+        }
+        cur.head = object;
+    }
+
+    void push_back(Priority priority, T* object) {
+        auto& hook = object->queue_hook;
+        DEBUG_ASSERT_MSG(hook.priority == static_cast<Priority>(-1), "Object queued twice");
+        Queue& cur = queues[priority];
+        hook.priority = priority;
+        hook.prev = cur.tail;
+        hook.next = nullptr;
+        if (cur.tail != nullptr) {
+            cur.tail->queue_hook.next = object;
+        } else {
+            cur.head = object;
+            nonempty |= u64(1) << priority;
+        }
+        cur.tail = object;
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+    void move(T* object, Priority old_priority, Priority new_priority) {
+        remove(old_priority, object);
+        push_back(new_priority, object);
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* const cur = &queues[priority];
-        const auto iter = std::remove(cur->data.begin(), cur->data.end(), thread_id);
-        cur->data.erase(iter, cur->data.end());
+    /// Removes an object from a queue, if it is queued in it
+    void remove(Priority priority, T* object) {
+        if (object->queue_hook.priority == priority) {
+            unlink(object);
+        }
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+        T* const object = queues[priority].head;
+        if (object != nullptr && object->queue_hook.next != nullptr) {
+            unlink(object);
+            push_back(priority, object);
         }
     }
 
     void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        while (T* const object = get_first()) {
+            unlink(object);
+        }
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return queues[priority].head == nullptr;
     }
 
 private:
     struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
+        T* head = nullptr;
+        T* tail = nullptr;
     };
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
-    }
-
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
-        }
-
-        cur->next_nonempty = first;
-        first = cur;
-    }
-
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
-    std::array<Queue, NUM_QUEUES> queues;
-
-    s64 ToIndex(const Queue* q) const {
-        if (q == nullptr) {
-            return -2;
-        } else if (q == UnlinkedTag()) {
-            return -1;
+    void unlink(T* object) {
+        auto& hook = object->queue_hook;
+        Queue& cur = queues[hook.priority];
+        if (hook.prev != nullptr) {
+            hook.prev->queue_hook.next = hook.next;
         } else {
-            return q - queues.data();
+            cur.head = hook.next;
         }
-    }
-
-    Queue* ToPointer(s64 idx) {
-        if (idx == -1) {
-            return UnlinkedTag();
-        } else if (idx < 0) {
-            return nullptr;
+        if (hook.next != nullptr) {
+            hook.next->queue_hook.prev = hook.prev;
         } else {
-            return &queues[idx];
+            cur.tail = hook.prev;
+        }
+        if (cur.head == nullptr) {
+            nonempty &= ~(u64(1) << hook.priority);
         }
+        hook = {};
     }
 
+    /// Bit i is set when the queue of priority level i isn't empty
+    u64 nonempty = 0;
+    // The priority level queues of objects.
+    std::array<Queue, NUM_QUEUES> queues{};
+
+    // Savestates keep the layout of the previous deque-based queues, in which each level was linked
+    // to the next one. All the levels are written as linked, which is valid for any contents.
     friend class boost::serialization::access;
     template <class Archive>
     void save(Archive& ar, const unsigned int file_version) const {
-        const s64 idx = ToIndex(first);
-        ar << idx;
+        const s64 first = 0;
+        ar << first;
         for (std::size_t i = 0; i < NUM_QUEUES; i++) {
-            const s64 idx1 = ToIndex(queues[i].next_nonempty);
-            ar << idx1;
-            ar << queues[i].data;
+            // -2 marks the end of the links
+            const s64 next_nonempty = i + 1 < NUM_QUEUES ? static_cast<s64>(i + 1) : -2;
+            ar << next_nonempty;
+            std::deque<T*> data;
+            for (T* object = queues[i].head; object != nullptr;
+                 object = object->queue_hook.next) {
+                data.push_back(object);
+            }
+            const std::deque<T*>& const_data = data;
+            ar << const_data;
         }
     }
 
     template <class Archive>
     void load(Archive& ar, const unsigned int file_version) {
+        // The objects queued before are from the previous state, so they aren't unlinked
+        nonempty = 0;
+        queues.fill({});
         s64 idx;
         ar >> idx;
-        first = ToPointer(idx);
         for (std::size_t i = 0; i < NUM_QUEUES; i++) {
             ar >> idx;
-            queues[i].next_nonempty = ToPointer(idx);
-            ar >> queues[i].data;
+            std::deque<T*> data;
+            ar >> data;
+            for (T* object : data) {
+                push_back(static_cast<Priority>(i), object);
+            }
         }
     }
 
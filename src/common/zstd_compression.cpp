@@ -3,9 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
 #include <zstd.h>
 
 #include "common/assert.h"
+#include "common/file_util.h"
 #include "common/zstd_compression.h"
 
 namespace Common::Compression {
@@ -48,4 +50,163 @@ std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed) {
     return decompressed;
 }
 
+struct ZSTDOutputStreamBuf::Impl {
+    explicit Impl(FileUtil::IOFile& file_)
+        : file(file_), context(ZSTD_createCCtx()), input(ZSTD_CStreamInSize()),
+          output(ZSTD_CStreamOutSize()) {}
+
+    ~Impl() {
+        ZSTD_freeCCtx(context);
+    }
+
+    /// Compresses `size` bytes and writes the compressed data produced so far to the file
+    bool Compress(const void* data, std::size_t size, ZSTD_EndDirective mode) {
+        ZSTD_inBuffer in{data, size, 0};
+        bool done;
+        do {
+            ZSTD_outBuffer out{output.data(), output.size(), 0};
+            const std::size_t remaining = ZSTD_compressStream2(context, &out, &in, mode);
+            if (ZSTD_isError(remaining) || file.WriteBytes(output.data(), out.pos) != out.pos) {
+                failed = true;
+                return false;
+            }
+            done = mode == ZSTD_e_end ? remaining == 0 : in.pos == in.size;
+        } while (!done);
+        return true;
+    }
+
+    FileUtil::IOFile& file;
+    ZSTD_CCtx* context;
+    std::vector<char> input;
+    std::vector<char> output;
+    bool failed = false;
+};
+
+ZSTDOutputStreamBuf::ZSTDOutputStreamBuf(FileUtil::IOFile& file, u32 num_threads)
+    : impl(std::make_unique<Impl>(file)) {
+    ZSTD_CCtx_setParameter(impl->context, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+    // This fails without changing anything if Zstandard was built without multithreading
+    ZSTD_CCtx_setParameter(impl->context, ZSTD_c_nbWorkers, static_cast<int>(num_threads));
+    setp(impl->input.data(), impl->input.data() + impl->input.size());
+}
+
+ZSTDOutputStreamBuf::~ZSTDOutputStreamBuf() = default;
+
+bool ZSTDOutputStreamBuf::Finish() {
+    if (impl->failed || !impl->Compress(pbase(), pptr() - pbase(), ZSTD_e_end)) {
+        return false;
+    }
+    setp(nullptr, nullptr);
+    return true;
+}
+
+ZSTDOutputStreamBuf::int_type ZSTDOutputStreamBuf::overflow(int_type ch) {
+    if (pbase() == nullptr || sync() != 0) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize ZSTDOutputStreamBuf::xsputn(const char_type* s, std::streamsize count) {
+    if (count < epptr() - pptr()) {
+        std::memcpy(pptr(), s, count);
+        pbump(static_cast<int>(count));
+        return count;
+    }
+    if (pbase() == nullptr || sync() != 0 ||
+        !impl->Compress(s, static_cast<std::size_t>(count), ZSTD_e_continue)) {
+        return 0;
+    }
+    return count;
+}
+
+int ZSTDOutputStreamBuf::sync() {
+    if (impl->failed || !impl->Compress(pbase(), pptr() - pbase(), ZSTD_e_continue)) {
+        return -1;
+    }
+    setp(impl->input.data(), impl->input.data() + impl->input.size());
+    return 0;
+}
+
+struct ZSTDInputStreamBuf::Impl {
+    explicit Impl(FileUtil::IOFile& file_)
+        : file(file_), context(ZSTD_createDCtx()), input(ZSTD_DStreamInSize()),
+          output(ZSTD_DStreamOutSize()) {}
+
+    ~Impl() {
+        ZSTD_freeDCtx(context);
+    }
+
+    /// Decompresses up to `size` bytes to `dest`, reading more from the file as needed
+    std::size_t Decompress(void* dest, std::size_t size) {
+        ZSTD_outBuffer out{dest, size, 0};
+        while (out.pos < out.size && !failed) {
+            // When the output was filled, the decoder may have more data without further input
+            if (in.pos == in.size && !output_full) {
+                in.size = file.ReadBytes(input.data(), input.size());
+                in.pos = 0;
+                if (in.size == 0) {
+                    break;
+                }
+            }
+            if (ZSTD_isError(ZSTD_decompressStream(context, &out, &in))) {
+                failed = true;
+            }
+            output_full = out.pos == out.size;
+        }
+        return out.pos;
+    }
+
+    FileUtil::IOFile& file;
+    ZSTD_DCtx* context;
+    std::vector<char> input;
+    std::vector<char> output;
+    ZSTD_inBuffer in{input.data(), 0, 0};
+    bool output_full = false;
+    bool failed = false;
+};
+
+ZSTDInputStreamBuf::ZSTDInputStreamBuf(FileUtil::IOFile& file)
+    : impl(std::make_unique<Impl>(file)) {}
+
+ZSTDInputStreamBuf::~ZSTDInputStreamBuf() = default;
+
+ZSTDInputStreamBuf::int_type ZSTDInputStreamBuf::underflow() {
+    if (gptr() == egptr()) {
+        const std::size_t size = impl->Decompress(impl->output.data(), impl->output.size());
+        if (size == 0) {
+            return traits_type::eof();
+        }
+        setg(impl->output.data(), impl->output.data(), impl->output.data() + size);
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize ZSTDInputStreamBuf::xsgetn(char_type* s, std::streamsize count) {
+    std::streamsize copied = 0;
+    while (copied < count) {
+        const std::streamsize remaining = count - copied;
+        if (gptr() == egptr() && remaining >= static_cast<std::streamsize>(impl->output.size())) {
+            const std::size_t size = impl->Decompress(s + copied, remaining);
+            copied += size;
+            if (size == 0) {
+                break;
+            }
+            continue;
+        }
+        if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+            break;
+        }
+        const auto size = std::min<std::streamsize>(egptr() - gptr(), remaining);
+        std::memcpy(s + copied, gptr(), size);
+        gbump(static_cast<int>(size));
+        copied += size;
+    }
+    return copied;
+}
+
 } // namespace Common::Compression
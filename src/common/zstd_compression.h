@@ -4,10 +4,16 @@
 
 #pragma once
 
+#include <memory>
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Common::Compression {
 
 /**
@@ -41,4 +47,55 @@ std::vector<u8> CompressDataZSTDDefault(const u8* source, std::size_t source_siz
  */
 std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed);
 
+/**
+ * Stream buffer which compresses the data written to it with Zstandard, with the default
+ * compression level, and writes the compressed data to a file as it goes. Large writes are
+ * compressed directly from the source, without being copied to the buffer first.
+ */
+class ZSTDOutputStreamBuf final : public std::streambuf {
+public:
+    /**
+     * @param file File the compressed data is written to, from its current position.
+     * @param num_threads Number of worker threads compressing the data in parallel. With 0, or if
+     * Zstandard was built without multithreading, the data is compressed on the calling thread.
+     */
+    ZSTDOutputStreamBuf(FileUtil::IOFile& file, u32 num_threads);
+    ~ZSTDOutputStreamBuf() override;
+
+    /**
+     * Compresses the remaining data and ends the compressed frame. Nothing can be written after.
+     *
+     * @return false if the data couldn't be compressed or written to the file.
+     */
+    bool Finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+    int sync() override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/**
+ * Stream buffer which reads data compressed with Zstandard from a file and decompresses it as it
+ * goes. Large reads are decompressed directly to the destination.
+ */
+class ZSTDInputStreamBuf final : public std::streambuf {
+public:
+    /// @param file File the compressed data is read from, from its current position to its end.
+    explicit ZSTDInputStreamBuf(FileUtil::IOFile& file);
+    ~ZSTDInputStreamBuf() override;
+
+protected:
+    int_type underflow() override;
+    std::streamsize xsgetn(char_type* s, std::streamsize count) override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
 } // namespace Common::Compression
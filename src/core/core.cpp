@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
@@ -41,6 +42,7 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind_buffer.h"
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
 #include "network/network.h"
@@ -135,10 +137,36 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        LOG_INFO(Core, "Begin rewind");
+        try {
+            if (System::Rewind()) {
+                LOG_INFO(Core, "Rewind completed");
+            } else {
+                LOG_INFO(Core, "No rewind snapshot to step back to");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    if (rewind_buffer && timing->GetGlobalTicks() >= next_rewind_snapshot_ticks) {
+        try {
+            TakeRewindSnapshot();
+        } catch (const std::exception& e) {
+            // The snapshots fail the same way every time, e.g. with LLE audio
+            LOG_ERROR(Core, "Error taking a rewind snapshot, disabling rewind: {}", e.what());
+            rewind_buffer.reset();
+        }
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -308,6 +336,12 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (Settings::values.enable_rewind) {
+        rewind_buffer = std::make_unique<RewindBuffer>(
+            static_cast<std::size_t>(std::max(Settings::values.rewind_buffer_size, 0)) * 1024 *
+            1024);
+        next_rewind_snapshot_ticks = 0;
+    }
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
 
     if (Settings::values.custom_textures) {
@@ -527,6 +561,12 @@ void System::Shutdown(bool is_deserializing) {
                                     perf_results.frametime * 1000.0);
         telemetry_session->AddField(Telemetry::FieldType::Performance, "Mean_Frametime_MS",
                                     perf_stats->GetMeanFrametime());
+        const auto& cache_counters = memory->GetRasterizerCacheCounters();
+        telemetry_session->AddField(Telemetry::FieldType::Performance,
+                                    "Shutdown_RasterizerCacheFlushes", cache_counters.flushes);
+        telemetry_session->AddField(Telemetry::FieldType::Performance,
+                                    "Shutdown_RasterizerCacheSkippedFlushes",
+                                    cache_counters.skipped_flushes);
     }
 
     // Shutdown emulation session
@@ -535,6 +575,7 @@ void System::Shutdown(bool is_deserializing) {
     if (!is_deserializing) {
         GDBStub::Shutdown();
         perf_stats.reset();
+        rewind_buffer.reset();
         cheat_engine.reset();
         app_loader.reset();
     }
@@ -591,9 +632,11 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         Init(*m_emu_window, *system_mode.first, *n3ds_mode.first, num_cores);
     }
 
-    // flush on save, don't flush on load
-    bool should_flush = !Archive::is_loading::value;
-    Memory::RasterizerClearAll(should_flush);
+    // flush on save, don't flush on load. Rewind snapshots flush the cache beforehand and keep it.
+    if (Archive::is_loading::value || !keep_rasterizer_cache) {
+        bool should_flush = !Archive::is_loading::value;
+        Memory::RasterizerClearAll(should_flush);
+    }
     ar&* timing.get();
     for (u32 i = 0; i < num_cores; i++) {
         ar&* cpu_cores[i].get();
@@ -612,6 +655,9 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         throw std::runtime_error("LLE audio not supported for save states");
     }
 
+    if (Archive::is_loading::value && restore_memory) {
+        restore_memory(*memory);
+    }
     ar&* memory.get();
     ar&* kernel.get();
     VideoCore::serialize(ar, file_version);
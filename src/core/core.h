@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -63,6 +64,7 @@ class RendererBase;
 
 namespace Core {
 
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -122,7 +124,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -136,6 +138,11 @@ public:
         SendSignal(Signal::Shutdown);
     }
 
+    /// Request stepping the emulation back to the latest rewind snapshot
+    void RequestRewind() {
+        SendSignal(Signal::Rewind);
+    }
+
     /**
      * Load an executable application.
      * @param emu_window Reference to the host-system window used for video output and keyboard
@@ -306,10 +313,29 @@ public:
         return registered_image_interface;
     }
 
+    /// Called from a background thread when a save state has been written, with the error
+    /// message if it failed or an empty string
+    using SaveStateCallback = std::function<void(u32 slot, const std::string& error)>;
+
+    void SetSaveStateCallback(SaveStateCallback callback) {
+        save_state_callback = std::move(callback);
+    }
+
+    /**
+     * Captures the state of the system, and writes it to a save state slot in the background.
+     * Loading a save state waits until the save states being written are done.
+     */
     void SaveState(u32 slot) const;
 
     void LoadState(u32 slot);
 
+    /**
+     * Steps the emulation back to the latest rewind snapshot, and removes it so that the next call
+     * steps further back.
+     * @returns false if there is no rewind snapshot
+     */
+    bool Rewind();
+
 private:
     /**
      * Initialize the emulated system.
@@ -324,6 +350,9 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Adds a snapshot of the system to the rewind buffer
+    void TakeRewindSnapshot();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -368,6 +397,20 @@ private:
     std::unique_ptr<Kernel::KernelSystem> kernel;
     std::unique_ptr<Timing> timing;
 
+    /// Restores the memory contents which aren't stored in the save state being loaded, once the
+    /// memory has been recreated
+    std::function<void(Memory::MemorySystem&)> restore_memory;
+
+    SaveStateCallback save_state_callback;
+
+    /// Snapshots the emulation can be stepped back to, null if rewinding is disabled
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+    /// Global ticks after which the next rewind snapshot is taken
+    s64 next_rewind_snapshot_ticks = 0;
+    /// Whether saving only flushes the rasterizer cache rather than clearing it, for the rewind
+    /// snapshots, which would otherwise make the renderer upload everything again each time
+    bool keep_rasterizer_cache = false;
+
 private:
     static System s_instance;
 
@@ -20,6 +20,162 @@ bool Timing::Event::operator<(const Timing::Event& right) const {
     return std::tie(time, fifo_order) < std::tie(right.time, right.fifo_order);
 }
 
+Timing::EventQueue::EventQueue() = default;
+
+Timing::EventQueue::~EventQueue() = default;
+
+void Timing::EventQueue::Push(const Event& event) {
+    Node* const node = AllocateNode();
+    node->event = event;
+    node->child = nullptr;
+    node->sibling = nullptr;
+    node->prev = nullptr;
+
+    const std::size_t index = event.type->index;
+    if (index >= type_lists.size()) {
+        type_lists.resize(index + 1);
+    }
+    node->type_prev = nullptr;
+    node->type_next = type_lists[index];
+    if (node->type_next) {
+        node->type_next->type_prev = node;
+    }
+    type_lists[index] = node;
+
+    root = root ? Meld(root, node) : node;
+}
+
+Timing::Event Timing::EventQueue::Pop() {
+    Event event = root->event;
+    Erase(root);
+    return event;
+}
+
+void Timing::EventQueue::Remove(const TimingEventType* type, u64 userdata) {
+    if (type->index >= type_lists.size()) {
+        return;
+    }
+    for (Node* node = type_lists[type->index]; node;) {
+        Node* const next = node->type_next;
+        if (node->event.userdata == userdata) {
+            Erase(node);
+        }
+        node = next;
+    }
+}
+
+void Timing::EventQueue::RemoveAll(const TimingEventType* type) {
+    if (type->index >= type_lists.size()) {
+        return;
+    }
+    while (type_lists[type->index]) {
+        Erase(type_lists[type->index]);
+    }
+}
+
+std::vector<Timing::Event> Timing::EventQueue::GetEvents() const {
+    std::vector<Event> events;
+    for (const Node* node : type_lists) {
+        for (; node; node = node->type_next) {
+            events.push_back(node->event);
+        }
+    }
+    std::sort(events.begin(), events.end());
+    return events;
+}
+
+void Timing::EventQueue::Clear() {
+    for (Node*& node : type_lists) {
+        for (; node; node = node->type_next) {
+            free_nodes.push_back(node);
+        }
+    }
+    root = nullptr;
+}
+
+Timing::EventQueue::Node* Timing::EventQueue::AllocateNode() {
+    if (free_nodes.empty()) {
+        return nodes.emplace_back(std::make_unique<Node>()).get();
+    }
+    Node* const node = free_nodes.back();
+    free_nodes.pop_back();
+    return node;
+}
+
+void Timing::EventQueue::Erase(Node* node) {
+    if (node == root) {
+        root = MergePairs(node->child);
+    } else {
+        // Cut the subtree of the node from the heap, and merge its children back
+        if (node->prev->child == node) {
+            node->prev->child = node->sibling;
+        } else {
+            node->prev->sibling = node->sibling;
+        }
+        if (node->sibling) {
+            node->sibling->prev = node->prev;
+        }
+        if (Node* const children = MergePairs(node->child)) {
+            root = Meld(root, children);
+        }
+    }
+
+    if (node->type_prev) {
+        node->type_prev->type_next = node->type_next;
+    } else {
+        type_lists[node->event.type->index] = node->type_next;
+    }
+    if (node->type_next) {
+        node->type_next->type_prev = node->type_prev;
+    }
+    free_nodes.push_back(node);
+}
+
+Timing::EventQueue::Node* Timing::EventQueue::Meld(Node* a, Node* b) {
+    if (b->event < a->event) {
+        std::swap(a, b);
+    }
+    // b becomes the leftmost child of a
+    b->prev = a;
+    b->sibling = a->child;
+    if (a->child) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    a->sibling = nullptr;
+    a->prev = nullptr;
+    return a;
+}
+
+Timing::EventQueue::Node* Timing::EventQueue::MergePairs(Node* first) {
+    if (!first) {
+        return nullptr;
+    }
+
+    // Meld the subtrees in pairs from left to right, keeping the results in reverse order
+    Node* pairs = nullptr;
+    while (first) {
+        Node* const a = first;
+        Node* const b = a->sibling;
+        first = b ? b->sibling : nullptr;
+        Node* const melded = b ? Meld(a, b) : a;
+        melded->prev = nullptr;
+        melded->sibling = pairs;
+        pairs = melded;
+    }
+
+    // Then meld the results from right to left
+    Node* result = pairs;
+    for (Node* next = pairs->sibling; next;) {
+        Node* const node = next;
+        next = node->sibling;
+        result = Meld(result, node);
+    }
+    result->sibling = nullptr;
+    result->prev = nullptr;
+    return result;
+}
+
 Timing::Timing(std::size_t num_cores, u32 cpu_clock_percentage) {
     timers.resize(num_cores);
     for (std::size_t i = 0; i < num_cores; ++i) {
@@ -41,6 +197,9 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
     auto info = event_types.emplace(name, TimingEventType{});
     TimingEventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
+    if (info.second) {
+        event_type->index = event_types.size() - 1;
+    }
     if (callback != nullptr) {
         event_type->callback = callback;
     }
@@ -64,9 +223,7 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, userdata, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->event_queue.Push(Event{timeout, timer->event_fifo_id++, userdata, event_type});
     } else {
         timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
                                    userdata, event_type});
@@ -75,29 +232,14 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
     for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+        timer->event_queue.Remove(event_type, userdata);
     }
     // TODO:remove events from ts_queue
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
     for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+        timer->event_queue.RemoveAll(event_type);
     }
     // TODO:remove events from ts_queue
 }
@@ -159,16 +301,15 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 void Timing::Timer::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        event_queue.Push(ev);
     }
 }
 
 s64 Timing::Timer::GetMaxSliceLength() const {
-    const auto& next_event = event_queue.begin();
-    if (next_event != event_queue.end()) {
-        ASSERT(next_event->time - executed_ticks > 0);
-        return next_event->time - executed_ticks;
+    if (!event_queue.IsEmpty()) {
+        const Event& next_event = event_queue.Top();
+        ASSERT(next_event.time - executed_ticks > 0);
+        return next_event.time - executed_ticks;
     }
     return MAX_SLICE_LENGTH;
 }
@@ -184,10 +325,8 @@ void Timing::Timer::Advance() {
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.IsEmpty() && event_queue.Top().time <= executed_ticks) {
+        Event evt = event_queue.Pop();
         if (evt.type->callback != nullptr) {
             evt.type->callback(evt.userdata, executed_ticks - evt.time);
         } else {
@@ -202,9 +341,9 @@ void Timing::Timer::SetNextSlice(s64 max_slice_length) {
     slice_length = max_slice_length;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_queue.IsEmpty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+            std::min<s64>(event_queue.Top().time - executed_ticks, max_slice_length));
     }
 
     downcount = slice_length;
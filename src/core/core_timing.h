@@ -20,6 +20,7 @@
 #include <chrono>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -133,6 +134,8 @@ using TimedCallback = std::function<void(u64 userdata, int cycles_late)>;
 struct TimingEventType {
     TimedCallback callback;
     const std::string* name;
+    /// Index of the type in the order the types were registered
+    std::size_t index;
 };
 
 class Timing {
@@ -171,6 +174,73 @@ public:
         BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
+    /**
+     * Queue of the events scheduled on a timer, ordered by time, and then by the order they were
+     * added in. It is a pairing heap: adding an event takes constant time, and removing the next
+     * event or an arbitrary one takes amortized logarithmic time. The events of each type are
+     * also linked together, so that they are found without going through the whole queue.
+     */
+    class EventQueue {
+    public:
+        EventQueue();
+        ~EventQueue();
+
+        EventQueue(const EventQueue&) = delete;
+        EventQueue& operator=(const EventQueue&) = delete;
+
+        bool IsEmpty() const {
+            return root == nullptr;
+        }
+
+        /// Returns the next event. The queue must not be empty.
+        const Event& Top() const {
+            return root->event;
+        }
+
+        void Push(const Event& event);
+
+        /// Removes the next event and returns it. The queue must not be empty.
+        Event Pop();
+
+        /// Removes the events of the given type with the given userdata
+        void Remove(const TimingEventType* type, u64 userdata);
+
+        /// Removes all the events of the given type
+        void RemoveAll(const TimingEventType* type);
+
+        /// Returns all the events, in order
+        std::vector<Event> GetEvents() const;
+
+        void Clear();
+
+    private:
+        struct Node {
+            Event event;
+            /// Leftmost child in the heap
+            Node* child;
+            /// Next sibling to the right in the heap
+            Node* sibling;
+            /// Previous sibling in the heap, or parent if this is the leftmost child
+            Node* prev;
+            /// Neighbours in the list of the events of the same type
+            Node* type_prev;
+            Node* type_next;
+        };
+
+        Node* AllocateNode();
+        void Erase(Node* node);
+
+        static Node* Meld(Node* a, Node* b);
+        static Node* MergePairs(Node* first);
+
+        Node* root = nullptr;
+        /// First node of the list of the events of each type, indexed by TimingEventType::index
+        std::vector<Node*> type_lists;
+
+        std::vector<std::unique_ptr<Node>> nodes;
+        std::vector<Node*> free_nodes;
+    };
+
     // currently Service::HID::pad_update_ticks is the smallest interval for an event that gets
     // always scheduled. Therfore we use this as orientation for the MAX_SLICE_LENGTH
     // For performance bigger slice length are desired, though this will lead to cores desync
@@ -205,11 +275,7 @@ public:
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-        // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accomodated by the standard adaptor class.
-        std::vector<Event> event_queue;
+        EventQueue event_queue;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
         // to the event_queue by the emu thread
@@ -238,7 +304,18 @@ public:
             // TODO(SaveState): Remove the next two lines when we break compatibility
             s64 x;
             ar& x; // to keep compatibility with old save states that stored global_timer
-            ar& event_queue;
+            // The events are stored in order, which is also a valid heap for older versions
+            std::vector<Event> events;
+            if (Archive::is_saving::value) {
+                events = event_queue.GetEvents();
+            }
+            ar& events;
+            if (Archive::is_loading::value) {
+                event_queue.Clear();
+                for (const Event& event : events) {
+                    event_queue.Push(event);
+                }
+            }
             ar& event_fifo_id;
             ar& slice_length;
             ar& downcount;
@@ -42,6 +42,12 @@ union Header {
     BitField<16, 16, u32> command_id;
 };
 
+/// Returns the size of the command described by a header, header included, in 32-bit words.
+inline std::size_t GetCommandSize(u32 header_raw) {
+    const Header header{header_raw};
+    return 1u + header.normal_params_size + header.translate_params_size;
+}
+
 /**
  * @brief Creates a command header to be used for IPC
  * @param command_id            ID of the command to create a header for.
@@ -13,6 +13,7 @@
 #include "core/hle/kernel/ipc_debugger/recorder.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/memory.h"
 
 namespace Kernel {
 
@@ -40,7 +41,7 @@ public:
         context->WriteToOutgoingCommandBuffer(cmd_buff.data(), *process);
         // Copy the translated command buffer back into the thread's command buffer area.
         memory.WriteBlock(*process, thread->GetCommandBufferAddress(), cmd_buff.data(),
-                          cmd_buff.size() * sizeof(u32));
+                          IPC::GetCommandSize(cmd_buff[0]) * sizeof(u32));
     }
 
 private:
@@ -314,6 +315,13 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     memory->WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+std::vector<Memory::HostSpan> MappedBuffer::GetSpans(std::size_t offset, std::size_t size,
+                                                     bool write) {
+    ASSERT(perms & (write ? IPC::W : IPC::R));
+    ASSERT(offset + size <= this->size);
+    return memory->GetContiguousSpans(*process, address + static_cast<VAddr>(offset), size, write);
+}
+
 } // namespace Kernel
 
 SERIALIZE_EXPORT_IMPL(Kernel::HLERequestContext::ThreadCallback)
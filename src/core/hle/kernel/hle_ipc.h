@@ -28,6 +28,7 @@ class ServiceFrameworkBase;
 
 namespace Memory {
 class MemorySystem;
+struct HostSpan;
 }
 
 namespace Kernel {
@@ -132,6 +133,15 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+
+    /**
+     * Gets the host memory backing a part of the buffer, so that it is accessed without copying.
+     * @param write Whether the part is written to, rather than read from
+     * @returns the spans covering the part in order, or an empty list if the buffer isn't entirely
+     * backed by memory, in which case Read and Write must be used instead
+     */
+    std::vector<Memory::HostSpan> GetSpans(std::size_t offset, std::size_t size, bool write);
+
     std::size_t GetSize() const {
         return size;
     }
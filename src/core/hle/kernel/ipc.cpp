@@ -37,11 +37,18 @@ ResultCode TranslateCommandBuffer(Kernel::KernelSystem& kernel, Memory::MemorySy
     // Note: The real kernel does not check that the command length fits into the IPC buffer area.
     ASSERT(command_size <= IPC::COMMAND_BUFFER_LENGTH);
 
+    const bool should_record = kernel.GetIPCRecorder().IsEnabled();
+
+    // Commands without handles or buffers are passed as they are, so copy them directly
+    if (header.translate_params_size == 0 && !should_record) {
+        memory.CopyBlock(*dst_process, *src_process, dst_address, src_address,
+                         command_size * sizeof(u32));
+        return RESULT_SUCCESS;
+    }
+
     std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
     memory.ReadBlock(*src_process, src_address, cmd_buf.data(), command_size * sizeof(u32));
 
-    const bool should_record = kernel.GetIPCRecorder().IsEnabled();
-
     std::vector<u32> untranslated_cmdbuf;
     if (should_record) {
         untranslated_cmdbuf = std::vector<u32>{cmd_buf.begin(), cmd_buf.begin() + command_size};
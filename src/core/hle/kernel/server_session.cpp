@@ -102,8 +102,9 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
         // wakeup callback.
         if (thread->status == Kernel::ThreadStatus::Running) {
             context->WriteToOutgoingCommandBuffer(cmd_buf.data(), *current_process);
+            // Only the reply is written back, the static buffers area is left as it is
             kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
-                                     cmd_buf.data(), cmd_buf.size() * sizeof(u32));
+                                     cmd_buf.data(), IPC::GetCommandSize(cmd_buf[0]) * sizeof(u32));
         }
     }
 
@@ -337,7 +337,6 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(
     auto thread{std::make_shared<Thread>(*this, processor_id)};
 
     thread_managers[processor_id]->thread_list.push_back(thread);
-    thread_managers[processor_id]->ready_queue.prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = ThreadStatus::Dormant;
@@ -406,8 +405,6 @@ void Thread::SetPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
 
     nominal_priority = current_priority = priority;
 }
@@ -425,8 +422,6 @@ void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
     current_priority = priority;
 }
 
@@ -147,7 +147,7 @@ private:
     ARM_Interface* cpu;
 
     std::shared_ptr<Thread> current_thread;
-    Common::ThreadQueueList<Thread*, ThreadPrioLowest + 1> ready_queue;
+    Common::ThreadQueueList<Thread, ThreadPrioLowest + 1> ready_queue;
     std::unordered_map<u64, Thread*> wakeup_callback_table;
 
     /// Event type for the thread wake up event
@@ -325,6 +325,9 @@ public:
 
     const u32 core_id;
 
+    /// Links of the thread in the ready queue of its thread manager
+    Common::ThreadQueueHook<Thread> queue_hook;
+
 private:
     ThreadManager& thread_manager;
 
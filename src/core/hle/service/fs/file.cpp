@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <boost/serialization/unique_ptr.hpp>
 #include "common/archives.h"
 #include "common/logging/log.h"
@@ -14,6 +15,7 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/service/fs/file.h"
+#include "core/memory.h"
 
 SERIALIZE_EXPORT_IMPL(Service::FS::File)
 SERIALIZE_EXPORT_IMPL(Service::FS::FileSessionSlot)
@@ -78,15 +80,41 @@ void File::Read(Kernel::HLERequestContext& ctx) {
 
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
+    // The file is read directly to the memory of the buffer. An intermediate buffer is only used
+    // when the buffer isn't entirely backed by memory. Reads past the end of the buffer are
+    // truncated, the end of the file usually comes before it.
+    const std::size_t buffer_length = std::min<std::size_t>(length, buffer.GetSize());
+    std::vector<u8> data;
+    std::vector<Memory::HostSpan> spans = buffer.GetSpans(0, buffer_length, true);
+    if (spans.empty()) {
+        data.resize(buffer_length);
+        spans.push_back({data.data(), data.size()});
+    }
+
+    ResultCode result = RESULT_SUCCESS;
+    std::size_t read = 0;
+    for (const auto& span : spans) {
+        const ResultVal<std::size_t> span_read =
+            backend->Read(offset + read, span.size, span.pointer);
+        if (span_read.Failed()) {
+            result = span_read.Code();
+            break;
+        }
+        read += *span_read;
+        if (*span_read < span.size) {
+            break;
+        }
+    }
+
+    if (result.IsError()) {
+        rb.Push(result);
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
+        if (!data.empty()) {
+            buffer.Write(data.data(), 0, read);
+        }
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*read));
+        rb.Push<u32>(static_cast<u32>(read));
     }
     rb.PushMappedBuffer(buffer);
 
@@ -115,19 +143,47 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    // The file is written directly from the memory of the buffer. An intermediate buffer is only
+    // used when the buffer isn't entirely backed by memory.
+    std::vector<u8> data;
+    std::vector<Memory::HostSpan> spans = buffer.GetSpans(0, length, false);
+    if (spans.empty()) {
+        data.resize(length);
+        if (length != 0) {
+            buffer.Read(data.data(), 0, data.size());
+        }
+        spans.push_back({data.data(), data.size()});
+    }
+
+    ResultCode result = RESULT_SUCCESS;
+    std::size_t written = 0;
+    for (const auto& span : spans) {
+        const ResultVal<std::size_t> span_written =
+            backend->Write(offset + written, span.size, false, span.pointer);
+        if (span_written.Failed()) {
+            result = span_written.Code();
+            break;
+        }
+        written += *span_written;
+        if (*span_written < span.size) {
+            break;
+        }
+    }
+
+    // Flushed once, even if a part failed or was written short
+    if (flush != 0) {
+        backend->Flush();
+    }
 
     // Update file size
     file->size = backend->GetSize();
 
-    if (written.Failed()) {
-        rb.Push(written.Code());
+    if (result.IsError()) {
+        rb.Push(result);
         rb.Push<u32>(0);
     } else {
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(static_cast<u32>(*written));
+        rb.Push<u32>(static_cast<u32>(written));
     }
     rb.PushMappedBuffer(buffer);
 }
@@ -14,7 +14,10 @@ static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
     auto gpu = gsp_gpu.lock();
-    ASSERT(gpu != nullptr);
+    if (gpu == nullptr) {
+        // The GPU can run without any emulated system, e.g. when replaying a CiTrace
+        return;
+    }
     return gpu->SignalInterruptThreadSafe(interrupt_id);
 }
 
@@ -6,6 +6,7 @@
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
@@ -120,6 +121,34 @@ const std::array<ServiceModuleInfo, 40> service_module_map{
     return function_string;
 }
 
+#if MICROPROFILE_ENABLED
+MICROPROFILE_DEFINE(Service_OtherCommands, "Service", "Other commands", MP_RGB(128, 128, 192));
+
+/// Maximum number of commands timed separately, which leaves most of the MicroProfile timers to
+/// the rest of the emulator
+constexpr std::size_t MaxProfiledCommands = 512;
+
+/// Returns the token the calls of a command are timed with, named after the service and function
+static MicroProfileToken GetCommandProfileToken(const std::string& service_name,
+                                                const char* function_name) {
+    static std::size_t profiled_commands = 0;
+
+    std::string name = fmt::format("{}::{}", service_name, function_name);
+    // MicroProfile truncates the names, so they wouldn't be found again otherwise
+    name.resize(std::min<std::size_t>(name.size(), MICROPROFILE_NAME_MAX_LEN - 1));
+
+    const MicroProfileToken token = MicroProfileFindToken("Service", name.c_str());
+    if (token != MICROPROFILE_INVALID_TOKEN) {
+        return token;
+    }
+    if (profiled_commands == MaxProfiledCommands) {
+        return MICROPROFILE_TOKEN(Service_OtherCommands);
+    }
+    ++profiled_commands;
+    return MicroProfileGetToken("Service", name.c_str(), MP_RGB(128, 128, 192));
+}
+#endif
+
 ServiceFrameworkBase::ServiceFrameworkBase(const char* service_name, u32 max_sessions,
                                            InvokerFn* handler_invoker)
     : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {}
@@ -138,10 +167,16 @@ void ServiceFrameworkBase::InstallAsNamedPort(Kernel::KernelSystem& kernel) {
 }
 
 void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* functions, std::size_t n) {
-    handlers.reserve(handlers.size() + n);
     for (std::size_t i = 0; i < n; ++i) {
-        // Usually this array is sorted by id already, so hint to insert at the end
-        handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
+        const std::size_t command_id = IPC::Header{functions[i].expected_header}.command_id;
+        const std::size_t page = command_id / HANDLER_PAGE_SIZE;
+        if (page >= handler_pages.size()) {
+            handler_pages.resize(page + 1);
+        }
+        if (!handler_pages[page]) {
+            handler_pages[page] = std::make_unique<HandlerPage>();
+        }
+        (*handler_pages[page])[command_id % HANDLER_PAGE_SIZE].info = functions[i];
     }
 }
 
@@ -166,10 +201,24 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const Funct
     cmd_buf[1] = 0;
 }
 
+const ServiceFrameworkBase::HandlerEntry* ServiceFrameworkBase::FindHandler(u32 header) const {
+    const std::size_t command_id = IPC::Header{header}.command_id;
+    const std::size_t page = command_id / HANDLER_PAGE_SIZE;
+    if (page >= handler_pages.size() || !handler_pages[page]) {
+        return nullptr;
+    }
+    // The parameter sizes of the request must match the ones of the function too
+    const HandlerEntry& entry = (*handler_pages[page])[command_id % HANDLER_PAGE_SIZE];
+    if (entry.info.name == nullptr || entry.info.expected_header != header) {
+        return nullptr;
+    }
+    return &entry;
+}
+
 void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context) {
     u32 header_code = context.CommandBuffer()[0];
-    auto itr = handlers.find(header_code);
-    const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
+    const HandlerEntry* entry = FindHandler(header_code);
+    const FunctionInfoBase* info = entry == nullptr ? nullptr : &entry->info;
     if (info == nullptr || info->handler_callback == nullptr) {
         context.ReportUnimplemented();
         return ReportUnimplementedFunction(context.CommandBuffer(), info);
@@ -177,15 +226,23 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+
+#if MICROPROFILE_ENABLED
+    if (entry->profile_token == 0) {
+        entry->profile_token = GetCommandProfileToken(service_name, info->name);
+    }
+#endif
+    MICROPROFILE_SCOPE_TOKEN(entry->profile_token);
     handler_invoker(this, info->handler_callback, context);
 }
 
 std::string ServiceFrameworkBase::GetFunctionName(u32 header) const {
-    if (!handlers.count(header)) {
+    const HandlerEntry* entry = FindHandler(header);
+    if (entry == nullptr) {
         return "";
     }
 
-    return handlers.at(header).name;
+    return entry->info.name;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
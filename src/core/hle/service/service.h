@@ -9,11 +9,12 @@
 #include <functional>
 #include <memory>
 #include <string>
-#include <boost/container/flat_map.hpp>
+#include <vector>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include "common/common_types.h"
 #include "common/construct.h"
+#include "common/microprofile.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/service/sm/sm.h"
@@ -85,6 +86,14 @@ private:
         const char* name;
     };
 
+    /// Handler registered for a command ID, along with the token its calls are profiled with
+    struct HandlerEntry {
+        /// Function of the command, whose name is null if no function has this command ID
+        FunctionInfoBase info{};
+        /// Token created on the first call of the command, 0 before that
+        mutable MicroProfileToken profile_token = 0;
+    };
+
     using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
                            Kernel::HLERequestContext& ctx);
 
@@ -94,6 +103,8 @@ private:
 
     void RegisterHandlersBase(const FunctionInfoBase* functions, std::size_t n);
     void ReportUnimplementedFunction(u32* cmd_buf, const FunctionInfoBase* info);
+    /// Returns the handler of the function matching a request header, or nullptr if there is none
+    const HandlerEntry* FindHandler(u32 header) const;
 
     /// Identifier string used to connect to the service.
     std::string service_name;
@@ -102,7 +113,13 @@ private:
 
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
-    boost::container::flat_map<u32, FunctionInfoBase> handlers;
+    /// Number of command IDs in a page of the handler table
+    static constexpr std::size_t HANDLER_PAGE_SIZE = 64;
+    using HandlerPage = std::array<HandlerEntry, HANDLER_PAGE_SIZE>;
+    /// Handlers indexed by the command ID of their header. The table is split in pages, which are
+    /// only allocated if a function is registered in them, as some services have a few functions
+    /// with high command IDs.
+    std::vector<std::unique_ptr<HandlerPage>> handler_pages;
 };
 
 /**
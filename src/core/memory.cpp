@@ -2,14 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <stdexcept>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
+#include <boost/serialization/version.hpp>
 #include "audio_core/dsp_interface.h"
 #include "common/archives.h"
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
@@ -38,45 +42,78 @@ void PageTable::Clear() {
 
 class RasterizerCacheMarker {
 public:
+    /// Marks the block of RASTERIZER_CACHE_BLOCK_SIZE bytes containing the address
     void Mark(VAddr addr, bool cached) {
         bool* p = At(addr);
         if (p)
             *p = cached;
     }
 
-    bool IsCached(VAddr addr) {
-        bool* p = At(addr);
+    /// Returns whether any block of the page containing the address is cached
+    bool IsPageCached(VAddr addr) {
+        const bool* p = At(addr & ~PAGE_MASK);
         if (p)
-            return *p;
+            return std::find(p, p + BLOCKS_PER_PAGE, true) != p + BLOCKS_PER_PAGE;
         return false;
     }
 
+    /// Returns whether any block touching the region is cached
+    bool IsRegionCached(VAddr addr, u32 size) {
+        const VAddr last_block = (addr + size - 1) & ~RASTERIZER_CACHE_BLOCK_MASK;
+        for (VAddr block = addr & ~RASTERIZER_CACHE_BLOCK_MASK;;
+             block += RASTERIZER_CACHE_BLOCK_SIZE) {
+            const bool* p = At(block);
+            if (p && *p)
+                return true;
+            if (block == last_block)
+                return false;
+        }
+    }
+
 private:
+    static constexpr std::size_t BLOCKS_PER_PAGE = PAGE_SIZE / RASTERIZER_CACHE_BLOCK_SIZE;
+
     bool* At(VAddr addr) {
         if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
-            return &vram[(addr - VRAM_VADDR) / PAGE_SIZE];
+            return &vram[(addr - VRAM_VADDR) / RASTERIZER_CACHE_BLOCK_SIZE];
         }
         if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
-            return &linear_heap[(addr - LINEAR_HEAP_VADDR) / PAGE_SIZE];
+            return &linear_heap[(addr - LINEAR_HEAP_VADDR) / RASTERIZER_CACHE_BLOCK_SIZE];
         }
         if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
-            return &new_linear_heap[(addr - NEW_LINEAR_HEAP_VADDR) / PAGE_SIZE];
+            return &new_linear_heap[(addr - NEW_LINEAR_HEAP_VADDR) / RASTERIZER_CACHE_BLOCK_SIZE];
         }
         return nullptr;
     }
 
-    std::array<bool, VRAM_SIZE / PAGE_SIZE> vram{};
-    std::array<bool, LINEAR_HEAP_SIZE / PAGE_SIZE> linear_heap{};
-    std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
+    std::array<bool, VRAM_SIZE / RASTERIZER_CACHE_BLOCK_SIZE> vram{};
+    std::array<bool, LINEAR_HEAP_SIZE / RASTERIZER_CACHE_BLOCK_SIZE> linear_heap{};
+    std::array<bool, NEW_LINEAR_HEAP_SIZE / RASTERIZER_CACHE_BLOCK_SIZE> new_linear_heap{};
 
     static_assert(sizeof(bool) == 1);
     friend class boost::serialization::access;
     template <typename Archive>
     void serialize(Archive& ar, const unsigned int file_version) {
+        if (file_version == 0) {
+            // Savestates from before version 1 mark whole pages
+            LoadPageMarks(ar, vram);
+            LoadPageMarks(ar, linear_heap);
+            LoadPageMarks(ar, new_linear_heap);
+            return;
+        }
         ar& vram;
         ar& linear_heap;
         ar& new_linear_heap;
     }
+
+    template <typename Archive, std::size_t N>
+    static void LoadPageMarks(Archive& ar, std::array<bool, N>& blocks) {
+        std::array<bool, N / BLOCKS_PER_PAGE> pages{};
+        ar& pages;
+        for (std::size_t block = 0; block < N; ++block) {
+            blocks[block] = pages[block / BLOCKS_PER_PAGE];
+        }
+    }
 };
 
 class MemorySystem::Impl {
@@ -89,6 +126,7 @@ public:
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
+    RasterizerCacheCounters rasterizer_cache_counters;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
     AudioCore::DspInterface* dsp = nullptr;
@@ -145,17 +183,129 @@ public:
         }
     }
 
+    /// ID of the base of incremental savestates, 0 if savestates store the whole memory
+    u64 savestate_base_id = 0;
+    /// Hashes of the pages of the base of incremental savestates
+    std::vector<u64> savestate_base_hashes;
+    /// Whether savestates store the contents of VRAM, FCRAM and the N3DS extra RAM
+    bool savestate_memory_stored = true;
+
+    // The pages stored in savestates are numbered across VRAM, FCRAM and the N3DS extra RAM, in
+    // that order. The pages stored for the Old 3DS are the first ones of those for the New 3DS.
+    static constexpr std::size_t SAVESTATE_VRAM_PAGES = VRAM_SIZE / PAGE_SIZE;
+    static constexpr std::size_t SAVESTATE_FCRAM_PAGES = FCRAM_N3DS_SIZE / PAGE_SIZE;
+
+    static std::size_t GetSaveStatePageCount(bool save_n3ds_ram) {
+        return save_n3ds_ram ? (VRAM_SIZE + FCRAM_N3DS_SIZE + N3DS_EXTRA_RAM_SIZE) / PAGE_SIZE
+                             : (VRAM_SIZE + FCRAM_SIZE) / PAGE_SIZE;
+    }
+
+    u8* GetSaveStatePage(std::size_t page) const {
+        if (page < SAVESTATE_VRAM_PAGES) {
+            return vram.get() + page * PAGE_SIZE;
+        }
+        page -= SAVESTATE_VRAM_PAGES;
+        if (page < SAVESTATE_FCRAM_PAGES) {
+            return fcram.get() + page * PAGE_SIZE;
+        }
+        page -= SAVESTATE_FCRAM_PAGES;
+        return n3ds_extra_ram.get() + page * PAGE_SIZE;
+    }
+
+    /// Returns the regions stored in savestates, in order, and their size
+    std::array<std::pair<u8*, std::size_t>, 3> GetSaveStateRegions(bool save_n3ds_ram) const {
+        return {{{vram.get(), VRAM_SIZE},
+                 {fcram.get(), save_n3ds_ram ? FCRAM_N3DS_SIZE : FCRAM_SIZE},
+                 {n3ds_extra_ram.get(), save_n3ds_ram ? N3DS_EXTRA_RAM_SIZE : 0}}};
+    }
+
+    /**
+     * Makes a snapshot written by CreateSaveStateBase the base of incremental savestates. The
+     * snapshot is read directly to the memory if `restore` is true.
+     */
+    void ReadSaveStateBase(u64 id, std::streambuf& snapshot, bool restore) {
+        ASSERT(id != 0);
+        savestate_base_id = id;
+        savestate_base_hashes.clear();
+
+        // The snapshot ends early if it was created for the Old 3DS
+        std::vector<u8> buffer(restore ? 0 : 0x100000);
+        for (const auto& [data, size] : GetSaveStateRegions(true)) {
+            for (std::size_t offset = 0; offset < size;) {
+                u8* const dest = restore ? data + offset : buffer.data();
+                const std::size_t count =
+                    restore ? size - offset : std::min(buffer.size(), size - offset);
+                const auto read = static_cast<std::size_t>(
+                    snapshot.sgetn(reinterpret_cast<char*>(dest), count));
+                for (std::size_t page = 0; page < read / PAGE_SIZE; ++page) {
+                    savestate_base_hashes.push_back(
+                        Common::ComputeHash64(dest + page * PAGE_SIZE, PAGE_SIZE));
+                }
+                if (read < count) {
+                    return;
+                }
+                offset += count;
+            }
+        }
+    }
+
+    /// Returns the pages which differ from the base of incremental savestates
+    std::vector<u32> GetChangedSaveStatePages(bool save_n3ds_ram) const {
+        std::vector<u32> pages;
+        const std::size_t num_pages = GetSaveStatePageCount(save_n3ds_ram);
+        for (std::size_t page = 0; page < num_pages; ++page) {
+            if (page >= savestate_base_hashes.size() ||
+                Common::ComputeHash64(GetSaveStatePage(page), PAGE_SIZE) !=
+                    savestate_base_hashes[page]) {
+                pages.push_back(static_cast<u32>(page));
+            }
+        }
+        return pages;
+    }
+
 private:
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds;
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+
+        // Rewind snapshots keep the memory pages separately, and restore them before they are
+        // loaded. Incremental savestates only store the pages which changed since their base,
+        // which must be restored before they are loaded too.
+        bool memory_stored = savestate_memory_stored;
+        u64 base_id = memory_stored ? savestate_base_id : 0;
+        if (file_version > 0) {
+            ar& memory_stored;
+            ar& base_id;
+        } else {
+            // Savestates from before version 1 always contain the whole memory
+            memory_stored = true;
+        }
+        if (memory_stored && base_id == 0) {
+            ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        } else if (memory_stored) {
+            if (Archive::is_loading::value && base_id != savestate_base_id) {
+                throw std::runtime_error("The base of the incremental savestate isn't loaded");
+            }
+            std::vector<u32> changed_pages;
+            if (Archive::is_saving::value) {
+                changed_pages = GetChangedSaveStatePages(save_n3ds_ram);
+            }
+            ar& changed_pages;
+            const std::size_t num_pages = GetSaveStatePageCount(save_n3ds_ram);
+            for (const u32 page : changed_pages) {
+                if (page >= num_pages) {
+                    throw std::runtime_error("Invalid page in the incremental savestate");
+                }
+                ar& boost::serialization::make_binary_object(GetSaveStatePage(page), PAGE_SIZE);
+            }
+        }
+
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -167,6 +317,15 @@ private:
     }
 };
 
+} // namespace Memory
+
+// Version 1 stores whether the memory is included, and the base of incremental savestates
+BOOST_CLASS_VERSION(Memory::MemorySystem::Impl, 1)
+// Version 1 marks blocks of RASTERIZER_CACHE_BLOCK_SIZE bytes rather than pages
+BOOST_CLASS_VERSION(Memory::RasterizerCacheMarker, 1)
+
+namespace Memory {
+
 // We use this rather than BufferMem because we don't want new objects to be allocated when
 // deserializing. This avoids unnecessary memory thrashing.
 template <Region R>
@@ -206,6 +365,12 @@ MemorySystem::~MemorySystem() = default;
 template <class Archive>
 void MemorySystem::serialize(Archive& ar, const unsigned int file_version) {
     ar&* impl.get();
+    if (Archive::is_loading::value) {
+        // The rasterizer cache is recreated empty by the loading, while rewind snapshots are taken
+        // without clearing it, so the blocks they mark as cached are uncached again
+        RasterizerMarkRegionCached(VRAM_PADDR, VRAM_SIZE, false);
+        RasterizerMarkRegionCached(FCRAM_PADDR, FCRAM_N3DS_SIZE, false);
+    }
 }
 
 SERIALIZE_IMPL(MemorySystem)
@@ -234,7 +399,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         page_table.pointers[base] = memory;
 
         // If the memory to map is already rasterizer-cached, mark the page
-        if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
+        if (type == PageType::Memory && impl->cache_marker.IsPageCached(base * PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
         }
@@ -279,6 +444,19 @@ MemoryRef MemorySystem::GetPointerForRasterizerCache(VAddr addr) const {
     UNREACHABLE();
 }
 
+void MemorySystem::RasterizerFlushCachedRegion(VAddr start, u32 size, FlushMode mode) {
+    if (impl->cache_marker.IsRegionCached(start, size)) {
+        ++impl->rasterizer_cache_counters.flushes;
+        RasterizerFlushVirtualRegion(start, size, mode);
+    } else {
+        ++impl->rasterizer_cache_counters.skipped_flushes;
+    }
+}
+
+const MemorySystem::RasterizerCacheCounters& MemorySystem::GetRasterizerCacheCounters() const {
+    return impl->rasterizer_cache_counters;
+}
+
 void MemorySystem::RegisterPageTable(std::shared_ptr<PageTable> page_table) {
     impl->page_table_list.push_back(page_table);
 }
@@ -326,7 +504,7 @@ T MemorySystem::Read(const VAddr vaddr) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
+        RasterizerFlushCachedRegion(vaddr, sizeof(T), FlushMode::Flush);
 
         T value;
         std::memcpy(&value, GetPointerForRasterizerCache(vaddr), sizeof(T));
@@ -361,7 +539,7 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        RasterizerFlushCachedRegion(vaddr, sizeof(T), FlushMode::Invalidate);
         std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
         break;
     }
@@ -429,6 +607,52 @@ const u8* MemorySystem::GetPointer(const VAddr vaddr) const {
     return nullptr;
 }
 
+std::vector<HostSpan> MemorySystem::GetContiguousSpans(const Kernel::Process& process,
+                                                       const VAddr vaddr, const std::size_t size,
+                                                       bool write) {
+    auto& page_table = *process.vm_manager.page_table;
+
+    std::vector<HostSpan> spans;
+    std::size_t remaining_size = size;
+    std::size_t page_index = vaddr >> PAGE_BITS;
+    std::size_t page_offset = vaddr & PAGE_MASK;
+
+    while (remaining_size > 0) {
+        const std::size_t span_size =
+            std::min<std::size_t>(PAGE_SIZE - page_offset, remaining_size);
+        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+
+        u8* pointer;
+        switch (page_table.attributes[page_index]) {
+        case PageType::Memory:
+            DEBUG_ASSERT(page_table.pointers[page_index]);
+            pointer = page_table.pointers[page_index] + page_offset;
+            break;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushCachedRegion(current_vaddr, static_cast<u32>(span_size),
+                                        write ? FlushMode::FlushAndInvalidate : FlushMode::Flush);
+            pointer = GetPointerForRasterizerCache(current_vaddr);
+            break;
+        default:
+            LOG_ERROR(HW_Memory,
+                      "region without memory @ 0x{:08X} (start address = 0x{:08X}, size = {})",
+                      current_vaddr, vaddr, size);
+            return {};
+        }
+
+        if (!spans.empty() && spans.back().pointer + spans.back().size == pointer) {
+            spans.back().size += span_size;
+        } else {
+            spans.push_back({pointer, span_size});
+        }
+
+        page_index++;
+        page_offset = 0;
+        remaining_size -= span_size;
+    }
+    return spans;
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -529,12 +753,26 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
-    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
-    PAddr paddr = start;
+    const PAddr end = start + size;
+    u32 num_pages = ((end - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
+    PAddr paddr = start & ~PAGE_MASK;
 
     for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
+        // Blocks of the page touching the region
+        const PAddr blocks_start = std::max(paddr, start) & ~RASTERIZER_CACHE_BLOCK_MASK;
+        const PAddr blocks_end = std::min(paddr + PAGE_SIZE, end);
+
         for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
-            impl->cache_marker.Mark(vaddr, cached);
+            const bool was_cached = impl->cache_marker.IsPageCached(vaddr);
+            for (PAddr block = blocks_start; block < blocks_end;
+                 block += RASTERIZER_CACHE_BLOCK_SIZE) {
+                impl->cache_marker.Mark(vaddr + (block - paddr), cached);
+            }
+
+            // The page only changes type when its first block is cached or its last one uncached
+            if (impl->cache_marker.IsPageCached(vaddr) == was_cached) {
+                continue;
+            }
             for (auto page_table : impl->page_table_list) {
                 PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
 
@@ -610,6 +848,14 @@ void RasterizerClearAll(bool flush) {
     VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
 }
 
+void RasterizerFlushAll() {
+    if (VideoCore::g_renderer == nullptr) {
+        return;
+    }
+
+    VideoCore::g_renderer->Rasterizer()->FlushAll();
+}
+
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
@@ -699,8 +945,8 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            RasterizerFlushCachedRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                        FlushMode::Flush);
             std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
             break;
         }
@@ -764,8 +1010,8 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
+            RasterizerFlushCachedRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                        FlushMode::Invalidate);
             std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
             break;
         }
@@ -815,8 +1061,8 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
+            RasterizerFlushCachedRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                        FlushMode::Invalidate);
             std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
             break;
         }
@@ -871,8 +1117,8 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            RasterizerFlushCachedRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                        FlushMode::Flush);
             WriteBlock(dest_process, dest_addr, GetPointerForRasterizerCache(current_vaddr),
                        copy_amount);
             break;
@@ -949,6 +1195,58 @@ MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
     return MemoryRef(impl->fcram_mem, offset);
 }
 
+void MemorySystem::CreateSaveStateBase(u64 id, std::streambuf& snapshot) {
+    ASSERT(id != 0);
+    impl->savestate_base_id = id;
+    impl->savestate_base_hashes.clear();
+    for (const auto& [data, size] : impl->GetSaveStateRegions(Settings::values.is_new_3ds)) {
+        if (snapshot.sputn(reinterpret_cast<const char*>(data), size) !=
+            static_cast<std::streamsize>(size)) {
+            throw std::runtime_error("Could not write the memory snapshot");
+        }
+        for (std::size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+            impl->savestate_base_hashes.push_back(Common::ComputeHash64(data + offset, PAGE_SIZE));
+        }
+    }
+}
+
+void MemorySystem::SetSaveStateBase(u64 id, std::streambuf& snapshot) {
+    impl->ReadSaveStateBase(id, snapshot, false);
+}
+
+void MemorySystem::RestoreSaveStateBase(u64 id, std::streambuf& snapshot) {
+    impl->ReadSaveStateBase(id, snapshot, true);
+}
+
+void MemorySystem::ClearSaveStateBase() {
+    impl->savestate_base_id = 0;
+    impl->savestate_base_hashes = {};
+}
+
+u64 MemorySystem::GetSaveStateBaseId() const {
+    return impl->savestate_base_id;
+}
+
+std::size_t MemorySystem::GetChangedSaveStatePageCount() const {
+    if (impl->savestate_base_id == 0) {
+        return impl->GetSaveStatePageCount(Settings::values.is_new_3ds);
+    }
+    return impl->GetChangedSaveStatePages(Settings::values.is_new_3ds).size();
+}
+
+void MemorySystem::SetSaveStateMemoryStored(bool stored) {
+    impl->savestate_memory_stored = stored;
+}
+
+std::size_t MemorySystem::GetSaveStatePageCount() const {
+    return impl->GetSaveStatePageCount(Settings::values.is_new_3ds);
+}
+
+u8* MemorySystem::GetSaveStatePage(std::size_t page) {
+    ASSERT(page < impl->GetSaveStatePageCount(true));
+    return impl->GetSaveStatePage(page);
+}
+
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
@@ -7,6 +7,7 @@
 #include <array>
 #include <cstddef>
 #include <memory>
+#include <streambuf>
 #include <string>
 #include <vector>
 #include <boost/serialization/array.hpp>
@@ -39,6 +40,15 @@ const u32 PAGE_MASK = PAGE_SIZE - 1;
 const int PAGE_BITS = 12;
 const std::size_t PAGE_TABLE_NUM_ENTRIES = 1 << (32 - PAGE_BITS);
 
+/**
+ * Granularity with which the memory cached by the rasterizer is tracked. The accesses to the blocks
+ * of a rasterizer-cached page which aren't cached don't need to flush the rasterizer cache.
+ */
+const u32 RASTERIZER_CACHE_BLOCK_SIZE = 0x100;
+const u32 RASTERIZER_CACHE_BLOCK_MASK = RASTERIZER_CACHE_BLOCK_SIZE - 1;
+const int RASTERIZER_CACHE_BLOCK_BITS = 8;
+static_assert(1u << RASTERIZER_CACHE_BLOCK_BITS == RASTERIZER_CACHE_BLOCK_SIZE);
+
 enum class PageType {
     /// Page is unmapped and should cause an access error.
     Unmapped,
@@ -66,6 +76,12 @@ private:
     friend class boost::serialization::access;
 };
 
+/// Part of a region of the emulated memory, backed by contiguous host memory
+struct HostSpan {
+    u8* pointer;
+    std::size_t size;
+};
+
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works, but instead is optimized for minimal decoding and
@@ -281,6 +297,9 @@ enum class FlushMode {
  */
 void RasterizerClearAll(bool flush);
 
+/// Writes back all the modified surfaces of the rasterizer cache to RAM, keeping them cached
+void RasterizerFlushAll();
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
@@ -337,6 +356,21 @@ public:
     void CopyBlock(const Kernel::Process& dest_process, const Kernel::Process& src_process,
                    VAddr dest_addr, VAddr src_addr, std::size_t size);
 
+    /**
+     * Gets the host memory backing a region of the address space of a process, so that it can be
+     * accessed without copying it. Consecutive pages backed by consecutive host memory are merged
+     * in one span. The spans are only valid until the region is remapped.
+     * @param process The process the region belongs to.
+     * @param vaddr The start address of the region.
+     * @param size The size of the region, in bytes.
+     * @param write Whether the region is written to. The rasterizer cache is flushed for the
+     * cached parts of the region, and also invalidated if it is written to.
+     * @returns the spans covering the region in order, or an empty list if a part of the region
+     * isn't backed by memory.
+     */
+    std::vector<HostSpan> GetContiguousSpans(const Kernel::Process& process, VAddr vaddr,
+                                             std::size_t size, bool write);
+
     std::string ReadCString(VAddr vaddr, std::size_t max_length);
 
     /// Gets a pointer to the memory region beginning at the specified physical address.
@@ -365,10 +399,21 @@ public:
     MemoryRef GetFCRAMRef(std::size_t offset) const;
 
     /**
-     * Mark each page touching the region as cached.
+     * Mark each block touching the region as cached. The pages with cached blocks are accessed
+     * through the slow path, which only flushes the rasterizer cache for the cached blocks.
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /// Counts of the accesses to rasterizer-cached pages through the slow path
+    struct RasterizerCacheCounters {
+        /// Accesses which touched cached blocks, and flushed the rasterizer cache
+        u64 flushes = 0;
+        /// Accesses which only touched blocks that aren't cached, and didn't flush it
+        u64 skipped_flushes = 0;
+    };
+
+    const RasterizerCacheCounters& GetRasterizerCacheCounters() const;
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(std::shared_ptr<PageTable> page_table);
 
@@ -377,6 +422,49 @@ public:
 
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Makes the current contents of VRAM, FCRAM and the N3DS extra RAM the base of incremental
+     * savestates. These savestates only store the pages which changed since their base.
+     * @param id Non-zero ID of the base, stored in the savestates based on it
+     * @param snapshot Stream the contents of the memory are written to. They must be passed to
+     * RestoreSaveStateBase before loading the savestates based on it.
+     */
+    void CreateSaveStateBase(u64 id, std::streambuf& snapshot);
+
+    /// Makes a snapshot written by CreateSaveStateBase the base of incremental savestates
+    void SetSaveStateBase(u64 id, std::streambuf& snapshot);
+
+    /**
+     * Makes a snapshot written by CreateSaveStateBase the base of incremental savestates, and
+     * reads it to the memory so that a savestate based on it can be loaded.
+     */
+    void RestoreSaveStateBase(u64 id, std::streambuf& snapshot);
+
+    /// Makes the following savestates store the whole memory again
+    void ClearSaveStateBase();
+
+    /// Returns the ID of the base of incremental savestates, 0 if there is none
+    u64 GetSaveStateBaseId() const;
+
+    /// Returns the number of memory pages the next savestate would store
+    std::size_t GetChangedSaveStatePageCount() const;
+
+    /**
+     * Sets whether savestates store the contents of VRAM, FCRAM and the N3DS extra RAM. Rewind
+     * snapshots leave them out and keep the memory pages themselves.
+     */
+    void SetSaveStateMemoryStored(bool stored);
+
+    /// Returns the number of memory pages the contents of VRAM, FCRAM and the N3DS extra RAM are
+    /// made of in savestates
+    std::size_t GetSaveStatePageCount() const;
+
+    /**
+     * Returns a pointer to a memory page stored in savestates. The pages are numbered across VRAM,
+     * FCRAM and the N3DS extra RAM, in that order.
+     */
+    u8* GetSaveStatePage(std::size_t page);
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -392,10 +480,19 @@ private:
      */
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const;
 
+    /**
+     * Flushes and invalidates the rasterizer cache for an access to a page marked as
+     * RasterizerCachedMemory, if the access touches any of its cached blocks.
+     */
+    void RasterizerFlushCachedRegion(VAddr start, u32 size, FlushMode mode);
+
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
+public:
+    // Public so that the version of its serialization can be declared
     class Impl;
 
+private:
     std::unique_ptr<Impl> impl;
 
     friend class boost::serialization::access;
@@ -11,6 +11,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -70,9 +71,29 @@ void PerfStats::EndSystemFrame() {
 void PerfStats::EndGameFrame() {
     std::lock_guard lock{object_mutex};
 
+    if (!first_game_frame_done) {
+        // Reported to compare boot times, e.g. with and without the shader caches
+        first_game_frame_done = true;
+        LOG_INFO(Core, "Time to first frame: {:.2f} ms",
+                 std::chrono::duration<double, std::milli>(Clock::now() - boot_point).count());
+    }
+
     game_frames += 1;
 }
 
+void PerfStats::AddRewindSnapshot(Clock::duration duration) {
+    std::lock_guard lock{object_mutex};
+
+    constexpr DoubleSecs FRAME_LENGTH{1.0 / GPU::SCREEN_REFRESH_RATE};
+    if (duration > FRAME_LENGTH && !rewind_snapshot_over_budget) {
+        // Reported once, as it usually happens with every snapshot
+        rewind_snapshot_over_budget = true;
+        LOG_WARNING(Core, "Rewind snapshot took {:.2f} ms, longer than a frame",
+                    std::chrono::duration<double, std::milli>(duration).count());
+    }
+    max_rewind_snapshot_time = std::max(max_rewind_snapshot_time, duration);
+}
+
 double PerfStats::GetMeanFrametime() {
     std::lock_guard lock{object_mutex};
 
@@ -99,6 +120,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    results.rewind_snapshot_time = duration_cast<DoubleSecs>(max_rewind_snapshot_time).count();
 
     // Reset counters
     reset_point = now;
@@ -106,6 +128,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    max_rewind_snapshot_time = Clock::duration::zero();
 
     return results;
 }
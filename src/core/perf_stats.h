@@ -35,12 +35,17 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Walltime of the slowest rewind snapshot, in seconds, 0 if none was taken
+        double rewind_snapshot_time;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Records the walltime taken by a rewind snapshot, which is part of the current frame
+    void AddRewindSnapshot(Clock::duration duration);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -65,6 +70,11 @@ private:
     /// regressions with code changes.
     std::array<double, 216000> perf_history = {};
 
+    /// Point when the game was booted
+    Clock::time_point boot_point = Clock::now();
+    /// Whether the game has submitted its first frame yet
+    bool first_game_frame_done = false;
+
     /// Point when the cumulative counters were reset
     Clock::time_point reset_point = Clock::now();
     /// System time when the cumulative counters were reset
@@ -76,6 +86,10 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Walltime of the slowest rewind snapshot since last reset
+    Clock::duration max_rewind_snapshot_time = Clock::duration::zero();
+    /// Whether a rewind snapshot took longer than a frame yet
+    bool rewind_snapshot_over_budget = false;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -0,0 +1,127 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/rewind_buffer.h"
+
+namespace Core {
+
+// The state other than the memory pages is small, and compressed with a fast level
+constexpr s32 StateCompressionLevel = 1;
+
+// Number of memory pages compared and copied by each task of the pool
+constexpr std::size_t PagesPerTask = 256;
+
+// Memory used by a page stored in a snapshot. Its shared_ptr control block is allocated separately,
+// and holds a vtable pointer, the use and weak counts and the page pointer.
+constexpr std::size_t OwnedPageSize = Memory::PAGE_SIZE + 4 * sizeof(void*);
+
+RewindBuffer::RewindBuffer(std::size_t budget)
+    : budget(budget), zero_page(std::make_shared<const Page>()),
+      pool(Common::ThreadPool::DefaultWorkerCount(), "RewindBuffer") {}
+
+RewindBuffer::~RewindBuffer() = default;
+
+void RewindBuffer::Push(Memory::MemorySystem& memory,
+                        const std::function<void(std::streambuf&)>& save) {
+    Snapshot snapshot;
+    {
+        std::stringbuf state;
+        save(state);
+        const std::string data = state.str();
+        snapshot.state = Common::Compression::CompressDataZSTD(
+            reinterpret_cast<const u8*>(data.data()), data.size(), StateCompressionLevel);
+        // The compressed data is written to a buffer of the worst case size
+        snapshot.state.shrink_to_fit();
+    }
+
+    const Snapshot* const previous = snapshots.empty() ? nullptr : &snapshots.back();
+    const std::size_t num_pages = memory.GetSaveStatePageCount();
+    snapshot.pages.resize(num_pages);
+    std::atomic_size_t new_pages{0};
+    pool.ParallelFor((num_pages + PagesPerTask - 1) / PagesPerTask, [&](std::size_t task) {
+        std::size_t task_new_pages = 0;
+        const std::size_t end = std::min(num_pages, (task + 1) * PagesPerTask);
+        for (std::size_t index = task * PagesPerTask; index < end; ++index) {
+            const u8* const data = memory.GetSaveStatePage(index);
+            auto& page = snapshot.pages[index];
+            if (previous && index < previous->pages.size() &&
+                std::memcmp(previous->pages[index]->data(), data, Memory::PAGE_SIZE) == 0) {
+                page = previous->pages[index];
+            } else if (std::memcmp(zero_page->data(), data, Memory::PAGE_SIZE) == 0) {
+                page = zero_page;
+            } else {
+                // Not value-initialized, as it is overwritten right away
+                std::shared_ptr<Page> copy{new Page};
+                std::memcpy(copy->data(), data, Memory::PAGE_SIZE);
+                page = std::move(copy);
+                ++task_new_pages;
+            }
+        }
+        new_pages += task_new_pages;
+    });
+
+    const std::size_t size = GetFixedMemory(snapshot) + new_pages * OwnedPageSize;
+    used_memory += size;
+    snapshots.push_back(std::move(snapshot));
+
+    // The new snapshot is dropped too if it doesn't fit in the budget by itself
+    while (used_memory > budget && !snapshots.empty()) {
+        used_memory -= GetOwnedMemory(snapshots.front());
+        snapshots.pop_front();
+    }
+    if (snapshots.empty()) {
+        LOG_WARNING(Core, "Rewind snapshot of {} bytes doesn't fit in the budget of {} bytes", size,
+                    budget);
+    }
+}
+
+void RewindBuffer::LoadLatest(const std::function<void(std::streambuf&)>& load) const {
+    ASSERT(!snapshots.empty());
+    const std::vector<u8> data = Common::Compression::DecompressDataZSTD(snapshots.back().state);
+    std::stringbuf state{std::string{data.begin(), data.end()}, std::ios_base::in};
+    load(state);
+}
+
+void RewindBuffer::RestoreLatestMemory(Memory::MemorySystem& memory) const {
+    ASSERT(!snapshots.empty());
+    const auto& pages = snapshots.back().pages;
+    pool.ParallelFor((pages.size() + PagesPerTask - 1) / PagesPerTask, [&](std::size_t task) {
+        const std::size_t end = std::min(pages.size(), (task + 1) * PagesPerTask);
+        for (std::size_t index = task * PagesPerTask; index < end; ++index) {
+            std::memcpy(memory.GetSaveStatePage(index), pages[index]->data(), Memory::PAGE_SIZE);
+        }
+    });
+}
+
+void RewindBuffer::PopLatest() {
+    ASSERT(!snapshots.empty());
+    used_memory -= GetOwnedMemory(snapshots.back());
+    snapshots.pop_back();
+}
+
+void RewindBuffer::Clear() {
+    snapshots.clear();
+    used_memory = 0;
+}
+
+std::size_t RewindBuffer::GetFixedMemory(const Snapshot& snapshot) {
+    return snapshot.state.capacity() + snapshot.pages.capacity() * sizeof(snapshot.pages[0]);
+}
+
+std::size_t RewindBuffer::GetOwnedMemory(const Snapshot& snapshot) const {
+    // The pages which aren't shared with other snapshots are freed along with it
+    const auto owned_pages = std::count_if(snapshot.pages.begin(), snapshot.pages.end(),
+                                           [](const auto& page) { return page.use_count() == 1; });
+    return GetFixedMemory(snapshot) + owned_pages * OwnedPageSize;
+}
+
+} // namespace Core
@@ -0,0 +1,88 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <streambuf>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_pool.h"
+#include "core/memory.h"
+
+namespace Core {
+
+/**
+ * Keeps the latest snapshots of the emulated system in memory, so that the emulation can be
+ * stepped back. A snapshot is made of a savestate without the memory contents, and of the memory
+ * pages, which are shared with the previous snapshot when they didn't change since then. The
+ * oldest snapshots are dropped to keep the buffer within its memory budget.
+ */
+class RewindBuffer {
+public:
+    /// Creates a buffer which uses at most `budget` bytes of memory
+    explicit RewindBuffer(std::size_t budget);
+    ~RewindBuffer();
+
+    /**
+     * Takes a snapshot and adds it to the buffer.
+     * @param memory Memory whose savestate pages are stored in the snapshot
+     * @param save Writes the rest of the state of the system to the stream. It is called before
+     * the memory pages are copied, so that it can flush the data cached outside of the memory.
+     */
+    void Push(Memory::MemorySystem& memory, const std::function<void(std::streambuf&)>& save);
+
+    /// Calls `load` with the state of the latest snapshot, other than the memory pages
+    void LoadLatest(const std::function<void(std::streambuf&)>& load) const;
+
+    /// Copies the memory pages of the latest snapshot to the memory
+    void RestoreLatestMemory(Memory::MemorySystem& memory) const;
+
+    /// Removes the latest snapshot
+    void PopLatest();
+
+    /// Removes all the snapshots
+    void Clear();
+
+    std::size_t GetSnapshotCount() const {
+        return snapshots.size();
+    }
+
+    /// Returns the memory used by the snapshots, in bytes
+    std::size_t GetUsedMemory() const {
+        return used_memory;
+    }
+
+private:
+    using Page = std::array<u8, Memory::PAGE_SIZE>;
+
+    struct Snapshot {
+        /// Savestate of the system without the memory contents, compressed
+        std::vector<u8> state;
+        /// Savestate memory pages, numbered like in MemorySystem::GetSaveStatePage
+        std::vector<std::shared_ptr<const Page>> pages;
+    };
+
+    /// Returns the memory used by the snapshot regardless of its pages, including the page list
+    static std::size_t GetFixedMemory(const Snapshot& snapshot);
+
+    /// Returns the memory which is freed when the snapshot is removed
+    std::size_t GetOwnedMemory(const Snapshot& snapshot) const;
+
+    std::size_t budget;
+    std::size_t used_memory = 0;
+    std::deque<Snapshot> snapshots;
+
+    /// Page shared by all the snapshots for the pages filled with zeros
+    std::shared_ptr<const Page> zero_page;
+
+    /// Pool the memory pages are compared and copied with
+    mutable Common::ThreadPool pool;
+};
+
+} // namespace Core
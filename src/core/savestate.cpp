@@ -2,16 +2,31 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <streambuf>
+#include <thread>
 #include <boost/serialization/binary_object.hpp>
 #include <cryptopp/hex.h>
 #include "common/archives.h"
+#include "common/detached_tasks.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
+#include "common/scope_exit.h"
 #include "common/zstd_compression.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "core/rewind_buffer.h"
 #include "core/savestate.h"
+#include "core/settings.h"
 #include "network/network.h"
 #include "video_core/video_core.h"
 
@@ -23,8 +38,9 @@ struct CSTHeader {
     u64_le program_id;           /// ID of the ROM being executed. Also called title_id
     std::array<u8, 20> revision; /// Git hash of the revision this savestate was created with
     u64_le time;                 /// The time when this save state was created
+    u64_le base_id;              /// ID of the memory snapshot this is based on, 0 if none
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    std::array<u8, 208> reserved; /// Make heading 256 bytes so it has consistent size
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -41,6 +57,203 @@ std::string GetSaveStatePath(u64 program_id, u32 slot) {
                        program_id, slot);
 }
 
+/// Path of the memory snapshot incremental save states are based on. There is one per title.
+static std::string GetSaveStateBasePath(u64 program_id) {
+    return fmt::format("{}{:016X}.base.cst",
+                       FileUtil::GetUserPath(FileUtil::UserPath::StatesDir), program_id);
+}
+
+namespace {
+
+/**
+ * Stream buffer which keeps the data written to it in memory, in chunks so that it grows without
+ * moving the data already written.
+ */
+class CaptureBuffer final : public std::streambuf {
+public:
+    std::size_t GetSize() const {
+        return chunks.empty() ? 0 : (chunks.size() - 1) * ChunkSize + (pptr() - pbase());
+    }
+
+    /// Writes the data to another stream buffer. Returns false if it couldn't be written.
+    bool WriteTo(std::streambuf& dest) const {
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            const auto size = static_cast<std::streamsize>(
+                i + 1 < chunks.size() ? ChunkSize : pptr() - pbase());
+            if (dest.sputn(chunks[i].get(), size) != size) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        // Not value-initialized, as it is overwritten right away
+        chunks.emplace_back(new char[ChunkSize]);
+        setp(chunks.back().get(), chunks.back().get() + ChunkSize);
+        return sputc(traits_type::to_char_type(ch));
+    }
+
+private:
+    static constexpr std::size_t ChunkSize = 4 * 1024 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+};
+
+/**
+ * Tracks the save states being written in the background. The number of captured states waiting
+ * to be written is limited, so that saving to several slots in a row doesn't use too much memory.
+ */
+class PendingSaveStates {
+public:
+    /// Waits until another save state can be captured for the file, and adds it
+    void Add(const std::string& path) {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this, &path] {
+            return paths.size() < MaxPendingSaveStates &&
+                   std::find(paths.begin(), paths.end(), path) == paths.end();
+        });
+        paths.push_back(path);
+    }
+
+    void Remove(const std::string& path) {
+        std::lock_guard lock{mutex};
+        paths.erase(std::find(paths.begin(), paths.end(), path));
+        cv.notify_all();
+    }
+
+    void WaitForAll() {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this] { return paths.empty(); });
+    }
+
+private:
+    static constexpr std::size_t MaxPendingSaveStates = 2;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> paths;
+};
+
+PendingSaveStates pending_savestates;
+
+} // Anonymous namespace
+
+static CSTHeader MakeHeader(u64 program_id) {
+    CSTHeader header{};
+    header.filetype = header_magic_bytes;
+    header.program_id = program_id;
+    std::string rev_bytes;
+    CryptoPP::StringSource(Common::g_scm_rev, true,
+                           new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
+    std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(header.revision));
+    header.time = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    return header;
+}
+
+/**
+ * Writes a file made of a header followed by the data written to the stream by `write`. The data
+ * is compressed on multiple threads as it is written. The file is written next to `path` and only
+ * renamed over it once complete, so that a failed or interrupted write leaves the previous file.
+ * @returns The size of the file
+ */
+static u64 WriteFile(const std::string& path, const CSTHeader& header,
+                     const std::function<void(std::streambuf&)>& write) {
+    if (!FileUtil::CreateFullPath(path)) {
+        throw std::runtime_error("Could not create path " + path);
+    }
+
+    const std::string temp_path = path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
+    if (!file) {
+        throw std::runtime_error("Could not open file " + temp_path);
+    }
+
+    u64 size;
+    try {
+        if (file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+            throw std::runtime_error("Could not write to file " + temp_path);
+        }
+        Common::Compression::ZSTDOutputStreamBuf stream(file, std::thread::hardware_concurrency());
+        write(stream);
+        if (!stream.Finish()) {
+            throw std::runtime_error("Could not write to file " + temp_path);
+        }
+        size = file.Tell();
+        if (!file.Close()) {
+            throw std::runtime_error("Could not write to file " + temp_path);
+        }
+    } catch (...) {
+        file.Close();
+        FileUtil::Delete(temp_path);
+        throw;
+    }
+
+#ifdef _WIN32
+    // Renaming doesn't replace an existing file on Windows
+    if (FileUtil::Exists(path)) {
+        FileUtil::Delete(path);
+    }
+#endif
+    if (!FileUtil::Rename(temp_path, path)) {
+        FileUtil::Delete(temp_path);
+        throw std::runtime_error("Could not replace file " + path);
+    }
+    return size;
+}
+
+/// Opens a file and reads its header. The file is left at the beginning of the compressed data.
+static FileUtil::IOFile OpenFile(const std::string& path, CSTHeader& header) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not read from file at " + path);
+    }
+    return file;
+}
+
+/**
+ * Makes the memory snapshot of the title the base of the following save states. The snapshot is
+ * created from the current memory if there is none yet, otherwise the existing one is kept so
+ * that the save states based on it can still be loaded.
+ */
+static void PrepareSaveStateBase(Memory::MemorySystem& memory, u64 program_id) {
+    const auto path = GetSaveStateBasePath(program_id);
+    if (FileUtil::Exists(path)) {
+        CSTHeader header;
+        FileUtil::IOFile file = OpenFile(path, header);
+        if (header.filetype == header_magic_bytes && header.program_id == program_id &&
+            header.base_id != 0) {
+            Common::Compression::ZSTDInputStreamBuf stream(file);
+            memory.SetSaveStateBase(header.base_id, stream);
+            return;
+        }
+        LOG_WARNING(Core, "Replacing invalid save state base {}", path);
+    }
+
+    std::random_device device;
+    const u64 id = (static_cast<u64>(device()) << 32) | device() | 1;
+    CSTHeader header = MakeHeader(program_id);
+    header.base_id = id;
+    WriteFile(path, header,
+              [&](std::streambuf& stream) { memory.CreateSaveStateBase(id, stream); });
+    LOG_INFO(Core, "Created save state base {}", path);
+}
+
+/// Returns the emulated time between two rewind snapshots, in ticks
+static s64 GetRewindIntervalTicks() {
+    return static_cast<s64>(std::max(Settings::values.rewind_frame_interval, 1)) *
+           static_cast<s64>(GPU::frame_ticks);
+}
+
 std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     std::vector<SaveStateInfo> result;
     for (u32 slot = 1; slot <= SaveStateSlotCount; ++slot) {
@@ -89,40 +302,60 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
 }
 
 void System::SaveState(u32 slot) const {
-    std::ostringstream sstream{std::ios_base::binary};
-    // Serialize
-    oarchive oa{sstream};
-    oa&* this;
-
-    const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
+    const auto start = std::chrono::steady_clock::now();
+    if (!Settings::values.use_incremental_savestates) {
+        memory->ClearSaveStateBase();
+    } else if (memory->GetSaveStateBaseId() == 0) {
+        PrepareSaveStateBase(*memory, title_id);
+    }
 
     const auto path = GetSaveStatePath(title_id, slot);
-    if (!FileUtil::CreateFullPath(path)) {
-        throw std::runtime_error("Could not create path " + path);
-    }
+    CSTHeader header = MakeHeader(title_id);
+    header.base_id = memory->GetSaveStateBaseId();
 
-    FileUtil::IOFile file(path, "wb");
-    if (!file) {
-        throw std::runtime_error("Could not open file " + path);
+    // The state is captured in memory while the emulation is paused, and compressed and written
+    // to the file in the background
+    pending_savestates.Add(path);
+    auto capture = std::make_shared<CaptureBuffer>();
+    try {
+        // Serialize
+        oarchive oa{*capture};
+        oa&* this;
+    } catch (...) {
+        pending_savestates.Remove(path);
+        throw;
     }
 
-    CSTHeader header{};
-    header.filetype = header_magic_bytes;
-    header.program_id = title_id;
-    std::string rev_bytes;
-    CryptoPP::StringSource(Common::g_scm_rev, true,
-                           new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
-    std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(header.revision));
-    header.time = std::chrono::duration_cast<std::chrono::seconds>(
-                      std::chrono::system_clock::now().time_since_epoch())
-                      .count();
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG_INFO(Core, "Captured state for slot {} in {} ms ({} bytes, {})", slot, duration.count(),
+             capture->GetSize(), header.base_id != 0 ? "incremental" : "full");
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
-        throw std::runtime_error("Could not write to file " + path);
-    }
+    Common::DetachedTasks::AddTask([slot, path, header, capture{std::move(capture)},
+                                    callback = save_state_callback]() mutable {
+        const auto start = std::chrono::steady_clock::now();
+        std::string error;
+        try {
+            const u64 size = WriteFile(path, header, [&capture](std::streambuf& stream) {
+                if (!capture->WriteTo(stream)) {
+                    throw std::runtime_error("Could not compress the save state");
+                }
+            });
+            const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            LOG_INFO(Core, "Saved state to slot {} in {} ms ({} bytes)", slot, duration.count(),
+                     size);
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error saving to slot {}: {}", slot, e.what());
+            error = e.what();
+        }
+
+        capture.reset();
+        pending_savestates.Remove(path);
+        if (callback) {
+            callback(slot, error);
+        }
+    });
 }
 
 void System::LoadState(u32 slot) {
@@ -131,26 +364,79 @@ void System::LoadState(u32 slot) {
     }
 
     const auto path = GetSaveStatePath(title_id, slot);
+    pending_savestates.WaitForAll();
 
-    std::vector<u8> decompressed;
-    {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+    CSTHeader header;
+    FileUtil::IOFile file = OpenFile(path, header);
 
-        FileUtil::IOFile file(path, "rb");
-        file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
+    // The memory snapshot of an incremental save state is restored to the memory recreated by the
+    // loading, and the pages which changed since then are loaded over it
+    if (header.base_id != 0) {
+        const auto base_path = GetSaveStateBasePath(title_id);
+        CSTHeader base_header;
+        auto base_file = std::make_shared<FileUtil::IOFile>(OpenFile(base_path, base_header));
+        if (base_header.base_id != header.base_id) {
+            throw std::runtime_error("The save state is based on a missing memory snapshot " +
+                                     base_path);
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
+        restore_memory = [base_file, base_id = u64{header.base_id}](Memory::MemorySystem& memory) {
+            Common::Compression::ZSTDInputStreamBuf base_stream(*base_file);
+            memory.RestoreSaveStateBase(base_id, base_stream);
+        };
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
+    SCOPE_EXIT({ restore_memory = nullptr; });
 
     // Deserialize
-    iarchive ia{sstream};
+    Common::Compression::ZSTDInputStreamBuf stream(file);
+    iarchive ia{stream};
     ia&* this;
+
+    next_rewind_snapshot_ticks = timing->GetGlobalTicks() + GetRewindIntervalTicks();
+}
+
+void System::TakeRewindSnapshot() {
+    const auto start = PerfStats::Clock::now();
+    // The flush is part of the time taken by the snapshot, the cache is kept for the next frames
+    Memory::RasterizerFlushAll();
+    keep_rasterizer_cache = true;
+    memory->SetSaveStateMemoryStored(false);
+    SCOPE_EXIT({
+        memory->SetSaveStateMemoryStored(true);
+        keep_rasterizer_cache = false;
+    });
+    rewind_buffer->Push(*memory, [this](std::streambuf& stream) {
+        oarchive oa{stream};
+        oa&* this;
+    });
+    perf_stats->AddRewindSnapshot(PerfStats::Clock::now() - start);
+
+    LOG_DEBUG(Core, "Took rewind snapshot ({} snapshots, {} bytes)",
+              rewind_buffer->GetSnapshotCount(), rewind_buffer->GetUsedMemory());
+    next_rewind_snapshot_ticks = timing->GetGlobalTicks() + GetRewindIntervalTicks();
+}
+
+bool System::Rewind() {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to rewind while connected to multiplayer");
+    }
+    if (!rewind_buffer || rewind_buffer->GetSnapshotCount() == 0) {
+        return false;
+    }
+
+    // The memory pages aren't in the savestate of the snapshot, they are copied to the memory
+    // recreated by the loading
+    restore_memory = [this](Memory::MemorySystem& memory) {
+        rewind_buffer->RestoreLatestMemory(memory);
+    };
+    SCOPE_EXIT({ restore_memory = nullptr; });
+    rewind_buffer->LoadLatest([this](std::streambuf& stream) {
+        iarchive ia{stream};
+        ia&* this;
+    });
+    rewind_buffer->PopLatest();
+
+    next_rewind_snapshot_ticks = timing->GetGlobalTicks() + GetRewindIntervalTicks();
+    return true;
 }
 
 } // namespace Core
@@ -26,6 +26,9 @@ void Apply() {
 
     VideoCore::g_hw_renderer_enabled = values.use_hw_renderer;
     VideoCore::g_shader_jit_enabled = values.use_shader_jit;
+    VideoCore::g_parallel_vertex_shading_enabled = values.use_parallel_vertex_shading;
+    VideoCore::g_shader_jit_batch_size = values.shader_jit_batch_size;
+    VideoCore::g_parallel_rasterization_enabled = values.use_parallel_rasterization;
     VideoCore::g_hw_shader_enabled = values.use_hw_shader;
     VideoCore::g_separable_shader_enabled = values.separable_shader;
     VideoCore::g_hw_shader_accurate_mul = values.shaders_accurate_mul;
@@ -78,12 +81,19 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_UseIncrementalSavestates", Settings::values.use_incremental_savestates);
+    LogSetting("Core_EnableRewind", Settings::values.enable_rewind);
+    LogSetting("Core_RewindFrameInterval", Settings::values.rewind_frame_interval);
+    LogSetting("Core_RewindBufferSize", Settings::values.rewind_buffer_size);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
     LogSetting("Renderer_SeparableShader", Settings::values.separable_shader);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
+    LogSetting("Renderer_UseParallelVertexShading", Settings::values.use_parallel_vertex_shading);
+    LogSetting("Renderer_ShaderJitBatchSize", Settings::values.shader_jit_batch_size);
+    LogSetting("Renderer_UseParallelRasterization", Settings::values.use_parallel_rasterization);
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
     LogSetting("Renderer_UseFrameLimit", Settings::values.use_frame_limit);
     LogSetting("Renderer_FrameLimit", Settings::values.frame_limit);
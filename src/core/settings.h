@@ -166,6 +166,10 @@ struct Values {
     // Core
     bool use_cpu_jit;
     int cpu_clock_percentage;
+    bool use_incremental_savestates;
+    bool enable_rewind;
+    int rewind_frame_interval;
+    int rewind_buffer_size; ///< In MiB
 
     // Data Storage
     bool use_virtual_sd;
@@ -183,6 +187,9 @@ struct Values {
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_parallel_vertex_shading;
+    u16 shader_jit_batch_size;
+    bool use_parallel_rasterization;
     u16 resolution_factor;
     bool use_frame_limit;
     u16 frame_limit;
@@ -0,0 +1,32 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool runs every task exactly once", "[common]") {
+    ThreadPool pool{3, "TestPool"};
+    REQUIRE(pool.NumThreads() == 4);
+
+    for (int round = 0; round < 100; ++round) {
+        std::vector<std::atomic_int> counts(257);
+        pool.ParallelFor(counts.size(), [&](std::size_t task) { ++counts[task]; });
+        for (const auto& count : counts) {
+            REQUIRE(count == 1);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool without workers runs tasks inline", "[common]") {
+    ThreadPool pool{0, "TestPool"};
+    std::vector<std::size_t> order;
+    pool.ParallelFor(4, [&](std::size_t task) { order.push_back(task); });
+    REQUIRE(order == std::vector<std::size_t>{0, 1, 2, 3});
+}
+
+} // namespace Common
@@ -0,0 +1,80 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/zstd_compression.h"
+
+using Common::Compression::ZSTDInputStreamBuf;
+using Common::Compression::ZSTDOutputStreamBuf;
+
+static std::vector<char> MakeData() {
+    // Runs of repeated bytes between random bytes, so that the data is partly compressible
+    std::mt19937 rng(1234);
+    std::vector<char> data(3 << 20);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = (i / 4096) % 4 != 0 ? static_cast<char>(i / 4096) : static_cast<char>(rng());
+    }
+    return data;
+}
+
+// Small and large reads and writes, which go through the buffers and bypass them respectively
+static constexpr std::size_t chunk_sizes[] = {1, 7, 4096, 1 << 20, 100, 300000};
+
+static std::vector<char> ReadAll(FileUtil::IOFile& file) {
+    ZSTDInputStreamBuf stream(file);
+    std::vector<char> result;
+    for (std::size_t i = 0;; ++i) {
+        std::vector<char> chunk(chunk_sizes[i % std::size(chunk_sizes)]);
+        const auto size = stream.sgetn(chunk.data(), chunk.size());
+        result.insert(result.end(), chunk.begin(), chunk.begin() + size);
+        if (size < static_cast<std::streamsize>(chunk.size())) {
+            break;
+        }
+    }
+    return result;
+}
+
+TEST_CASE("ZSTD stream buffers", "[common]") {
+    const std::string path = "zstd_compression_test.bin";
+    const std::vector<char> data = MakeData();
+
+    for (const u32 num_threads : {0, 2}) {
+        {
+            FileUtil::IOFile file(path, "wb");
+            REQUIRE(file.WriteBytes("head", 4) == 4);
+            ZSTDOutputStreamBuf stream(file, num_threads);
+            std::size_t offset = 0;
+            for (std::size_t i = 0; offset < data.size(); ++i) {
+                const std::size_t size =
+                    std::min(chunk_sizes[i % std::size(chunk_sizes)], data.size() - offset);
+                REQUIRE(stream.sputn(&data[offset], size) == static_cast<std::streamsize>(size));
+                offset += size;
+            }
+            REQUIRE(stream.Finish());
+        }
+        REQUIRE(FileUtil::GetSize(path) < data.size() / 2);
+
+        FileUtil::IOFile file(path, "rb");
+        char header[4];
+        REQUIRE(file.ReadBytes(header, 4) == 4);
+        REQUIRE(ReadAll(file) == data);
+    }
+
+    // Data compressed in one go can be read as a stream
+    {
+        const auto compressed = Common::Compression::CompressDataZSTDDefault(
+            reinterpret_cast<const u8*>(data.data()), data.size());
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(compressed.data(), compressed.size()) == compressed.size());
+    }
+    FileUtil::IOFile file(path, "rb");
+    REQUIRE(ReadAll(file) == data);
+    file.Close();
+
+    FileUtil::Delete(path);
+}
@@ -4,9 +4,15 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <set>
 #include <string>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -197,3 +203,139 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
 }
 
 // TODO: Add tests for multiple timers
+
+// Measures rescheduling events in a queue of about a thousand events, like when timeouts are
+// cancelled and set again, along with dispatching the events which expire.
+TEST_CASE("CoreTiming event queue throughput", "[.benchmark][core]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t num_types = 64;
+    constexpr u64 num_events = 1024;
+    constexpr std::size_t num_iterations = 1000000;
+
+    Core::Timing timing(1, 100);
+    const auto timer = timing.GetTimer(0);
+    std::vector<Core::TimingEventType*> types;
+    for (std::size_t i = 0; i < num_types; ++i) {
+        types.push_back(timing.RegisterEvent("event" + std::to_string(i), [](u64, s64) {}));
+    }
+    std::mt19937 rng(1234);
+    const auto Reschedule = [&](u64 userdata) {
+        timing.UnscheduleEvent(types[userdata % num_types], userdata);
+        timing.ScheduleEvent(rng() % 1000000 + 1, types[userdata % num_types], userdata, 0);
+    };
+
+    // Enter slice 0
+    timer->Advance();
+    timer->SetNextSlice();
+    for (u64 userdata = 0; userdata < num_events; ++userdata) {
+        Reschedule(userdata);
+    }
+
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < num_iterations; ++i) {
+        Reschedule(rng() % num_events);
+        if (i % 16 == 0) {
+            timer->AddTicks(timer->GetDowncount());
+            timer->Advance();
+            timer->SetNextSlice();
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WARN(num_iterations / seconds / 1e6 << " M reschedules/s");
+}
+
+// Checks the event queue against a std::multiset of the same events with random operations, with
+// few distinct times so that the order of the events added at the same time is exercised too.
+TEST_CASE("CoreTiming event queue matches a reference", "[core]") {
+    using Event = Core::Timing::Event;
+    constexpr std::size_t num_types = 4;
+    constexpr u64 num_userdata = 8;
+    constexpr std::size_t num_operations = 20000;
+
+    Core::Timing timing(1, 100);
+    std::vector<Core::TimingEventType*> types;
+    for (std::size_t i = 0; i < num_types; ++i) {
+        types.push_back(timing.RegisterEvent("event" + std::to_string(i), [](u64, s64) {}));
+    }
+
+    const auto Equal = [](const Event& a, const Event& b) {
+        return a.time == b.time && a.fifo_order == b.fifo_order && a.userdata == b.userdata &&
+               a.type == b.type;
+    };
+
+    auto queue = std::make_unique<Core::Timing::EventQueue>();
+    std::multiset<Event> reference;
+    std::mt19937 rng(5678);
+    u64 fifo_order = 0;
+    std::size_t removed_non_root = 0;
+
+    const auto RemoveFromReference = [&](auto predicate) {
+        for (auto it = reference.begin(); it != reference.end();) {
+            if (predicate(*it)) {
+                removed_non_root += it != reference.begin();
+                it = reference.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < num_operations; ++i) {
+        const u32 operation = rng() % 100;
+        if (operation < 50) {
+            const Event event{static_cast<s64>(rng() % 64), fifo_order++, rng() % num_userdata,
+                              types[rng() % num_types]};
+            queue->Push(event);
+            reference.insert(event);
+        } else if (operation < 75) {
+            if (!reference.empty()) {
+                REQUIRE(Equal(queue->Pop(), *reference.begin()));
+                reference.erase(reference.begin());
+            }
+        } else if (operation < 90) {
+            const Core::TimingEventType* type = types[rng() % num_types];
+            const u64 userdata = rng() % num_userdata;
+            queue->Remove(type, userdata);
+            RemoveFromReference([&](const Event& event) {
+                return event.type == type && event.userdata == userdata;
+            });
+        } else if (operation < 95) {
+            const Core::TimingEventType* type = types[rng() % num_types];
+            queue->RemoveAll(type);
+            RemoveFromReference([&](const Event& event) { return event.type == type; });
+        } else if (operation < 97) {
+            queue->Clear();
+            reference.clear();
+        } else {
+            // Round trip through the ordered list of events that savestates store. Event::load
+            // looks the types up in the global timing, so the list itself is used here. Half the
+            // time the events are loaded back into the same queue, which reuses its nodes.
+            const std::vector<Event> events = queue->GetEvents();
+            REQUIRE(events.size() == reference.size());
+            REQUIRE(std::equal(events.begin(), events.end(), reference.begin(), Equal));
+            if (rng() % 2 == 0) {
+                queue = std::make_unique<Core::Timing::EventQueue>();
+            }
+            queue->Clear();
+            for (const Event& event : events) {
+                queue->Push(event);
+            }
+        }
+
+        REQUIRE(queue->IsEmpty() == reference.empty());
+        if (!reference.empty()) {
+            REQUIRE(Equal(queue->Top(), *reference.begin()));
+        }
+    }
+
+    const std::vector<Event> events = queue->GetEvents();
+    REQUIRE(std::equal(events.begin(), events.end(), reference.begin(), reference.end(), Equal));
+    REQUIRE(removed_non_root > 0);
+
+    // Drain the queue, which must give the events in the reference order
+    for (const Event& expected : reference) {
+        REQUIRE(Equal(queue->Pop(), expected));
+    }
+    REQUIRE(queue->IsEmpty());
+}
@@ -0,0 +1,117 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <catch2/catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace {
+
+struct FakeThread {
+    unsigned int priority = 0;
+    Common::ThreadQueueHook<FakeThread> queue_hook;
+};
+
+using ReadyQueue = Common::ThreadQueueList<FakeThread, 64>;
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList pops the threads by priority", "[core][kernel]") {
+    ReadyQueue queue;
+    std::array<FakeThread, 4> threads;
+
+    REQUIRE(queue.get_first() == nullptr);
+    REQUIRE(queue.pop_first() == nullptr);
+
+    queue.push_back(48, &threads[0]);
+    queue.push_back(24, &threads[1]);
+    queue.push_back(48, &threads[2]);
+    queue.push_front(48, &threads[3]);
+    REQUIRE(queue.contains(&threads[2]) == 48);
+    REQUIRE(!queue.empty(48));
+    REQUIRE(queue.empty(63));
+
+    // Only threads with a strictly better priority are popped
+    REQUIRE(queue.pop_first_better(24) == nullptr);
+    REQUIRE(queue.pop_first_better(63) == &threads[1]);
+    REQUIRE(queue.contains(&threads[1]) == static_cast<ReadyQueue::Priority>(-1));
+    REQUIRE(queue.pop_first_better(48) == nullptr);
+
+    REQUIRE(queue.get_first() == &threads[3]);
+    REQUIRE(queue.pop_first() == &threads[3]);
+    REQUIRE(queue.pop_first() == &threads[0]);
+    REQUIRE(queue.pop_first() == &threads[2]);
+    REQUIRE(queue.pop_first() == nullptr);
+    REQUIRE(queue.empty(48));
+}
+
+TEST_CASE("ThreadQueueList removes and moves threads", "[core][kernel]") {
+    ReadyQueue queue;
+    std::array<FakeThread, 3> threads;
+    for (auto& thread : threads) {
+        queue.push_back(10, &thread);
+    }
+
+    // Removing a thread from another level, or which isn't queued, does nothing
+    queue.remove(20, &threads[1]);
+    REQUIRE(queue.contains(&threads[1]) == 10);
+    queue.remove(10, &threads[1]);
+    queue.remove(10, &threads[1]);
+    REQUIRE(queue.contains(&threads[1]) == static_cast<ReadyQueue::Priority>(-1));
+
+    queue.rotate(10);
+    REQUIRE(queue.get_first() == &threads[2]);
+
+    queue.move(&threads[0], 10, 0);
+    queue.push_back(63, &threads[1]);
+    REQUIRE(queue.pop_first() == &threads[0]);
+    REQUIRE(queue.pop_first() == &threads[2]);
+    REQUIRE(queue.pop_first() == &threads[1]);
+    REQUIRE(queue.pop_first() == nullptr);
+
+    queue.push_back(5, &threads[0]);
+    queue.push_back(6, &threads[1]);
+    queue.clear();
+    REQUIRE(queue.get_first() == nullptr);
+    queue.push_back(7, &threads[0]);
+    REQUIRE(queue.get_first() == &threads[0]);
+}
+
+TEST_CASE("Scheduler ready queue throughput", "[.benchmark][core][kernel]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t num_threads = 32;
+    constexpr std::size_t num_iterations = 10000000;
+
+    ReadyQueue queue;
+    std::array<FakeThread, num_threads> threads;
+    std::mt19937 rng(1234);
+    for (auto& thread : threads) {
+        thread.priority = 16 + rng() % 48;
+        queue.push_back(thread.priority, &thread);
+    }
+
+    // Like ThreadManager::Reschedule, the running thread is switched for a better one, and threads
+    // are woken up and have their priority changed in between
+    FakeThread* current = queue.pop_first();
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < num_iterations; ++i) {
+        FakeThread& thread = threads[rng() % num_threads];
+        if (&thread != current && i % 4 == 0) {
+            const unsigned int priority = 16 + rng() % 48;
+            queue.move(&thread, thread.priority, priority);
+            thread.priority = priority;
+        }
+        FakeThread* next = queue.pop_first_better(current->priority);
+        if (next == nullptr) {
+            next = queue.pop_first();
+        }
+        queue.push_back(current->priority, current);
+        current = next;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WARN(num_iterations / seconds / 1e6 << " M reschedules/s");
+}
@@ -0,0 +1,76 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+#include "core/hle/ipc.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/service/service.h"
+#include "core/memory.h"
+
+namespace Service {
+
+class TestService final : public ServiceFramework<TestService> {
+public:
+    TestService() : ServiceFramework("test") {
+        static const FunctionInfo functions[] = {
+            {0x00010040, &TestService::Increment, "Increment"},
+            {0x00030000, nullptr, "Unimplemented"},
+            {0x100D0080, &TestService::Increment, "IncrementWithHighId"},
+        };
+        RegisterHandlers(functions);
+    }
+
+    int calls = 0;
+
+private:
+    void Increment(Kernel::HLERequestContext& ctx) {
+        ++calls;
+        ctx.CommandBuffer()[1] += 1;
+    }
+};
+
+TEST_CASE("ServiceFramework dispatches by command ID", "[core][service]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto [server, client] = kernel.CreateSessionPair();
+    Kernel::HLERequestContext context(kernel, std::move(server), nullptr);
+    TestService service;
+
+    SECTION("finds the function names") {
+        REQUIRE(service.GetFunctionName(0x00010040) == "Increment");
+        REQUIRE(service.GetFunctionName(0x00030000) == "Unimplemented");
+        REQUIRE(service.GetFunctionName(0x100D0080) == "IncrementWithHighId");
+        // The parameter sizes of the header have to match
+        REQUIRE(service.GetFunctionName(0x00010000) == "");
+        REQUIRE(service.GetFunctionName(0x00020000) == "");
+        REQUIRE(service.GetFunctionName(0x08000000) == "");
+        REQUIRE(service.GetFunctionName(0x100E0080) == "");
+        REQUIRE(service.GetFunctionName(0x20000000) == "");
+    }
+
+    SECTION("calls the handler of the command") {
+        context.CommandBuffer()[0] = IPC::MakeHeader(0x100D, 2, 0);
+        context.CommandBuffer()[1] = 41;
+        service.HandleSyncRequest(context);
+        REQUIRE(service.calls == 1);
+        REQUIRE(context.CommandBuffer()[1] == 42);
+    }
+
+    SECTION("replies to unimplemented and unknown commands") {
+        for (const u32 header : {IPC::MakeHeader(0x3, 0, 0), IPC::MakeHeader(0x2, 1, 0),
+                                 IPC::MakeHeader(0x1, 2, 0)}) {
+            context.CommandBuffer()[0] = header;
+            context.CommandBuffer()[1] = 41;
+            service.HandleSyncRequest(context);
+            REQUIRE(context.CommandBuffer()[0] == IPC::MakeHeader(header >> 16, 1, 0));
+            REQUIRE(context.CommandBuffer()[1] == 0);
+        }
+        REQUIRE(service.calls == 0);
+    }
+}
+
+} // namespace Service
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <sstream>
 #include <catch2/catch.hpp>
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -9,6 +10,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/shared_page.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
     Core::Timing timing(1, 100);
@@ -54,3 +56,104 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("MemorySystem incremental savestate base", "[core][memory]") {
+    Memory::MemorySystem memory;
+    Settings::values.is_new_3ds = false;
+
+    std::stringbuf snapshot;
+    memory.CreateSaveStateBase(1, snapshot);
+    CHECK(memory.GetSaveStateBaseId() == 1);
+    CHECK(memory.GetChangedSaveStatePageCount() == 0);
+
+    // Only the pages written since the base was created are stored
+    memory.GetFCRAMPointer(0)[0x123] = 1;
+    memory.GetFCRAMPointer(0)[0x456] = 2;
+    memory.GetFCRAMPointer(0)[Memory::FCRAM_SIZE - 1] = 3;
+    memory.GetPhysicalPointer(Memory::VRAM_PADDR)[Memory::PAGE_SIZE] = 4;
+    CHECK(memory.GetChangedSaveStatePageCount() == 3);
+
+    // Pages past the end of the base are always stored
+    Settings::values.is_new_3ds = true;
+    CHECK(memory.GetChangedSaveStatePageCount() ==
+          3 + (Memory::FCRAM_N3DS_SIZE - Memory::FCRAM_SIZE + Memory::N3DS_EXTRA_RAM_SIZE) /
+                  Memory::PAGE_SIZE);
+    Settings::values.is_new_3ds = false;
+
+    snapshot.pubseekpos(0, std::ios_base::in);
+    memory.RestoreSaveStateBase(1, snapshot);
+    CHECK(memory.GetChangedSaveStatePageCount() == 0);
+    CHECK(memory.GetFCRAMPointer(0)[0x123] == 0);
+    CHECK(memory.GetPhysicalPointer(Memory::VRAM_PADDR)[Memory::PAGE_SIZE] == 0);
+
+    memory.ClearSaveStateBase();
+    CHECK(memory.GetSaveStateBaseId() == 0);
+    CHECK(memory.GetChangedSaveStatePageCount() ==
+          (Memory::VRAM_SIZE + Memory::FCRAM_SIZE) / Memory::PAGE_SIZE);
+}
+
+TEST_CASE("MemorySystem rasterizer-cached blocks", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.HandleSpecialMapping(process->vm_manager,
+                                {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+    memory.SetCurrentPageTable(process->vm_manager.page_table);
+    auto& page_table = *process->vm_manager.page_table;
+    const u32 page = (Memory::VRAM_VADDR >> Memory::PAGE_BITS) + 1;
+
+    // The whole page is accessed through the slow path, which only flushes the cached block
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE + 0x210, 0x20, true);
+    CHECK(page_table.attributes[page] == Memory::PageType::RasterizerCachedMemory);
+    CHECK(page_table.attributes[page - 1] == Memory::PageType::Memory);
+    memory.Write32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x100, 1);
+    memory.Write32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x2FC, 2);
+    CHECK(memory.Read32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x100) == 1);
+    CHECK(memory.Read32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x2FC) == 2);
+    CHECK(memory.GetRasterizerCacheCounters().flushes == 2);
+    CHECK(memory.GetRasterizerCacheCounters().skipped_flushes == 2);
+
+    // Accesses straddling a cached block flush it
+    CHECK(memory.Read32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x1FE) == 0);
+    CHECK(memory.GetRasterizerCacheCounters().flushes == 3);
+
+    // The page is uncached along with its last cached block
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE + 0x500, 0x100, true);
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE + 0x200, 0x100, false);
+    CHECK(page_table.attributes[page] == Memory::PageType::RasterizerCachedMemory);
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE + 0x500, 0x100, false);
+    CHECK(page_table.attributes[page] == Memory::PageType::Memory);
+    CHECK(memory.Read32(Memory::VRAM_VADDR + Memory::PAGE_SIZE + 0x2FC) == 2);
+}
+
+TEST_CASE("MemorySystem::GetContiguousSpans", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    kernel.HandleSpecialMapping(process->vm_manager,
+                                {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+    kernel.MapSharedPages(process->vm_manager);
+    u8* const vram = memory.GetPhysicalPointer(Memory::VRAM_PADDR);
+
+    // Consecutive pages backed by consecutive memory are merged, cached pages included
+    memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR + Memory::PAGE_SIZE, 0x100, true);
+    auto spans = memory.GetContiguousSpans(*process, Memory::VRAM_VADDR + 0x10,
+                                           3 * Memory::PAGE_SIZE, true);
+    REQUIRE(spans.size() == 1);
+    CHECK(spans[0].pointer == vram + 0x10);
+    CHECK(spans[0].size == 3 * Memory::PAGE_SIZE);
+
+    // Regions which aren't entirely backed by memory have no spans
+    CHECK(memory.GetContiguousSpans(*process, Memory::VRAM_VADDR_END - 0x10, 0x20, false).empty());
+
+    spans = memory.GetContiguousSpans(*process, Memory::CONFIG_MEMORY_VADDR,
+                                      Memory::CONFIG_MEMORY_SIZE + Memory::SHARED_PAGE_SIZE, false);
+    REQUIRE(!spans.empty());
+    std::size_t size = 0;
+    for (const auto& span : spans) {
+        size += span.size;
+    }
+    CHECK(size == Memory::CONFIG_MEMORY_SIZE + Memory::SHARED_PAGE_SIZE);
+}
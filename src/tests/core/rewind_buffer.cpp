@@ -0,0 +1,123 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <string>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "core/rewind_buffer.h"
+#include "core/settings.h"
+
+static void PushState(Core::RewindBuffer& buffer, Memory::MemorySystem& memory,
+                      const std::string& state) {
+    buffer.Push(memory, [&state](std::streambuf& stream) {
+        stream.sputn(state.data(), static_cast<std::streamsize>(state.size()));
+    });
+}
+
+/// Returns the memory used by the page list of each snapshot
+static std::size_t GetPageListSize(const Memory::MemorySystem& memory) {
+    return memory.GetSaveStatePageCount() * sizeof(std::shared_ptr<const void>);
+}
+
+static std::string LoadLatestState(const Core::RewindBuffer& buffer) {
+    std::string state;
+    buffer.LoadLatest([&state](std::streambuf& stream) {
+        for (int c = stream.sbumpc(); c != std::char_traits<char>::eof(); c = stream.sbumpc()) {
+            state.push_back(static_cast<char>(c));
+        }
+    });
+    return state;
+}
+
+TEST_CASE("RewindBuffer shares unchanged pages between snapshots", "[core]") {
+    Settings::values.is_new_3ds = false;
+    Memory::MemorySystem memory;
+    Core::RewindBuffer buffer(1024 * 1024 * 1024);
+
+    const std::size_t page_list_size = GetPageListSize(memory);
+
+    // Pages filled with zeros aren't stored
+    memory.GetFCRAMPointer(0)[0x1000] = 1;
+    PushState(buffer, memory, "first");
+    const std::size_t first_size = buffer.GetUsedMemory();
+    CHECK(first_size > page_list_size + Memory::PAGE_SIZE);
+    CHECK(first_size < page_list_size + 2 * Memory::PAGE_SIZE);
+
+    // Only the pages which changed since the previous snapshot are stored
+    memory.GetFCRAMPointer(0)[0x1000] = 2;
+    memory.GetFCRAMPointer(0)[0x5000] = 3;
+    PushState(buffer, memory, "second");
+    CHECK(buffer.GetSnapshotCount() == 2);
+    CHECK(buffer.GetUsedMemory() > first_size + page_list_size + 2 * Memory::PAGE_SIZE);
+    CHECK(buffer.GetUsedMemory() < first_size + page_list_size + 3 * Memory::PAGE_SIZE);
+
+    memory.GetFCRAMPointer(0)[0x1000] = 4;
+    memory.GetFCRAMPointer(0)[0x9000] = 5;
+    buffer.RestoreLatestMemory(memory);
+    CHECK(LoadLatestState(buffer) == "second");
+    CHECK(memory.GetFCRAMPointer(0)[0x1000] == 2);
+    CHECK(memory.GetFCRAMPointer(0)[0x5000] == 3);
+    CHECK(memory.GetFCRAMPointer(0)[0x9000] == 0);
+
+    buffer.PopLatest();
+    CHECK(buffer.GetUsedMemory() == first_size);
+    buffer.RestoreLatestMemory(memory);
+    CHECK(LoadLatestState(buffer) == "first");
+    CHECK(memory.GetFCRAMPointer(0)[0x1000] == 1);
+    CHECK(memory.GetFCRAMPointer(0)[0x5000] == 0);
+
+    buffer.PopLatest();
+    CHECK(buffer.GetSnapshotCount() == 0);
+    CHECK(buffer.GetUsedMemory() == 0);
+}
+
+TEST_CASE("RewindBuffer drops the oldest snapshots to stay within its budget", "[core]") {
+    Settings::values.is_new_3ds = false;
+    Memory::MemorySystem memory;
+    const std::size_t budget = 2 * GetPageListSize(memory) + 5 * Memory::PAGE_SIZE;
+    Core::RewindBuffer buffer(budget);
+
+    // Each snapshot stores two new pages
+    for (u8 i = 1; i <= 4; ++i) {
+        memory.GetFCRAMPointer(0)[0] = i;
+        memory.GetFCRAMPointer(0)[Memory::PAGE_SIZE] = i;
+        PushState(buffer, memory, std::to_string(i));
+        CHECK(buffer.GetUsedMemory() <= budget);
+    }
+    CHECK(buffer.GetSnapshotCount() == 2);
+    CHECK(LoadLatestState(buffer) == "4");
+    buffer.PopLatest();
+    CHECK(LoadLatestState(buffer) == "3");
+
+    // A snapshot which doesn't fit in the budget by itself isn't kept
+    for (std::size_t page = 0; page < budget / Memory::PAGE_SIZE; ++page) {
+        memory.GetFCRAMPointer(page * Memory::PAGE_SIZE)[0] = 0xFF;
+    }
+    PushState(buffer, memory, "too big");
+    CHECK(buffer.GetSnapshotCount() == 0);
+    CHECK(buffer.GetUsedMemory() == 0);
+}
+
+TEST_CASE("RewindBuffer counts the page lists of identical snapshots", "[core]") {
+    Settings::values.is_new_3ds = false;
+    Memory::MemorySystem memory;
+    const std::size_t page_list_size = GetPageListSize(memory);
+    const std::size_t budget = 10 * page_list_size;
+    Core::RewindBuffer buffer(budget);
+
+    // The snapshots share all their pages, but each one still has its own page list
+    memory.GetFCRAMPointer(0)[0] = 1;
+    for (int i = 0; i < 50; ++i) {
+        PushState(buffer, memory, "same");
+        CHECK(buffer.GetUsedMemory() <= budget);
+    }
+    CHECK(buffer.GetSnapshotCount() < 10);
+    CHECK(buffer.GetUsedMemory() > buffer.GetSnapshotCount() * page_list_size);
+
+    while (buffer.GetSnapshotCount() != 0) {
+        buffer.PopLatest();
+    }
+    CHECK(buffer.GetUsedMemory() == 0);
+}
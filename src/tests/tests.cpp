@@ -7,3 +7,6 @@
 
 // Catch provides the main function since we've given it the
 // CATCH_CONFIG_MAIN preprocessor directive.
+
+// Benchmarks are tagged with [.benchmark], which hides them from the default run. They are run with
+// `tests "[.benchmark]"`.
@@ -0,0 +1,154 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "common/threadsafe_queue.h"
+#include "video_core/gpu_thread.h"
+
+using VideoCore::GPUThread::CommandQueue;
+using VideoCore::GPUThread::CommandRecord;
+using VideoCore::GPUThread::CommandType;
+
+static CommandRecord MakeRegionCommand(CommandType type, VAddr addr, u64 size, u64 fence) {
+    CommandRecord record{type};
+    record.fence = fence;
+    record.region = {addr, size};
+    return record;
+}
+
+static CommandRecord MakeSwapCommand(u64 fence) {
+    CommandRecord record{CommandType::SwapBuffers};
+    record.fence = fence;
+    return record;
+}
+
+TEST_CASE("CommandQueue coalesces overlapping region commands", "[video_core][gpu_thread]") {
+    auto queue = std::make_unique<CommandQueue>();
+    std::array<CommandRecord, 8> out;
+
+    // Keep the ring non-empty so that region commands are held back for coalescing
+    queue->Push(MakeSwapCommand(1));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x1000, 0x100, 2));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x1100, 0x100, 3));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x1080, 0x200, 4));
+    REQUIRE(queue->Size() == 1);
+
+    queue->Publish();
+    REQUIRE(queue->Pop(out.data(), out.size()) == 2);
+    REQUIRE(out[0].type == CommandType::SwapBuffers);
+    REQUIRE(out[1].type == CommandType::FlushRegion);
+    REQUIRE(out[1].region.addr == 0x1000);
+    REQUIRE(out[1].region.size == 0x280);
+    REQUIRE(out[1].fence == 4);
+}
+
+TEST_CASE("CommandQueue keeps disjoint and mixed region commands apart",
+          "[video_core][gpu_thread]") {
+    auto queue = std::make_unique<CommandQueue>();
+    std::array<CommandRecord, 8> out;
+
+    queue->Push(MakeSwapCommand(1));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x1000, 0x100, 2));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x2000, 0x100, 3));
+    queue->Push(MakeRegionCommand(CommandType::InvalidateRegion, 0x2000, 0x100, 4));
+    queue->Push(MakeSwapCommand(5));
+
+    REQUIRE(queue->Pop(out.data(), out.size()) == 5);
+    REQUIRE(out[1].region.addr == 0x1000);
+    REQUIRE(out[2].region.addr == 0x2000);
+    REQUIRE(out[3].type == CommandType::InvalidateRegion);
+    REQUIRE(out[4].fence == 5);
+}
+
+TEST_CASE("CommandQueue does not hold back commands while the consumer is idle",
+          "[video_core][gpu_thread]") {
+    auto queue = std::make_unique<CommandQueue>();
+    std::array<CommandRecord, 8> out;
+
+    queue->Push(MakeRegionCommand(CommandType::InvalidateRegion, 0x1000, 0x100, 1));
+    REQUIRE(queue->Pop(out.data(), out.size()) == 1);
+    REQUIRE(out[0].fence == 1);
+}
+
+TEST_CASE("CommandQueue hands held back commands to an idle consumer",
+          "[video_core][gpu_thread]") {
+    auto queue = std::make_unique<CommandQueue>();
+    std::array<CommandRecord, 8> out;
+
+    // Held back behind the swap, and never published by the producer
+    queue->Push(MakeSwapCommand(1));
+    queue->Push(MakeRegionCommand(CommandType::FlushRegion, 0x1000, 0x100, 2));
+    REQUIRE(!queue->Empty());
+
+    // Not taken before the older commands in the ring
+    REQUIRE(!queue->PopPending(out[0]));
+    REQUIRE(queue->Pop(out.data(), out.size()) == 1);
+    REQUIRE(out[0].fence == 1);
+
+    REQUIRE(queue->PopPending(out[0]));
+    REQUIRE(out[0].type == CommandType::FlushRegion);
+    REQUIRE(out[0].fence == 2);
+    REQUIRE(queue->Empty());
+    REQUIRE(!queue->PopPending(out[0]));
+
+    // Publishing afterwards doesn't push it again
+    queue->Publish();
+    REQUIRE(queue->Pop(out.data(), out.size()) == 0);
+}
+
+// Throughput comparison against the previous node-allocating queue.
+TEST_CASE("CommandQueue throughput", "[.benchmark][gpu_thread]") {
+    constexpr u64 command_count = 1 << 22;
+    using Clock = std::chrono::steady_clock;
+
+    const auto bench_ring = [&] {
+        auto queue = std::make_unique<CommandQueue>();
+        const auto start = Clock::now();
+        std::thread consumer([&] {
+            std::array<CommandRecord, 64> batch;
+            u64 last_fence = 0;
+            while (last_fence != command_count) {
+                const std::size_t count = queue->Pop(batch.data(), batch.size());
+                if (count != 0) {
+                    last_fence = batch[count - 1].fence;
+                }
+            }
+        });
+        for (u64 fence = 1; fence <= command_count; ++fence) {
+            queue->Push(MakeSwapCommand(fence));
+        }
+        consumer.join();
+        return Clock::now() - start;
+    };
+
+    const auto bench_spsc = [&] {
+        Common::SPSCQueue<CommandRecord> queue;
+        const auto start = Clock::now();
+        std::thread consumer([&] {
+            CommandRecord record;
+            u64 last_fence = 0;
+            while (last_fence != command_count) {
+                if (queue.Pop(record)) {
+                    last_fence = record.fence;
+                }
+            }
+        });
+        for (u64 fence = 1; fence <= command_count; ++fence) {
+            queue.Push(MakeSwapCommand(fence));
+        }
+        consumer.join();
+        return Clock::now() - start;
+    };
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    const auto ring_us = duration_cast<microseconds>(bench_ring()).count();
+    const auto spsc_us = duration_cast<microseconds>(bench_spsc()).count();
+    WARN("CommandQueue: " << ring_us << "us, SPSCQueue: " << spsc_us << "us for " << command_count
+                          << " commands");
+}
@@ -3,16 +3,25 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <catch2/catch.hpp>
 #include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_jit_x64_batch_compiler.h"
+#include "video_core/shader/shader_jit_x64.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/video_core.h"
 
 using float24 = Pica::float24;
+using JitBatchShader = Pica::Shader::JitBatchShader;
 using JitShader = Pica::Shader::JitShader;
 
 using DestRegister = nihstro::DestRegister;
+using CompareOp = nihstro::Instruction::Common::CompareOpType::Op;
 using OpCode = nihstro::OpCode;
 using SourceRegister = nihstro::SourceRegister;
 
@@ -89,3 +98,532 @@ TEST_CASE("EX2", "[video_core][shader][shader_jit]") {
     REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
     REQUIRE(std::isinf(shader.Run(800.f)));
 }
+
+static std::unique_ptr<Pica::Shader::ShaderSetup> MakeShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    setup->program_code.fill(0);
+    setup->swizzle_data.fill(0);
+    std::transform(shbin.program.begin(), shbin.program.end(), setup->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    return setup;
+}
+
+static bool IsSameFloat(float24 a, float24 b) {
+    const float fa = a.ToFloat32();
+    const float fb = b.ToFloat32();
+    if (std::isnan(fa) || std::isnan(fb)) {
+        return std::isnan(fa) && std::isnan(fb);
+    }
+    return std::memcmp(&fa, &fb, sizeof(float)) == 0;
+}
+
+/// Sets the uniforms read by the batch tests. The loop counter uniform runs 4 iterations with aL
+/// going from 0 to 3.
+static void SetBatchUniforms(Pica::Shader::ShaderSetup& setup) {
+    setup.uniforms.f[0] = {float24::FromFloat32(0.5f), float24::FromFloat32(-2.f),
+                           float24::FromFloat32(INFINITY), float24::FromFloat32(3.f)};
+    for (int i = 1; i < 8; ++i) {
+        const float value = static_cast<float>(i);
+        setup.uniforms.f[i] = {float24::FromFloat32(value), float24::FromFloat32(-value),
+                               float24::FromFloat32(value * 2.f), float24::FromFloat32(value / 4)};
+    }
+    setup.uniforms.b.fill(false);
+    setup.uniforms.i.fill({3, 0, 1, 0});
+}
+
+/// Fills the first two input registers of a unit with exactly representable values, so that the
+/// order of additions doesn't matter, including 0 * inf which has to produce 0
+static void FillInputs(std::size_t unit, Pica::Shader::UnitState& state) {
+    static const float values[] = {1.f, -3.f, 0.5f, INFINITY, 0.f, 4.f, -0.25f, 2.f, 7.f, -1.f};
+    constexpr std::size_t num_values = sizeof(values) / sizeof(values[0]);
+
+    for (int reg = 0; reg < 2; ++reg) {
+        for (int comp = 0; comp < 4; ++comp) {
+            const float value = values[(unit * 3 + reg * 5 + comp) % num_values];
+            state.registers.input[reg][comp] = float24::FromFloat32(value);
+        }
+    }
+}
+
+using InputFiller = void (*)(std::size_t unit, Pica::Shader::UnitState& state);
+
+/**
+ * Runs a shader on a full batch with the batch JIT and checks that the first output register of
+ * every unit is bit-exact with the interpreter. If the units are expected to diverge, the batch JIT
+ * must instead leave them untouched, and the scalar JIT that the engine falls back to is checked.
+ */
+static void CheckBatchMatchesInterpreter(Pica::Shader::ShaderSetup& setup,
+                                         std::size_t batch_size, bool diverges = false,
+                                         InputFiller fill_inputs = FillInputs) {
+    const float24 unwritten = float24::FromFloat32(-100.f);
+    std::array<Pica::Shader::UnitState, Pica::Shader::MAX_BATCH_SIZE> units;
+    for (std::size_t unit = 0; unit < batch_size; ++unit) {
+        fill_inputs(unit, units[unit]);
+        units[unit].registers.output[0] = Common::Vec4<float24>::AssignToAll(unwritten);
+        units[unit].conditional_code[0] = units[unit].conditional_code[1] = false;
+        units[unit].address_registers[0] = units[unit].address_registers[1] = 0;
+        units[unit].address_registers[2] = 0;
+    }
+    auto expected = units;
+
+    Pica::Shader::InterpreterEngine interpreter;
+    interpreter.SetupBatch(setup, 0);
+    for (std::size_t unit = 0; unit < batch_size; ++unit) {
+        interpreter.Run(setup, expected[unit]);
+    }
+
+    JitBatchShader shader(batch_size);
+    shader.Compile(&setup.program_code, &setup.swizzle_data);
+    shader.PrepareEntryPoint(0);
+    if (diverges) {
+        REQUIRE(!shader.Run(setup, units.data(), 0));
+        for (std::size_t unit = 0; unit < batch_size; ++unit) {
+            REQUIRE(units[unit].registers.output[0].x.ToFloat32() == unwritten.ToFloat32());
+        }
+
+        JitShader scalar_shader;
+        scalar_shader.Compile(&setup.program_code, &setup.swizzle_data);
+        for (std::size_t unit = 0; unit < batch_size; ++unit) {
+            scalar_shader.Run(setup, units[unit], 0);
+        }
+    } else {
+        REQUIRE(shader.Run(setup, units.data(), 0));
+    }
+
+    for (std::size_t unit = 0; unit < batch_size; ++unit) {
+        for (int comp = 0; comp < 4; ++comp) {
+            INFO("unit " << unit << " component " << comp);
+            REQUIRE(IsSameFloat(units[unit].registers.output[0][comp],
+                                expected[unit].registers.output[0][comp]));
+        }
+    }
+}
+
+static void CheckBatchMatchesInterpreter(std::initializer_list<nihstro::InlineAsm> code,
+                                         std::size_t batch_size) {
+    auto setup = MakeShaderSetup(code);
+    SetBatchUniforms(*setup);
+    CheckBatchMatchesInterpreter(*setup, batch_size);
+}
+
+// The inline assembler doesn't encode flow control, comparisons or relative addressing, so the
+// tests below assemble placeholders and patch the instruction words, whose layout is:
+//  - opcode in bits 26-31, or 27-31 for CMP with the x and y comparisons in bits 24-26 and 21-23,
+//  - address register index in bits 19-20, and the source operands below it,
+//  - for flow control, condition or uniform id in bits 22-25, destination offset in bits 10-21,
+//    and number of instructions in bits 0-7.
+
+/// Condition fields of flow control instructions testing whether the x component of the
+/// conditional code is true (refx = 1, op = JustX) or false (refx = 0, op = JustX)
+constexpr u32 IF_X_TRUE = 0b1010;
+constexpr u32 IF_X_FALSE = 0b0010;
+
+/// Turns the placeholder at `offset` into a flow control instruction. `condition` is the uniform
+/// id for IFU, CALLU, JMPU and LOOP.
+static void PatchFlowControl(Pica::Shader::ShaderSetup& setup, u32 offset, OpCode::Id op,
+                             u32 dest_offset, u32 num_instructions = 0, u32 condition = 0) {
+    setup.program_code[offset] = (static_cast<u32>(op) << 26) | (condition << 22) |
+                                 (dest_offset << 10) | num_instructions;
+}
+
+/// Turns the arithmetic instruction at `offset` into a CMP of the same operands
+static void PatchCompare(Pica::Shader::ShaderSetup& setup, u32 offset, CompareOp x, CompareOp y) {
+    u32& code = setup.program_code[offset];
+    code = (code & 0x1FFFFF) | (static_cast<u32>(OpCode::Id::CMP) << 26) |
+           (static_cast<u32>(x) << 24) | (static_cast<u32>(y) << 21);
+}
+
+/// Changes the opcode of the instruction at `offset`, keeping its operands
+static void PatchOpCode(Pica::Shader::ShaderSetup& setup, u32 offset, OpCode::Id op) {
+    u32& code = setup.program_code[offset];
+    code = (code & 0x3FFFFFF) | (static_cast<u32>(op) << 26);
+}
+
+/// Makes the first source operand of the instruction at `offset` relative to an address register:
+/// 1 for a0.x, 2 for a0.y, 3 for aL
+static void PatchAddressRegister(Pica::Shader::ShaderSetup& setup, u32 offset, u32 index) {
+    u32& code = setup.program_code[offset];
+    code = (code & ~(0b11u << 19)) | (index << 19);
+}
+
+TEST_CASE("Batch arithmetic", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_input2 = SourceRegister::MakeInput(1);
+    const auto sh_uniform = SourceRegister::MakeFloat(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    for (std::size_t batch_size : {4, 8}) {
+        for (OpCode::Id op : {OpCode::Id::ADD, OpCode::Id::MUL, OpCode::Id::DP3, OpCode::Id::DP4,
+                              OpCode::Id::DPH, OpCode::Id::MAX, OpCode::Id::MIN, OpCode::Id::SGE,
+                              OpCode::Id::SLT}) {
+            INFO("batch size " << batch_size << " opcode " << static_cast<int>(op));
+            CheckBatchMatchesInterpreter({{op, sh_output, sh_input1, sh_input2}, {OpCode::Id::END}},
+                                         batch_size);
+            CheckBatchMatchesInterpreter({{op, sh_output, sh_input1, sh_uniform}, {OpCode::Id::END}},
+                                         batch_size);
+        }
+
+        for (OpCode::Id op : {OpCode::Id::MOV, OpCode::Id::FLR}) {
+            INFO("batch size " << batch_size << " opcode " << static_cast<int>(op));
+            CheckBatchMatchesInterpreter({{op, sh_output, sh_input1}, {OpCode::Id::END}},
+                                         batch_size);
+        }
+    }
+}
+
+TEST_CASE("Batch fallback", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // EX2 is not supported by the batch JIT, so the units must be left for the scalar JIT
+    auto setup = MakeShaderSetup({{OpCode::Id::EX2, sh_output, sh_input}, {OpCode::Id::END}});
+
+    std::array<Pica::Shader::UnitState, Pica::Shader::MAX_BATCH_SIZE> units;
+    for (auto& unit : units) {
+        unit.registers.input[0].x = float24::FromFloat32(2.f);
+        unit.registers.output[0].x = float24::FromFloat32(-1.f);
+        unit.address_registers[2] = 0;
+    }
+
+    JitBatchShader shader(8);
+    shader.Compile(&setup->program_code, &setup->swizzle_data);
+    shader.PrepareEntryPoint(0);
+    REQUIRE(!shader.Run(*setup, units.data(), 0));
+    for (const auto& unit : units) {
+        REQUIRE(unit.registers.output[0].x.ToFloat32() == -1.f);
+    }
+}
+
+TEST_CASE("Batch flow control", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_input2 = SourceRegister::MakeInput(1);
+    const auto sh_uniform = SourceRegister::MakeFloat(0);
+    const auto sh_temp0 = SourceRegister::MakeTemporary(0);
+    const auto sh_temp1 = SourceRegister::MakeTemporary(1);
+    const auto sh_dest_temp0 = DestRegister::MakeTemporary(0);
+    const auto sh_dest_temp1 = DestRegister::MakeTemporary(1);
+    const auto sh_dest_temp2 = DestRegister::MakeTemporary(2);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    for (std::size_t batch_size : {4, 8}) {
+        INFO("batch size " << batch_size);
+
+        // The compared operands are equal, so the conditional code is the same for all the units
+        auto if_setup = MakeShaderSetup({
+            // clang-format off
+            {OpCode::Id::MOV, sh_dest_temp1, sh_uniform},
+            {OpCode::Id::ADD, sh_dest_temp2, sh_uniform, sh_temp1}, // CMP
+            {OpCode::Id::NOP}, // IF
+            {OpCode::Id::ADD, sh_output, sh_input1, sh_input2},
+            {OpCode::Id::MUL, sh_output, sh_input1, sh_input2}, // ELSE
+            {OpCode::Id::END},
+            // clang-format on
+        });
+        SetBatchUniforms(*if_setup);
+        PatchCompare(*if_setup, 1, CompareOp::Equal, CompareOp::Equal);
+        for (u32 condition : {IF_X_TRUE, IF_X_FALSE}) {
+            PatchFlowControl(*if_setup, 2, OpCode::Id::IFC, 4, 1, condition);
+            CheckBatchMatchesInterpreter(*if_setup, batch_size);
+        }
+        for (bool uniform : {true, false}) {
+            if_setup->uniforms.b[0] = uniform;
+            PatchFlowControl(*if_setup, 2, OpCode::Id::IFU, 4, 1);
+            CheckBatchMatchesInterpreter(*if_setup, batch_size);
+        }
+
+        auto call_setup = MakeShaderSetup({
+            // clang-format off
+            {OpCode::Id::MOV, sh_dest_temp1, sh_uniform},
+            {OpCode::Id::ADD, sh_dest_temp2, sh_uniform, sh_temp1}, // CMP
+            {OpCode::Id::MOV, sh_dest_temp0, sh_input1},
+            {OpCode::Id::NOP}, // CALL
+            {OpCode::Id::MOV, sh_output, sh_temp0},
+            {OpCode::Id::END},
+            {OpCode::Id::MUL, sh_dest_temp0, sh_temp0, sh_input2},
+            // clang-format on
+        });
+        SetBatchUniforms(*call_setup);
+        PatchCompare(*call_setup, 1, CompareOp::Equal, CompareOp::Equal);
+        PatchFlowControl(*call_setup, 3, OpCode::Id::CALL, 6, 1);
+        CheckBatchMatchesInterpreter(*call_setup, batch_size);
+        for (u32 condition : {IF_X_TRUE, IF_X_FALSE}) {
+            PatchFlowControl(*call_setup, 3, OpCode::Id::CALLC, 6, 1, condition);
+            CheckBatchMatchesInterpreter(*call_setup, batch_size);
+        }
+        for (bool uniform : {true, false}) {
+            call_setup->uniforms.b[0] = uniform;
+            PatchFlowControl(*call_setup, 3, OpCode::Id::CALLU, 6, 1);
+            CheckBatchMatchesInterpreter(*call_setup, batch_size);
+        }
+
+        auto jump_setup = MakeShaderSetup({
+            // clang-format off
+            {OpCode::Id::MOV, sh_dest_temp1, sh_uniform},
+            {OpCode::Id::ADD, sh_dest_temp2, sh_uniform, sh_temp1}, // CMP
+            {OpCode::Id::MOV, sh_dest_temp0, sh_input1},
+            {OpCode::Id::NOP}, // JMP
+            {OpCode::Id::MUL, sh_dest_temp0, sh_temp0, sh_input2},
+            {OpCode::Id::MOV, sh_output, sh_temp0},
+            {OpCode::Id::END},
+            // clang-format on
+        });
+        SetBatchUniforms(*jump_setup);
+        PatchCompare(*jump_setup, 1, CompareOp::Equal, CompareOp::Equal);
+        for (u32 condition : {IF_X_TRUE, IF_X_FALSE}) {
+            PatchFlowControl(*jump_setup, 3, OpCode::Id::JMPC, 5, 0, condition);
+            CheckBatchMatchesInterpreter(*jump_setup, batch_size);
+        }
+        for (u32 inverted : {0, 1}) {
+            PatchFlowControl(*jump_setup, 3, OpCode::Id::JMPU, 5, inverted);
+            CheckBatchMatchesInterpreter(*jump_setup, batch_size);
+        }
+
+        // The loop body accumulates c[aL] for aL going from 0 to 3
+        auto loop_setup = MakeShaderSetup({
+            // clang-format off
+            {OpCode::Id::MOV, sh_dest_temp0, sh_input1},
+            {OpCode::Id::NOP}, // LOOP
+            {OpCode::Id::ADD, sh_dest_temp0, sh_uniform, sh_temp0}, // c[aL]
+            {OpCode::Id::MOV, sh_output, sh_temp0},
+            {OpCode::Id::END},
+            // clang-format on
+        });
+        SetBatchUniforms(*loop_setup);
+        PatchFlowControl(*loop_setup, 1, OpCode::Id::LOOP, 2);
+        PatchAddressRegister(*loop_setup, 2, 3);
+        CheckBatchMatchesInterpreter(*loop_setup, batch_size);
+
+        // The loop breaks when c[aL] equals c2 (refx = 1) or differs from it (refx = 0)
+        auto break_setup = MakeShaderSetup({
+            // clang-format off
+            {OpCode::Id::MOV, sh_dest_temp0, sh_input1},
+            {OpCode::Id::MOV, sh_dest_temp1, SourceRegister::MakeFloat(2)},
+            {OpCode::Id::NOP}, // LOOP
+            {OpCode::Id::ADD, sh_dest_temp0, sh_temp0, sh_input2},
+            {OpCode::Id::ADD, sh_dest_temp2, sh_uniform, sh_temp1}, // CMP c[aL]
+            {OpCode::Id::NOP}, // BREAKC
+            {OpCode::Id::MOV, sh_output, sh_temp0},
+            {OpCode::Id::END},
+            // clang-format on
+        });
+        SetBatchUniforms(*break_setup);
+        PatchFlowControl(*break_setup, 2, OpCode::Id::LOOP, 5);
+        PatchCompare(*break_setup, 4, CompareOp::Equal, CompareOp::Equal);
+        PatchAddressRegister(*break_setup, 4, 3);
+        for (u32 condition : {IF_X_TRUE, IF_X_FALSE}) {
+            PatchFlowControl(*break_setup, 5, OpCode::Id::BREAKC, 0, 0, condition);
+            CheckBatchMatchesInterpreter(*break_setup, batch_size);
+        }
+    }
+}
+
+TEST_CASE("Batch divergence", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_input2 = SourceRegister::MakeInput(1);
+    const auto sh_temp0 = SourceRegister::MakeTemporary(0);
+    const auto sh_dest_temp0 = DestRegister::MakeTemporary(0);
+    const auto sh_dest_temp1 = DestRegister::MakeTemporary(1);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // The inputs of FillInputs give input1.x < input2.x for the first unit but not the second, so
+    // the units take different branches
+    auto setup = MakeShaderSetup({
+        // clang-format off
+        {OpCode::Id::ADD, sh_dest_temp1, sh_input1, sh_input2}, // CMP
+        {OpCode::Id::MOV, sh_dest_temp0, sh_input1},
+        {OpCode::Id::NOP}, // IF, CALL or JMP
+        {OpCode::Id::ADD, sh_dest_temp0, sh_temp0, sh_input2},
+        {OpCode::Id::MUL, sh_dest_temp0, sh_temp0, sh_input2},
+        {OpCode::Id::MOV, sh_output, sh_temp0},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+    SetBatchUniforms(*setup);
+    PatchCompare(*setup, 0, CompareOp::LessThan, CompareOp::LessThan);
+
+    for (std::size_t batch_size : {4, 8}) {
+        INFO("batch size " << batch_size);
+        for (u32 condition : {IF_X_TRUE, IF_X_FALSE}) {
+            PatchFlowControl(*setup, 2, OpCode::Id::IFC, 4, 1, condition);
+            CheckBatchMatchesInterpreter(*setup, batch_size, true);
+            PatchFlowControl(*setup, 2, OpCode::Id::CALLC, 4, 1, condition);
+            CheckBatchMatchesInterpreter(*setup, batch_size, true);
+            PatchFlowControl(*setup, 2, OpCode::Id::JMPC, 4, 0, condition);
+            CheckBatchMatchesInterpreter(*setup, batch_size, true);
+        }
+    }
+}
+
+/// Loads a0.x with 0, 1 or 2 and a0.y with 0 or 1, depending on the unit
+static void FillAddressInputs(std::size_t unit, Pica::Shader::UnitState& state) {
+    FillInputs(unit, state);
+    state.registers.input[0].x = float24::FromFloat32(static_cast<float>(unit % 3));
+    state.registers.input[0].y = float24::FromFloat32(static_cast<float>(unit % 2));
+}
+
+TEST_CASE("Batch relative addressing", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_temp1 = SourceRegister::MakeTemporary(1);
+    const auto sh_dest_temp0 = DestRegister::MakeTemporary(0);
+    const auto sh_dest_temp1 = DestRegister::MakeTemporary(1);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // Each unit reads c[1 + a0.x] and v[0 + a0.y] with its own address registers
+    auto setup = MakeShaderSetup({
+        // clang-format off
+        {OpCode::Id::MOV, sh_dest_temp0, sh_input1}, // MOVA
+        {OpCode::Id::MOV, sh_dest_temp1, SourceRegister::MakeFloat(1)}, // c[1 + a0.x]
+        {OpCode::Id::ADD, sh_output, sh_input1, sh_temp1}, // v[0 + a0.y]
+        {OpCode::Id::END},
+        // clang-format on
+    });
+    SetBatchUniforms(*setup);
+    PatchOpCode(*setup, 0, OpCode::Id::MOVA);
+    PatchAddressRegister(*setup, 1, 1);
+    PatchAddressRegister(*setup, 2, 2);
+
+    for (std::size_t batch_size : {4, 8}) {
+        INFO("batch size " << batch_size);
+        CheckBatchMatchesInterpreter(*setup, batch_size, false, FillAddressInputs);
+    }
+}
+
+TEST_CASE("Batch cache keeps the shaders of other setups", "[video_core][shader][shader_jit]") {
+    if (!JitBatchShader::IsSupported()) {
+        return;
+    }
+
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+    const std::initializer_list<nihstro::InlineAsm> code = {{OpCode::Id::MOV, sh_output, sh_input},
+                                                            {OpCode::Id::END}};
+
+    const u32 batch_size = VideoCore::g_shader_jit_batch_size;
+    VideoCore::g_shader_jit_batch_size = 4;
+    Pica::Shader::JitX64Engine engine;
+    auto gs_setup = MakeShaderSetup(code);
+    auto vs_setup = MakeShaderSetup(code);
+    engine.SetupBatch(*gs_setup, 0);
+
+    // Enough distinct programs on the other setup to evict every batch shader it compiled
+    for (u32 i = 0; i < 64; ++i) {
+        vs_setup->program_code[Pica::Shader::MAX_PROGRAM_CODE_LENGTH - 1] = i;
+        vs_setup->MarkProgramCodeDirty();
+        engine.SetupBatch(*vs_setup, 0);
+    }
+
+    REQUIRE(engine.BatchSize(*gs_setup) == 4);
+    std::array<Pica::Shader::UnitState, 4> units;
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        units[i].registers.input[0].x = float24::FromFloat32(static_cast<float>(i));
+        units[i].registers.output[0].x = float24::FromFloat32(-1.f);
+        units[i].address_registers[2] = 0;
+    }
+    engine.RunBatch(*gs_setup, units.data(), units.size());
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        REQUIRE(units[i].registers.output[0].x.ToFloat32() == static_cast<float>(i));
+    }
+    VideoCore::g_shader_jit_batch_size = batch_size;
+}
+
+TEST_CASE("Image round trip", "[video_core][shader][shader_jit]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp = SourceRegister::MakeTemporary(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // LG2 and MUL use constants stored in the code, which must still be found once it is moved
+    auto setup = MakeShaderSetup({
+        // clang-format off
+        {OpCode::Id::LG2, DestRegister::MakeTemporary(0), sh_input},
+        {OpCode::Id::MUL, sh_output, sh_temp, sh_temp},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    auto compiled = std::make_unique<JitShader>();
+    compiled->Compile(&setup->program_code, &setup->swizzle_data);
+    const Pica::Shader::JitShaderImage image = compiled->GetImage();
+    compiled.reset();
+
+    JitShader loaded;
+    loaded.LoadImage(image);
+
+    Pica::Shader::UnitState unit;
+    unit.registers.input[0].x = float24::FromFloat32(8.f);
+    loaded.Run(*setup, unit, 0);
+    REQUIRE(unit.registers.output[0].x.ToFloat32() == Approx(9.f));
+}
+
+// Compares the time to compile a shader with the time to load it from an image, as done by the
+// disk cache at boot.
+TEST_CASE("Shader image load time", "[.benchmark][shader_jit]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int iterations = 1000;
+
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_temp = SourceRegister::MakeTemporary(0);
+    auto setup = MakeShaderSetup({
+        // clang-format off
+        {OpCode::Id::MUL, DestRegister::MakeTemporary(0), sh_input, sh_temp},
+        {OpCode::Id::LG2, DestRegister::MakeOutput(0), sh_temp},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    // Repeat the body to get a program similar in size to the vertex shaders of commercial games
+    constexpr std::size_t body_size = 2;
+    constexpr std::size_t repeats = 200;
+    const u32 end_instruction = setup->program_code[body_size];
+    for (std::size_t i = 1; i < repeats; ++i) {
+        std::copy_n(setup->program_code.begin(), body_size,
+                    setup->program_code.begin() + i * body_size);
+    }
+    setup->program_code[repeats * body_size] = end_instruction;
+
+    Pica::Shader::JitShaderImage image;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        JitShader shader;
+        shader.Compile(&setup->program_code, &setup->swizzle_data);
+        image = shader.GetImage();
+    }
+    const auto compile_time = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        JitShader shader;
+        shader.LoadImage(image);
+    }
+    const auto load_time = Clock::now() - start;
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    WARN("Compile: " << duration_cast<microseconds>(compile_time).count() / iterations
+                     << "us, load: " << duration_cast<microseconds>(load_time).count() / iterations
+                     << "us per shader");
+}
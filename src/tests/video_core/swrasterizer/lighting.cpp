@@ -0,0 +1,103 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/lighting.h"
+
+using Pica::LightingRegs;
+
+TEST_CASE("Float lighting LUTs follow the LUT entries", "[video_core][swrasterizer]") {
+    auto lighting = std::make_unique<Pica::State::Lighting>();
+    std::mt19937 rng(1234);
+
+    const auto FloatLutsMatch = [&] {
+        for (std::size_t lut = 0; lut < lighting->luts.size(); ++lut) {
+            for (std::size_t index = 0; index < lighting->luts[lut].size(); ++index) {
+                const auto& entry = lighting->luts[lut][index];
+                const auto& float_entry = lighting->float_luts[lut][index];
+                if (float_entry.x != entry.ToFloat() || float_entry.y != entry.DiffToFloat()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    for (std::size_t lut = 0; lut < lighting->luts.size(); ++lut) {
+        for (std::size_t index = 0; index < lighting->luts[lut].size(); ++index) {
+            lighting->SetLutEntry(lut, index, static_cast<u32>(rng()));
+        }
+    }
+    REQUIRE(FloatLutsMatch());
+
+    // Entries written directly, like when loading a savestate, are converted by UpdateFloatLuts
+    for (auto& lut : lighting->luts) {
+        for (auto& entry : lut) {
+            entry.raw = static_cast<u32>(rng());
+        }
+    }
+    REQUIRE(!FloatLutsMatch());
+    lighting->UpdateFloatLuts();
+    REQUIRE(FloatLutsMatch());
+}
+
+// Measures the number of fragments lit per second with 8 lights using every LUT.
+TEST_CASE("Fragment lighting throughput", "[.benchmark][swrasterizer]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t num_fragments = 1 << 18;
+
+    LightingRegs regs{};
+    auto lighting = std::make_unique<Pica::State::Lighting>();
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    regs.max_light_index.Assign(7);
+    regs.config0.config.Assign(LightingRegs::LightingConfig::Config7);
+    regs.config0.enable_primary_alpha.Assign(1);
+    regs.light_enable.slot_1.Assign(1);
+    regs.light_enable.slot_2.Assign(2);
+    regs.light_enable.slot_3.Assign(3);
+    regs.light_enable.slot_4.Assign(4);
+    regs.light_enable.slot_5.Assign(5);
+    regs.light_enable.slot_6.Assign(6);
+    regs.light_enable.slot_7.Assign(7);
+    for (auto& light : regs.light) {
+        for (auto* color : {&light.specular_0, &light.specular_1, &light.diffuse, &light.ambient}) {
+            color->r.Assign(rng() % 256);
+            color->g.Assign(rng() % 256);
+            color->b.Assign(rng() % 256);
+        }
+        light.x.Assign(0x3C00); // 1.0 in float16
+        light.dist_atten_scale.Assign(0x3F000);
+    }
+    for (std::size_t lut = 0; lut < lighting->luts.size(); ++lut) {
+        for (std::size_t index = 0; index < lighting->luts[lut].size(); ++index) {
+            lighting->SetLutEntry(lut, index, static_cast<u32>(rng()));
+        }
+    }
+
+    std::vector<std::pair<Common::Quaternion<float>, Common::Vec3<float>>> fragments(
+        num_fragments);
+    for (auto& [normquat, view] : fragments) {
+        normquat = {{dist(rng), dist(rng), dist(rng)}, dist(rng)};
+        view = {dist(rng), dist(rng), dist(rng)};
+    }
+    const Common::Vec4<u8> texture_color[4]{};
+
+    u32 checksum = 0;
+    const auto start = Clock::now();
+    for (const auto& [normquat, view] : fragments) {
+        const auto [diffuse, specular] =
+            Pica::ComputeFragmentsColors(regs, *lighting, normquat, view, texture_color);
+        checksum += diffuse.r() + specular.g();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WARN(num_fragments / seconds / 1e6 << " Mfragments/s (checksum " << checksum << ")");
+}
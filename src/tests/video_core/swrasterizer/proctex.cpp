@@ -0,0 +1,124 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/proctex.h"
+
+using Pica::TexturingRegs;
+using ProcTexLutTable = TexturingRegs::ProcTexLutTable;
+
+static bool FloatLutsMatch(const Pica::State::ProcTex& proctex) {
+    const auto ValueLutMatches = [](const auto& lut, const auto& float_lut) {
+        for (std::size_t index = 0; index < lut.size(); ++index) {
+            if (float_lut[index].x != lut[index].ToFloat() ||
+                float_lut[index].y != lut[index].DiffToFloat()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const auto ColorLutMatches = [](const auto& lut, const auto& float_lut) {
+        for (std::size_t index = 0; index < lut.size(); ++index) {
+            const auto color = lut[index].ToVector().template Cast<float>();
+            for (std::size_t i = 0; i < 4; ++i) {
+                if (float_lut[index][i] != color[i]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    return ValueLutMatches(proctex.noise_table, proctex.float_noise_table) &&
+           ValueLutMatches(proctex.color_map_table, proctex.float_color_map_table) &&
+           ValueLutMatches(proctex.alpha_map_table, proctex.float_alpha_map_table) &&
+           ColorLutMatches(proctex.color_table, proctex.float_color_table) &&
+           ColorLutMatches(proctex.color_diff_table, proctex.float_color_diff_table);
+}
+
+TEST_CASE("Float ProcTex LUTs follow the LUT entries", "[video_core][swrasterizer]") {
+    auto proctex = std::make_unique<Pica::State::ProcTex>();
+    std::mt19937 rng(1234);
+
+    // Indices wrap around the size of each LUT, like the LUT index register
+    for (const auto table : {ProcTexLutTable::Noise, ProcTexLutTable::ColorMap,
+                             ProcTexLutTable::AlphaMap, ProcTexLutTable::Color,
+                             ProcTexLutTable::ColorDiff}) {
+        for (std::size_t index = 0; index < 512; ++index) {
+            proctex->SetLutEntry(table, index, static_cast<u32>(rng()));
+        }
+    }
+    REQUIRE(FloatLutsMatch(*proctex));
+
+    // Entries written directly, like when loading a savestate, are converted by UpdateFloatLuts
+    for (auto& entry : proctex->color_map_table) {
+        entry.raw = static_cast<u32>(rng());
+    }
+    for (auto& entry : proctex->color_diff_table) {
+        entry.raw = static_cast<u32>(rng());
+    }
+    REQUIRE(!FloatLutsMatch(*proctex));
+    proctex->UpdateFloatLuts();
+    REQUIRE(FloatLutsMatch(*proctex));
+}
+
+// Measures the number of procedural texture samples per second, with noise and separate alpha.
+TEST_CASE("Procedural texture throughput", "[.benchmark][swrasterizer]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t num_samples = 1 << 20;
+
+    TexturingRegs regs{};
+    auto proctex = std::make_unique<Pica::State::ProcTex>();
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+
+    regs.proctex.u_clamp.Assign(TexturingRegs::ProcTexClamp::MirroredRepeat);
+    regs.proctex.v_clamp.Assign(TexturingRegs::ProcTexClamp::SymmetricalRepeat);
+    regs.proctex.color_combiner.Assign(TexturingRegs::ProcTexCombiner::RMax);
+    regs.proctex.alpha_combiner.Assign(TexturingRegs::ProcTexCombiner::Add2);
+    regs.proctex.separate_alpha.Assign(1);
+    regs.proctex.noise_enable.Assign(1);
+    regs.proctex.u_shift.Assign(TexturingRegs::ProcTexShift::Odd);
+    regs.proctex_noise_u.amplitude.Assign(0x400);
+    regs.proctex_noise_u.phase.Assign(0x3400); // 0.25 in float16
+    regs.proctex_noise_v.amplitude.Assign(0x300);
+    regs.proctex_noise_v.phase.Assign(0x3800); // 0.5 in float16
+    regs.proctex_noise_frequency.u.Assign(0x4000); // 2.0 in float16
+    regs.proctex_noise_frequency.v.Assign(0x4200); // 3.0 in float16
+    regs.proctex_lut.filter.Assign(TexturingRegs::ProcTexFilter::Linear);
+    regs.proctex_lut.width.Assign(128);
+
+    // The map LUTs are increasing ramps from 0 to 1, so that the color LUT is indexed in range
+    for (u32 index = 0; index < 128; ++index) {
+        const u32 ramp = (index * 32) | (32 << 12);
+        proctex->SetLutEntry(ProcTexLutTable::Noise, index, static_cast<u32>(rng()));
+        proctex->SetLutEntry(ProcTexLutTable::ColorMap, index, ramp);
+        proctex->SetLutEntry(ProcTexLutTable::AlphaMap, index, ramp);
+    }
+    for (u32 index = 0; index < 256; ++index) {
+        proctex->SetLutEntry(ProcTexLutTable::Color, index, static_cast<u32>(rng()));
+        proctex->SetLutEntry(ProcTexLutTable::ColorDiff, index, static_cast<u32>(rng()));
+    }
+
+    std::vector<std::pair<float, float>> coordinates(num_samples);
+    for (auto& [u, v] : coordinates) {
+        u = dist(rng);
+        v = dist(rng);
+    }
+
+    u32 checksum = 0;
+    const auto start = Clock::now();
+    for (const auto& [u, v] : coordinates) {
+        const auto color = Pica::Rasterizer::ProcTex(u, v, regs, *proctex);
+        checksum += color.r() + color.a();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    WARN(num_samples / seconds / 1e6 << " Msamples/s (checksum " << checksum << ")");
+}
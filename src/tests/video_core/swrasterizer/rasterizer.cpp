@@ -0,0 +1,152 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/video_core.h"
+
+using Pica::FramebufferRegs;
+using Pica::Rasterizer::Vertex;
+
+constexpr u32 FB_WIDTH = 256;
+constexpr u32 FB_HEIGHT = 240;
+constexpr u32 FB_SIZE = FB_WIDTH * FB_HEIGHT * 4;
+
+static void SetupBlendedDraw() {
+    auto& regs = Pica::g_state.regs;
+    std::memset(&regs, 0, sizeof(regs));
+
+    regs.lighting.disable.Assign(1);
+
+    auto& framebuffer = regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(0xF);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.color_buffer_address.Assign(Memory::VRAM_PADDR / 8);
+    framebuffer.width.Assign(FB_WIDTH);
+    framebuffer.height.Assign(FB_HEIGHT - 1);
+
+    // Alpha blending makes the result depend on the order in which triangles are drawn
+    using BlendFactor = FramebufferRegs::BlendFactor;
+    auto& output_merger = regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_dest_a.Assign(BlendFactor::OneMinusSourceAlpha);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+}
+
+static std::vector<Vertex> MakeTriangles(std::size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> x_dist(0.f, FB_WIDTH - 1.f);
+    std::uniform_real_distribution<float> y_dist(0.f, FB_HEIGHT - 1.f);
+    std::uniform_real_distribution<float> unit_dist(0.f, 1.f);
+
+    std::vector<Vertex> vertices;
+    for (std::size_t i = 0; i < count * 3; ++i) {
+        Pica::Shader::OutputVertex output{};
+        output.pos.w = Pica::float24::FromFloat32(1.f);
+        for (int c = 0; c < 4; ++c) {
+            output.color[c] = Pica::float24::FromFloat32(unit_dist(rng));
+        }
+
+        Vertex vertex(output);
+        vertex.screenpos = Common::MakeVec(Pica::float24::FromFloat32(x_dist(rng)),
+                                           Pica::float24::FromFloat32(y_dist(rng)),
+                                           Pica::float24::FromFloat32(unit_dist(rng)));
+        vertices.push_back(vertex);
+    }
+    return vertices;
+}
+
+static std::vector<Vertex> MakeFullscreenQuad() {
+    std::vector<Vertex> vertices;
+    const float corners[6][2] = {{0, 0}, {FB_WIDTH, 0},         {FB_WIDTH, FB_HEIGHT},
+                                 {0, 0}, {FB_WIDTH, FB_HEIGHT}, {0, FB_HEIGHT}};
+    for (const auto& corner : corners) {
+        Pica::Shader::OutputVertex output{};
+        output.pos.w = Pica::float24::FromFloat32(1.f);
+        for (int c = 0; c < 4; ++c) {
+            output.color[c] = Pica::float24::FromFloat32(corner[0] / FB_WIDTH);
+        }
+
+        Vertex vertex(output);
+        vertex.screenpos = Common::MakeVec(Pica::float24::FromFloat32(corner[0]),
+                                           Pica::float24::FromFloat32(corner[1]),
+                                           Pica::float24::FromFloat32(0.5f));
+        vertices.push_back(vertex);
+    }
+    return vertices;
+}
+
+static std::vector<u8> Draw(Memory::MemorySystem& memory, const std::vector<Vertex>& vertices) {
+    u8* framebuffer = memory.GetPhysicalPointer(Memory::VRAM_PADDR);
+    std::memset(framebuffer, 0, FB_SIZE);
+
+    for (std::size_t i = 0; i < vertices.size(); i += 3) {
+        Pica::Rasterizer::ProcessTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+    }
+    Pica::Rasterizer::FlushTriangles();
+
+    return std::vector<u8>(framebuffer, framebuffer + FB_SIZE);
+}
+
+TEST_CASE("Tiled rasterization matches serial rasterization", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupBlendedDraw();
+
+    const auto vertices = MakeTriangles(200);
+
+    VideoCore::g_parallel_rasterization_enabled = false;
+    const auto serial = Draw(memory, vertices);
+
+    VideoCore::g_parallel_rasterization_enabled = true;
+    const auto tiled = Draw(memory, vertices);
+    VideoCore::g_parallel_rasterization_enabled = false;
+
+    REQUIRE(std::any_of(serial.begin(), serial.end(), [](u8 byte) { return byte != 0; }));
+    REQUIRE(serial == tiled);
+
+    VideoCore::g_memory = nullptr;
+}
+
+// Measures the number of pixels drawn per second by the software rasterizer, with alpha blending.
+TEST_CASE("Rasterizer pixel throughput", "[.benchmark][swrasterizer]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int iterations = 200;
+
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupBlendedDraw();
+
+    const auto vertices = MakeFullscreenQuad();
+
+    for (const bool parallel : {false, true}) {
+        VideoCore::g_parallel_rasterization_enabled = parallel;
+
+        const auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            Draw(memory, vertices);
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const double pixels = static_cast<double>(iterations) * FB_WIDTH * FB_HEIGHT;
+        WARN((parallel ? "Tiled" : "Serial")
+             << " rasterization: " << pixels / seconds / 1e6 << " Mpixels/s");
+    }
+    VideoCore::g_parallel_rasterization_enabled = false;
+
+    VideoCore::g_memory = nullptr;
+}
@@ -0,0 +1,143 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <catch2/catch.hpp>
+#include "video_core/swrasterizer/rasterizer_x64.h"
+
+using Pica::float24;
+using Pica::Rasterizer::PixelInputs;
+using Pica::Rasterizer::QUAD_WIDTH;
+using Pica::Rasterizer::QuadSetup;
+
+static bool SameFloat(float a, float b) {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+/// Computes the inputs of one pixel the same way as RasterizeTriangle, with float24 operations
+static bool ComputeReferenceInputs(const QuadSetup& setup, u32 x, u32 y, PixelInputs& inputs) {
+    const auto SignedArea = [&](int a, int b) {
+        return static_cast<int>(static_cast<u32>(setup.x[b] - setup.x[a]) * (y - setup.y[a]) -
+                                static_cast<u32>(setup.y[b] - setup.y[a]) * (x - setup.x[a]));
+    };
+    const int w0 = setup.bias[0] + SignedArea(1, 2);
+    const int w1 = setup.bias[1] + SignedArea(2, 0);
+    const int w2 = setup.bias[2] + SignedArea(0, 1);
+    const int wsum = w0 + w1 + w2;
+    if (w0 < 0 || w1 < 0 || w2 < 0) {
+        return false;
+    }
+
+    const auto bary = Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                                      float24::FromFloat32(static_cast<float>(w1)),
+                                      float24::FromFloat32(static_cast<float>(w2)));
+    const auto Dot = [&](const std::array<float, 3>& attr) {
+        return Common::Dot(Common::MakeVec(float24::FromFloat32(attr[0]),
+                                           float24::FromFloat32(attr[1]),
+                                           float24::FromFloat32(attr[2])),
+                           bary);
+    };
+    const float24 w_inverse = float24::FromFloat32(1.0f) / Dot(setup.w_inverse);
+
+    float depth = (setup.z[0] * w0 + setup.z[1] * w1 + setup.z[2] * w2) / wsum;
+    depth = depth * setup.depth_scale + setup.depth_offset;
+    if (setup.w_buffer) {
+        depth *= w_inverse.ToFloat32() * wsum;
+    }
+
+    inputs.baricentric_coordinates = bary;
+    inputs.interpolated_w_inverse = w_inverse;
+    inputs.depth = std::clamp(depth, 0.0f, 1.0f);
+    for (std::size_t i = 0; i < 4; ++i) {
+        inputs.primary_color[i] =
+            static_cast<u8>(std::round((Dot(setup.color[i]) * w_inverse).ToFloat32() * 255));
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+        inputs.uv[i] = {Dot(setup.tc[i * 2]) * w_inverse, Dot(setup.tc[i * 2 + 1]) * w_inverse};
+    }
+    return true;
+}
+
+TEST_CASE("Quad inputs match per-pixel interpolation", "[video_core][swrasterizer]") {
+    if (!Pica::Rasterizer::IsQuadRasterizationSupported()) {
+        return;
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<s32> position_dist(0, 0x1000);
+    std::uniform_real_distribution<float> unit_dist(0.f, 1.f);
+    std::uniform_real_distribution<float> signed_dist(-2.f, 2.f);
+
+    for (int triangle = 0; triangle < 1000; ++triangle) {
+        QuadSetup setup{};
+        for (std::size_t i = 0; i < 3; ++i) {
+            setup.x[i] = position_dist(rng);
+            setup.y[i] = position_dist(rng);
+            setup.bias[i] = -static_cast<s32>(rng() % 2);
+            // Some vertices at infinity exercise the float24 multiplication of 0 by infinity
+            setup.w_inverse[i] = triangle % 7 == 0 ? 0.f : unit_dist(rng) * 4.f;
+            setup.z[i] = signed_dist(rng);
+            for (auto& channel : setup.color) {
+                channel[i] = unit_dist(rng);
+            }
+            for (auto& component : setup.tc) {
+                component[i] =
+                    triangle % 11 == 0 ? std::numeric_limits<float>::infinity() : signed_dist(rng);
+            }
+        }
+        setup.depth_scale = signed_dist(rng);
+        setup.depth_offset = signed_dist(rng);
+        setup.w_buffer = triangle % 2 == 0;
+        setup.scissor_exclude = triangle % 5 == 0;
+        setup.scissor_x1 = 0x100;
+        setup.scissor_y1 = 0x100;
+        setup.scissor_x2 = 0x800;
+        setup.scissor_y2 = 0x800;
+
+        for (int quad = 0; quad < 32; ++quad) {
+            const u32 x = (position_dist(rng) & ~0xF) + 8;
+            const u32 y = (position_dist(rng) & ~0xF) + 8;
+            const u32 end_x = x + rng() % (QUAD_WIDTH * 0x10);
+
+            std::array<PixelInputs, QUAD_WIDTH> inputs;
+            const u32 mask = Pica::Rasterizer::ComputeQuadInputs(setup, x, y, end_x, inputs);
+
+            for (u32 lane = 0; lane < QUAD_WIDTH; ++lane) {
+                const u32 pixel_x = x + lane * 0x10;
+                const bool excluded = setup.scissor_exclude &&
+                                      static_cast<s32>(pixel_x) >= setup.scissor_x1 &&
+                                      static_cast<s32>(pixel_x) < setup.scissor_x2 &&
+                                      static_cast<s32>(y) >= setup.scissor_y1 &&
+                                      static_cast<s32>(y) < setup.scissor_y2;
+
+                PixelInputs expected;
+                const bool covered = pixel_x < end_x && !excluded &&
+                                     ComputeReferenceInputs(setup, pixel_x, y, expected);
+                REQUIRE(((mask >> lane) & 1) == covered);
+                if (!covered) {
+                    continue;
+                }
+
+                const PixelInputs& actual = inputs[lane];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    REQUIRE(actual.baricentric_coordinates[i].ToFloat32() ==
+                            expected.baricentric_coordinates[i].ToFloat32());
+                    REQUIRE(SameFloat(actual.uv[i].u().ToFloat32(),
+                                      expected.uv[i].u().ToFloat32()));
+                    REQUIRE(SameFloat(actual.uv[i].v().ToFloat32(),
+                                      expected.uv[i].v().ToFloat32()));
+                }
+                REQUIRE(SameFloat(actual.interpolated_w_inverse.ToFloat32(),
+                                  expected.interpolated_w_inverse.ToFloat32()));
+                REQUIRE(SameFloat(actual.depth, expected.depth));
+                for (std::size_t i = 0; i < 4; ++i) {
+                    REQUIRE(actual.primary_color[i] == expected.primary_color[i]);
+                }
+            }
+        }
+    }
+}
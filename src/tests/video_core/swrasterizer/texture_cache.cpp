@@ -0,0 +1,151 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/video_core.h"
+
+using Pica::Rasterizer::DecodedTexture;
+using Pica::Rasterizer::TextureCache;
+using Pica::Texture::TextureInfo;
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+static TextureInfo MakeTexture(Memory::MemorySystem& memory, TextureFormat format, u32 seed) {
+    TextureInfo info;
+    info.physical_address = Memory::VRAM_PADDR;
+    info.width = 64;
+    info.height = 32;
+    info.format = format;
+    info.SetDefaultStride();
+
+    std::mt19937 rng(seed);
+    u8* data = memory.GetPhysicalPointer(info.physical_address);
+    for (u32 i = 0; i < info.stride * info.height / 8; ++i) {
+        data[i] = static_cast<u8>(rng());
+    }
+    return info;
+}
+
+static bool MatchesMemory(Memory::MemorySystem& memory, const DecodedTexture& texture) {
+    const u8* data = memory.GetPhysicalPointer(texture.info.physical_address);
+    for (u32 t = 0; t < texture.info.height; ++t) {
+        for (u32 s = 0; s < texture.info.width; ++s) {
+            const auto expected = Pica::Texture::LookupTexture(data, s, t, texture.info);
+            const auto actual = texture.Lookup(s, t);
+            for (std::size_t i = 0; i < 4; ++i) {
+                if (actual[i] != expected[i]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+TEST_CASE("Decoded textures match LookupTexture", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    TextureCache cache;
+
+    for (const auto format : {TextureFormat::RGBA8, TextureFormat::RGB565, TextureFormat::IA8,
+                              TextureFormat::I4, TextureFormat::ETC1, TextureFormat::ETC1A4}) {
+        const TextureInfo info = MakeTexture(memory, format, static_cast<u32>(format));
+        const DecodedTexture* texture = cache.GetTexture(info);
+        REQUIRE(texture != nullptr);
+        REQUIRE(MatchesMemory(memory, *texture));
+    }
+
+    cache.Clear();
+    VideoCore::g_memory = nullptr;
+}
+
+TEST_CASE("Textures are decoded again after invalidation", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    TextureCache cache;
+
+    const TextureInfo info = MakeTexture(memory, TextureFormat::RGBA8, 1);
+    const DecodedTexture* texture = cache.GetTexture(info);
+    REQUIRE(texture != nullptr);
+
+    // Writes which don't go through the rasterizer hooks aren't seen
+    MakeTexture(memory, TextureFormat::RGBA8, 2);
+    REQUIRE(cache.GetTexture(info) == texture);
+    REQUIRE(!MatchesMemory(memory, *texture));
+
+    // Invalidating a region outside of the texture doesn't affect it
+    cache.InvalidateRegion(Memory::VRAM_PADDR + info.stride * info.height / 8, 0x100);
+    REQUIRE(!MatchesMemory(memory, *cache.GetTexture(info)));
+
+    cache.InvalidateRegion(Memory::VRAM_PADDR + 0x10, 4);
+    REQUIRE(cache.GetTexture(info) == texture);
+    REQUIRE(MatchesMemory(memory, *texture));
+
+    // Textures at the same address with another size are distinct
+    TextureInfo smaller = info;
+    smaller.width = 32;
+    smaller.SetDefaultStride();
+    const DecodedTexture* smaller_texture = cache.GetTexture(smaller);
+    REQUIRE(smaller_texture != texture);
+    REQUIRE(MatchesMemory(memory, *smaller_texture));
+
+    // Textures outside of emulated memory can't be decoded
+    TextureInfo invalid = info;
+    invalid.physical_address = Memory::VRAM_PADDR_END - 0x10;
+    REQUIRE(cache.GetTexture(invalid) == nullptr);
+
+    cache.Clear();
+    VideoCore::g_memory = nullptr;
+}
+
+// Measures the number of texels sampled per second, with and without the decoded texture cache.
+TEST_CASE("Texture sampling throughput", "[.benchmark][swrasterizer]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t num_samples = 1 << 22;
+
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    TextureCache cache;
+
+    std::mt19937 rng(1234);
+    std::vector<std::pair<u32, u32>> coordinates(num_samples);
+
+    for (const auto format : {TextureFormat::RGBA8, TextureFormat::RGB565, TextureFormat::ETC1,
+                              TextureFormat::ETC1A4}) {
+        const TextureInfo info = MakeTexture(memory, format, 1);
+        for (auto& [s, t] : coordinates) {
+            s = rng() % info.width;
+            t = rng() % info.height;
+        }
+        const u8* data = memory.GetPhysicalPointer(info.physical_address);
+
+        u32 checksum = 0;
+        auto start = Clock::now();
+        for (const auto& [s, t] : coordinates) {
+            checksum += Pica::Texture::LookupTexture(data, s, t, info).r();
+        }
+        const double lookup_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        // The cache is cleared first so that decoding the texture is included in the time
+        cache.Clear();
+        start = Clock::now();
+        const DecodedTexture* texture = cache.GetTexture(info);
+        for (const auto& [s, t] : coordinates) {
+            checksum -= texture->Lookup(s, t).r();
+        }
+        const double cache_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        REQUIRE(checksum == 0);
+        WARN("Format " << static_cast<u32>(format) << ": "
+                       << num_samples / lookup_seconds / 1e6 << " Msamples/s with LookupTexture, "
+                       << num_samples / cache_seconds / 1e6 << " Msamples/s with the cache");
+    }
+
+    cache.Clear();
+    VideoCore::g_memory = nullptr;
+}
@@ -0,0 +1,160 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/texture/morton_swizzle.h"
+#include "video_core/utils.h"
+
+using Pica::Texture::PixelConversion;
+
+/// Width of the destination rows, wider than a tile to check that the pitch is honored
+constexpr std::ptrdiff_t ROW_PIXELS = 13;
+
+/// Converts one pixel from the tile to the rows, like the OpenGL rasterizer cache used to do
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void ReferenceToLinear(const u8* tile_pixel, u8* linear_pixel) {
+    switch (conversion) {
+    case PixelConversion::None:
+        std::memcpy(linear_pixel, tile_pixel, bytes_per_pixel);
+        break;
+    case PixelConversion::ReverseBytes:
+        for (u32 i = 0; i < bytes_per_pixel; ++i) {
+            linear_pixel[i] = tile_pixel[bytes_per_pixel - 1 - i];
+        }
+        break;
+    case PixelConversion::StencilFirst:
+        linear_pixel[0] = tile_pixel[3];
+        std::memcpy(linear_pixel + 1, tile_pixel, 3);
+        break;
+    case PixelConversion::PadTo4Bytes:
+        std::memcpy(linear_pixel + 1, tile_pixel, 3);
+        break;
+    }
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void TestMortonTile(std::mt19937& rng) {
+    constexpr u32 linear_bytes_per_pixel =
+        conversion == PixelConversion::PadTo4Bytes ? 4 : bytes_per_pixel;
+    constexpr std::ptrdiff_t row_size = ROW_PIXELS * linear_bytes_per_pixel;
+
+    std::array<u8, 64 * bytes_per_pixel> tile;
+    for (auto& byte : tile) {
+        byte = static_cast<u8>(rng());
+    }
+
+    // Rows are stored top to bottom and bottom to top, like in OpenGL
+    for (const bool flipped : {false, true}) {
+        std::vector<u8> linear(8 * row_size);
+        for (auto& byte : linear) {
+            byte = static_cast<u8>(rng());
+        }
+        std::vector<u8> expected = linear;
+
+        u8* const first_row = linear.data() + (flipped ? 7 * row_size : 0);
+        const std::ptrdiff_t pitch = flipped ? -row_size : row_size;
+        Pica::Texture::MortonToLinearTile<bytes_per_pixel, conversion>(tile.data(), first_row,
+                                                                       pitch);
+
+        for (u32 y = 0; y < 8; ++y) {
+            for (u32 x = 0; x < 8; ++x) {
+                const u32 row = flipped ? 7 - y : y;
+                ReferenceToLinear<bytes_per_pixel, conversion>(
+                    &tile[VideoCore::MortonInterleave(x, y) * bytes_per_pixel],
+                    &expected[row * row_size + x * linear_bytes_per_pixel]);
+            }
+        }
+        REQUIRE(linear == expected);
+
+        // Copying the rows back gives the original tile
+        std::array<u8, 64 * bytes_per_pixel> copy{};
+        Pica::Texture::LinearToMortonTile<bytes_per_pixel, conversion>(copy.data(), first_row,
+                                                                       pitch);
+        REQUIRE(copy == tile);
+    }
+}
+
+TEST_CASE("Morton tile copies match per-pixel copies", "[video_core][texture]") {
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 16; ++i) {
+        TestMortonTile<1, PixelConversion::None>(rng);
+        TestMortonTile<2, PixelConversion::None>(rng);
+        TestMortonTile<3, PixelConversion::None>(rng);
+        TestMortonTile<4, PixelConversion::None>(rng);
+        TestMortonTile<3, PixelConversion::ReverseBytes>(rng);
+        TestMortonTile<4, PixelConversion::ReverseBytes>(rng);
+        TestMortonTile<4, PixelConversion::StencilFirst>(rng);
+        TestMortonTile<3, PixelConversion::PadTo4Bytes>(rng);
+    }
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void BenchmarkMortonTile(const char* name) {
+    using Clock = std::chrono::steady_clock;
+    constexpr u32 linear_bytes_per_pixel =
+        conversion == PixelConversion::PadTo4Bytes ? 4 : bytes_per_pixel;
+    constexpr u32 width = 1024;
+    constexpr u32 height = 1024;
+    constexpr std::size_t tile_size = 64 * bytes_per_pixel;
+    constexpr std::ptrdiff_t row_size = width * linear_bytes_per_pixel;
+    constexpr int iterations = 8;
+
+    std::vector<u8> tiled(width * height * bytes_per_pixel, 0x5A);
+    std::vector<u8> linear(width * height * linear_bytes_per_pixel);
+
+    const auto ForEachTile = [&](auto&& copy) {
+        for (int i = 0; i < iterations; ++i) {
+            for (u32 y = 0; y < height; y += 8) {
+                for (u32 x = 0; x < width; x += 8) {
+                    u8* const tile = &tiled[((y / 8) * (width / 8) + x / 8) * tile_size];
+                    copy(tile, &linear[y * row_size + x * linear_bytes_per_pixel]);
+                }
+            }
+        }
+    };
+
+    auto start = Clock::now();
+    ForEachTile([](u8* tile, u8* rows) {
+        for (u32 y = 0; y < 8; ++y) {
+            for (u32 x = 0; x < 8; ++x) {
+                ReferenceToLinear<bytes_per_pixel, conversion>(
+                    tile + VideoCore::MortonInterleave(x, y) * bytes_per_pixel,
+                    rows + y * row_size + x * linear_bytes_per_pixel);
+            }
+        }
+    });
+    const double reference_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    ForEachTile([](u8* tile, u8* rows) {
+        Pica::Texture::MortonToLinearTile<bytes_per_pixel, conversion>(tile, rows, row_size);
+    });
+    const double unswizzle_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    ForEachTile([](u8* tile, u8* rows) {
+        Pica::Texture::LinearToMortonTile<bytes_per_pixel, conversion>(tile, rows, row_size);
+    });
+    const double swizzle_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const double megabytes = static_cast<double>(tiled.size()) * iterations / 1e6;
+    WARN(name << ": " << megabytes / reference_seconds << " MB/s per pixel, "
+              << megabytes / unswizzle_seconds << " MB/s to rows, "
+              << megabytes / swizzle_seconds << " MB/s to tiles");
+}
+
+// Measures the throughput of the tile copies, in MB of tiled data per second.
+TEST_CASE("Morton tile copy throughput", "[.benchmark][texture]") {
+    BenchmarkMortonTile<2, PixelConversion::None>("2 bytes");
+    BenchmarkMortonTile<3, PixelConversion::None>("3 bytes");
+    BenchmarkMortonTile<4, PixelConversion::None>("4 bytes");
+    BenchmarkMortonTile<4, PixelConversion::ReverseBytes>("4 bytes, reversed");
+    BenchmarkMortonTile<4, PixelConversion::StencilFirst>("D24S8");
+    BenchmarkMortonTile<3, PixelConversion::PadTo4Bytes>("D24");
+}
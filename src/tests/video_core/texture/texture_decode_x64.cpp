@@ -0,0 +1,55 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <catch2/catch.hpp>
+#include "video_core/texture/texture_decode.h"
+#include "video_core/texture/texture_decode_x64.h"
+
+using Pica::Texture::TextureInfo;
+using TextureFormat = Pica::TexturingRegs::TextureFormat;
+
+TEST_CASE("SSSE3 tile decoders match LookupTexelInTile", "[video_core][texture]") {
+    if (!Pica::Texture::IsSSSE3TileDecodingSupported()) {
+        return;
+    }
+
+    std::mt19937 rng(1234);
+    for (const auto format :
+         {TextureFormat::RGBA8, TextureFormat::RGB8, TextureFormat::RGB5A1, TextureFormat::RGB565,
+          TextureFormat::RGBA4, TextureFormat::IA8, TextureFormat::RG8, TextureFormat::I8,
+          TextureFormat::A8, TextureFormat::IA4, TextureFormat::I4, TextureFormat::A4,
+          TextureFormat::ETC1, TextureFormat::ETC1A4}) {
+        TextureInfo info{};
+        info.width = 8;
+        info.height = 8;
+        info.format = format;
+        info.SetDefaultStride();
+
+        for (int tile = 0; tile < 100; ++tile) {
+            // The largest tile is 256 bytes
+            std::array<u8, 256> data{};
+            for (std::size_t i = 0; i < Pica::Texture::CalculateTileSize(format); ++i) {
+                data[i] = static_cast<u8>(rng());
+            }
+
+            // A destination wider than the tile checks that the stride is honored
+            constexpr std::size_t stride = 11;
+            std::array<Common::Vec4<u8>, 8 * stride> decoded{};
+            REQUIRE(Pica::Texture::DecodeTileSSSE3(format, data.data(), decoded.data(), stride));
+
+            for (u32 y = 0; y < 8; ++y) {
+                for (u32 x = 0; x < 8; ++x) {
+                    const auto expected =
+                        Pica::Texture::LookupTexelInTile(data.data(), x, y, info, false);
+                    const auto actual = decoded[y * stride + x];
+                    for (std::size_t i = 0; i < 4; ++i) {
+                        REQUIRE(actual[i] == expected[i]);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,160 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/alignment.h"
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/regs_pipeline.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+using Pica::PipelineRegs;
+using Pica::Shader::AttributeBuffer;
+using Format = PipelineRegs::VertexAttributeFormat;
+
+// The attributes are loaded from VRAM, and from a copy of it at COPY_OFFSET. The specialized and
+// JIT loaders are only used at the base address they were set up for, so loading the copy goes
+// through the generic path.
+constexpr PAddr BASE_ADDRESS = Memory::VRAM_PADDR;
+constexpr u32 COPY_OFFSET = 0x100000;
+constexpr u32 NUM_VERTICES = 64;
+
+/// Raw words of the vertex attribute registers, which have a bit field for each attribute
+struct AttributeRegs {
+    std::array<u32, 3 + 3 * 12> words{};
+    /// Bytes of each attribute in a vertex
+    std::array<u32, 12> sizes{};
+    std::array<u32, 12> alignments{};
+
+    void SetAttribute(u32 attribute, Format format, u32 elements) {
+        words[1 + attribute / 8] |= (static_cast<u32>(format) | (elements - 1) << 2)
+                                    << (attribute % 8 * 4);
+        alignments[attribute] = format == Format::FLOAT ? 4 : format == Format::SHORT ? 2 : 1;
+        sizes[attribute] = elements * alignments[attribute];
+    }
+
+    /// Sets a loader of the given components, and returns the number of bytes of a vertex in it
+    u32 SetLoader(u32 loader, u32 data_offset, const std::vector<u32>& components) {
+        words[3 + loader * 3] = data_offset;
+        u32 offset = 0;
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            const u32 component = components[i];
+            words[4 + loader * 3 + i / 8] |= component << (i % 8 * 4);
+            if (component < 12) {
+                offset = Common::AlignUp(offset, alignments[component]) + sizes[component];
+            } else {
+                offset = Common::AlignUp(offset, 4) + (component - 11) * 4;
+            }
+        }
+        const u32 byte_count = Common::AlignUp(offset, 4);
+        words[5 + loader * 3] |= byte_count << 16 | static_cast<u32>(components.size()) << 28;
+        return byte_count;
+    }
+
+    PipelineRegs ToPipelineRegs(u32 fixed_mask, u32 num_attributes) {
+        words[0] = BASE_ADDRESS / 16 << 1;
+        words[2] |= fixed_mask << 16 | (num_attributes - 1) << 28;
+        PipelineRegs regs{};
+        static_assert(sizeof(regs.vertex_attributes) == sizeof(words));
+        std::memcpy(&regs.vertex_attributes, words.data(), sizeof(words));
+        return regs;
+    }
+};
+
+/**
+ * Sets up loaders for four attributes of the format with 1 to 4 elements, interleaved with
+ * padding in one array, and a float attribute in a second array. Attribute 5 is fixed, and
+ * attribute 6 is neither loaded nor fixed, so it must keep its previous value.
+ */
+static PipelineRegs MakeLayout(Format format) {
+    AttributeRegs regs;
+    for (u32 attribute = 0; attribute < 4; ++attribute) {
+        regs.SetAttribute(attribute, format, attribute + 1);
+    }
+    regs.SetAttribute(4, Format::FLOAT, 3);
+    const u32 byte_count = regs.SetLoader(0, 0, {0, 1, 12, 2, 3});
+    regs.SetLoader(1, byte_count * NUM_VERTICES, {4});
+    return regs.ToPipelineRegs(1 << 5, 7);
+}
+
+static void FillMemory(Memory::MemorySystem& memory, u32 seed) {
+    std::mt19937 rng(seed);
+    u8* const data = memory.GetPhysicalPointer(BASE_ADDRESS);
+    for (u32 i = 0; i < COPY_OFFSET; ++i) {
+        // Keeps the exponent of the floats below the maximum, so that they are all finite
+        data[i] = static_cast<u8>(rng() & 0xBF);
+    }
+    std::memcpy(data + COPY_OFFSET, data, COPY_OFFSET);
+
+    for (u32 attribute = 0; attribute < 16; ++attribute) {
+        for (u32 comp = 0; comp < 4; ++comp) {
+            Pica::g_state.input_default_attributes.attr[attribute][comp] =
+                Pica::float24::FromFloat32(static_cast<float>(rng() % 1000) / 8.0f);
+        }
+    }
+}
+
+static bool Matches(const AttributeBuffer& a, const AttributeBuffer& b, int num_attributes) {
+    for (int attribute = 0; attribute < num_attributes; ++attribute) {
+        for (std::size_t comp = 0; comp < 4; ++comp) {
+            const float x = a.attr[attribute][comp].ToFloat32();
+            const float y = b.attr[attribute][comp].ToFloat32();
+            if (std::memcmp(&x, &y, sizeof(float)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// Checks that the loader picked with the current JIT setting matches the generic path
+static void CheckLoaderMatchesGeneric(Format format) {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    FillMemory(memory, static_cast<u32>(format));
+
+    const PipelineRegs regs = MakeLayout(format);
+    Pica::VertexLoader loader(regs);
+    REQUIRE(loader.GetNumTotalAttributes() == 7);
+
+    Pica::DebugUtils::MemoryAccessTracker memory_accesses;
+    for (u32 vertex = 0; vertex < NUM_VERTICES; ++vertex) {
+        AttributeBuffer expected{};
+        AttributeBuffer actual{};
+        expected.attr[6] = actual.attr[6] = Pica::g_state.input_default_attributes.attr[0];
+
+        loader.LoadVertex(BASE_ADDRESS + COPY_OFFSET, vertex, vertex, expected, memory_accesses);
+        loader.LoadVertex(BASE_ADDRESS, vertex, vertex, actual, memory_accesses);
+        REQUIRE(Matches(expected, actual, loader.GetNumTotalAttributes()));
+    }
+
+    VideoCore::g_memory = nullptr;
+}
+
+TEST_CASE("Specialized vertex loaders match the generic path", "[video_core]") {
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    VideoCore::g_shader_jit_enabled = false;
+    for (const auto format : {Format::BYTE, Format::UBYTE, Format::SHORT, Format::FLOAT}) {
+        CheckLoaderMatchesGeneric(format);
+    }
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("JIT vertex loaders match the generic path", "[video_core]") {
+    const bool jit_enabled = VideoCore::g_shader_jit_enabled;
+    VideoCore::g_shader_jit_enabled = true;
+    for (const auto format : {Format::BYTE, Format::UBYTE, Format::SHORT, Format::FLOAT}) {
+        CheckLoaderMatchesGeneric(format);
+    }
+    VideoCore::g_shader_jit_enabled = jit_enabled;
+}
+#endif
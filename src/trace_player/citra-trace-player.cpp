@@ -0,0 +1,200 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <glad/glad.h>
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "trace_player/trace_player.h"
+#include "video_core/video_core.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "Replays a CiTrace with the software renderer and reports the GPU throughput\n"
+                 "-n, --repeat N                 Replay the trace N times\n"
+                 "-d, --dump-dir DIR             Write the framebuffers of each frame to DIR\n"
+                 "-i, --interpreter              Use the shader interpreter instead of the JIT\n"
+                 "-b, --shader-batch-size N      Run the shader JIT on batches of 4 or 8 vertices\n"
+                 "-p, --parallel-rasterization   Rasterize triangles on multiple threads\n"
+                 "-q, --quiet                    Only print the summary\n"
+                 "-h, --help                     Display this help and exit\n"
+                 "-v, --version                  Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra trace player " << Common::g_scm_branch << " " << Common::g_scm_desc
+              << std::endl;
+}
+
+static void InitializeLogging() {
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetGlobalFilter(log_filter);
+
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+#ifdef _WIN32
+    Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
+#endif
+}
+
+static double ToMilliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    char* endarg;
+
+    // This is just to be able to link against video_core
+    gladLoadGL();
+
+    u32 repeat = 1;
+    std::string dump_dir;
+    bool use_interpreter = false;
+    u32 shader_batch_size = 0;
+    bool parallel_rasterization = false;
+    bool quiet = false;
+
+    static struct option long_options[] = {
+        {"repeat", required_argument, 0, 'n'},
+        {"dump-dir", required_argument, 0, 'd'},
+        {"interpreter", no_argument, 0, 'i'},
+        {"shader-batch-size", required_argument, 0, 'b'},
+        {"parallel-rasterization", no_argument, 0, 'p'},
+        {"quiet", no_argument, 0, 'q'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    std::string filepath;
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "n:d:ib:pqhv", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'n':
+                repeat = strtoul(optarg, &endarg, 0);
+                break;
+            case 'd':
+                dump_dir.assign(optarg);
+                break;
+            case 'i':
+                use_interpreter = true;
+                break;
+            case 'b':
+                shader_batch_size = strtoul(optarg, &endarg, 0);
+                break;
+            case 'p':
+                parallel_rasterization = true;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            default:
+                PrintHelp(argv[0]);
+                return -1;
+            }
+        } else {
+            filepath = argv[optind];
+            optind++;
+        }
+    }
+
+    if (filepath.empty()) {
+        std::cout << "No trace file specified!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (repeat == 0) {
+        std::cout << "repeat needs to be at least 1!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (!dump_dir.empty() && !FileUtil::CreateFullPath(dump_dir + DIR_SEP)) {
+        std::cout << "Failed to create the dump directory " << dump_dir << "\n";
+        return -1;
+    }
+
+    InitializeLogging();
+
+    VideoCore::g_shader_jit_enabled = !use_interpreter;
+    VideoCore::g_shader_jit_batch_size = shader_batch_size;
+    VideoCore::g_parallel_rasterization_enabled = parallel_rasterization;
+
+    TracePlayer::Player player;
+    if (!player.Load(filepath)) {
+        std::cout << "Failed to load the trace " << filepath << "\n";
+        return -1;
+    }
+
+    std::size_t frames = 0;
+    u64 draws = 0;
+    u64 vertices = 0;
+    std::chrono::nanoseconds total_time{};
+    auto min_frame_time = std::chrono::nanoseconds::max();
+    auto max_frame_time = std::chrono::nanoseconds::zero();
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (u32 pass = 0; pass < repeat; ++pass) {
+        player.Replay([&](std::size_t frame, const TracePlayer::FrameStats& stats) {
+            ++frames;
+            draws += stats.draws;
+            vertices += stats.vertices;
+            total_time += stats.duration;
+            min_frame_time = std::min(min_frame_time, stats.duration);
+            max_frame_time = std::max(max_frame_time, stats.duration);
+
+            if (!quiet) {
+                std::cout << "Frame " << frame << ": " << ToMilliseconds(stats.duration)
+                          << " ms, " << stats.draws << " draws, " << stats.vertices
+                          << " vertices\n";
+            }
+
+            // The framebuffers are the same on every pass, so they are only dumped once
+            if (!dump_dir.empty() && pass == 0) {
+                const std::string prefix = dump_dir + DIR_SEP + "frame_" + std::to_string(frame);
+                player.DumpFramebuffer(0, prefix + "_top.png");
+                player.DumpFramebuffer(1, prefix + "_bottom.png");
+            }
+        });
+    }
+
+    if (frames == 0) {
+        std::cout << "The trace does not contain any frame\n";
+        return 0;
+    }
+
+    const double seconds = std::chrono::duration<double>(total_time).count();
+    std::cout << "Frames:        " << frames << "\n"
+              << "Frame time:    " << ToMilliseconds(total_time) / frames << " ms average, "
+              << ToMilliseconds(min_frame_time) << " ms min, " << ToMilliseconds(max_frame_time)
+              << " ms max\n"
+              << "Draws/sec:     " << draws / seconds << "\n"
+              << "Vertices/sec:  " << vertices / seconds << std::endl;
+
+    return 0;
+}
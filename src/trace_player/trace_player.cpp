@@ -0,0 +1,355 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <lodepng.h>
+#include "common/color.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "trace_player/trace_player.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace TracePlayer {
+
+/// Physical addresses of the register blocks, as recorded in traces
+constexpr PAddr GPU_REGS_PADDR = HW::VADDR_GPU - Memory::IO_AREA_VADDR + Memory::IO_AREA_PADDR;
+constexpr PAddr LCD_REGS_PADDR = HW::VADDR_LCD - Memory::IO_AREA_VADDR + Memory::IO_AREA_PADDR;
+
+class HeadlessWindow : public Frontend::EmuWindow {
+public:
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+/// Renderer that leaves the results of the software rasterizer in the emulated VRAM
+class HeadlessRenderer : public VideoCore::RendererBase {
+public:
+    explicit HeadlessRenderer(Frontend::EmuWindow& window) : RendererBase(window) {}
+
+    VideoCore::ResultStatus Init() override {
+        RefreshRasterizerSetting();
+        return VideoCore::ResultStatus::Success;
+    }
+    void ShutDown() override {}
+    void SwapBuffers() override {
+        ++m_current_frame;
+    }
+    bool TryPresent() override {
+        return false;
+    }
+    void PrepareVideoDumping() override {}
+    void CleanupVideoDumping() override {}
+};
+
+template <typename T>
+static void WriteRegister(PAddr address, T value) {
+    if (address >= GPU_REGS_PADDR && address < GPU_REGS_PADDR + sizeof(GPU::Regs)) {
+        GPU::Write<T>(address - GPU_REGS_PADDR + HW::VADDR_GPU, value);
+    } else if (address >= LCD_REGS_PADDR && address < LCD_REGS_PADDR + sizeof(LCD::Regs)) {
+        LCD::Write<T>(address - LCD_REGS_PADDR + HW::VADDR_LCD, value);
+    } else {
+        LOG_WARNING(HW_GPU, "Ignoring write to unknown register @ {:#010X}", address);
+    }
+}
+
+Player::Player()
+    : memory(std::make_unique<Memory::MemorySystem>()),
+      window(std::make_unique<HeadlessWindow>()) {
+    VideoCore::g_hw_renderer_enabled = false;
+    VideoCore::g_memory = memory.get();
+    Pica::Init();
+
+    // The GPU backend only uses the system to signal interrupts, which have no effect here
+    VideoCore::g_renderer = std::make_unique<HeadlessRenderer>(*window);
+    VideoCore::g_gpu = std::make_unique<VideoCore::GPUSerial>(Core::System::GetInstance(),
+                                                              *VideoCore::g_renderer);
+    VideoCore::g_renderer->Init();
+}
+
+Player::~Player() {
+    Pica::Shutdown();
+    VideoCore::g_gpu.reset();
+    VideoCore::g_renderer.reset();
+    VideoCore::g_memory = nullptr;
+}
+
+const u8* Player::GetData(u32 offset, u64 size) const {
+    if (offset > data.size() || data.size() - offset < size) {
+        return nullptr;
+    }
+    return data.data() + offset;
+}
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open trace file={}", filename);
+        return false;
+    }
+    data.resize(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read trace file={}", filename);
+        return false;
+    }
+
+    if (data.size() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "Trace file is truncated");
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, CiTrace::CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CiTrace::CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "File is not a CiTrace, or has an unsupported version");
+        return false;
+    }
+
+    const auto& initial = header.initial_state_offsets;
+    const std::pair<u32, u32> initial_state_ranges[] = {
+        {initial.gpu_registers, initial.gpu_registers_size},
+        {initial.lcd_registers, initial.lcd_registers_size},
+        {initial.pica_registers, initial.pica_registers_size},
+        {initial.default_attributes, initial.default_attributes_size},
+        {initial.vs_program_binary, initial.vs_program_binary_size},
+        {initial.vs_swizzle_data, initial.vs_swizzle_data_size},
+        {initial.vs_float_uniforms, initial.vs_float_uniforms_size},
+        {initial.gs_program_binary, initial.gs_program_binary_size},
+        {initial.gs_swizzle_data, initial.gs_swizzle_data_size},
+        {initial.gs_float_uniforms, initial.gs_float_uniforms_size},
+    };
+    for (const auto& [offset, size] : initial_state_ranges) {
+        if (GetData(offset, static_cast<u64>(size) * sizeof(u32)) == nullptr) {
+            LOG_ERROR(HW_GPU, "Initial state of the trace is out of bounds");
+            return false;
+        }
+    }
+
+    const u64 stream_bytes =
+        static_cast<u64>(header.stream_size) * sizeof(CiTrace::CTStreamElement);
+    const u8* stream_data = GetData(header.stream_offset, stream_bytes);
+    if (stream_data == nullptr) {
+        LOG_ERROR(HW_GPU, "Command stream of the trace is out of bounds");
+        return false;
+    }
+    stream.resize(header.stream_size);
+    std::memcpy(stream.data(), stream_data, stream_bytes);
+
+    for (const auto& element : stream) {
+        if (element.type != CiTrace::MemoryLoad) {
+            continue;
+        }
+        const auto& load = element.memory_load;
+        if (GetData(load.file_offset, load.size) == nullptr ||
+            !memory->IsValidPhysicalAddress(load.physical_address) ||
+            (load.size != 0 &&
+             !memory->IsValidPhysicalAddress(load.physical_address + load.size - 1))) {
+            LOG_ERROR(HW_GPU, "Memory load of the trace is out of bounds");
+            return false;
+        }
+    }
+
+    LOG_INFO(HW_GPU, "Loaded trace with {} stream elements", stream.size());
+    return true;
+}
+
+void Player::LoadInitialState() {
+    const auto& initial = header.initial_state_offsets;
+    const auto CopyWords = [this](void* dest, std::size_t dest_size, u32 offset, u32 size) {
+        std::memcpy(dest, GetData(offset, 0),
+                    std::min<std::size_t>(dest_size, static_cast<std::size_t>(size) * 4));
+    };
+
+    CopyWords(&GPU::g_regs, sizeof(GPU::g_regs), initial.gpu_registers,
+              initial.gpu_registers_size);
+    CopyWords(&LCD::g_regs, sizeof(LCD::g_regs), initial.lcd_registers,
+              initial.lcd_registers_size);
+
+    Pica::g_state.Reset();
+    auto& regs = Pica::g_state.regs;
+    CopyWords(&regs, sizeof(regs), initial.pica_registers, initial.pica_registers_size);
+
+    // Recompute the state that the command processor derives from register writes
+    Pica::g_state.primitive_assembler.Reconfigure(regs.pipeline.triangle_topology);
+    Pica::g_state.geometry_pipeline.Reconfigure();
+    for (auto [setup, config] : {std::pair{&Pica::g_state.vs, &regs.vs},
+                                 std::pair{&Pica::g_state.gs, &regs.gs}}) {
+        for (unsigned i = 0; i < setup->uniforms.b.size(); ++i) {
+            setup->uniforms.b[i] = (config->bool_uniforms.Value() & (1 << i)) != 0;
+        }
+        for (unsigned i = 0; i < setup->uniforms.i.size(); ++i) {
+            const auto& values = config->int_uniforms[i];
+            setup->uniforms.i[i] = Common::MakeVec<u8>(values.x, values.y, values.z, values.w);
+        }
+    }
+
+    // Vectors are stored as four float24 values, of which only the first three are recorded
+    const auto LoadVectors = [this](Common::Vec4<Pica::float24>* dest, std::size_t count,
+                                    u32 offset, u32 size) {
+        const u8* vectors = GetData(offset, 0);
+        count = std::min<std::size_t>(count, size / 4);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (std::size_t comp = 0; comp < 3; ++comp) {
+                u32 raw;
+                std::memcpy(&raw, vectors + (i * 4 + comp) * sizeof(u32), sizeof(u32));
+                dest[i][comp] = Pica::float24::FromRaw(raw);
+            }
+        }
+    };
+    LoadVectors(Pica::g_state.input_default_attributes.attr, 16, initial.default_attributes,
+                initial.default_attributes_size);
+
+    const auto LoadShader = [&](Pica::Shader::ShaderSetup& setup, u32 program, u32 program_size,
+                                u32 swizzle, u32 swizzle_size, u32 uniforms, u32 uniforms_size) {
+        CopyWords(setup.program_code.data(), sizeof(setup.program_code), program, program_size);
+        CopyWords(setup.swizzle_data.data(), sizeof(setup.swizzle_data), swizzle, swizzle_size);
+        setup.MarkProgramCodeDirty();
+        setup.MarkSwizzleDataDirty();
+        LoadVectors(setup.uniforms.f, std::size(setup.uniforms.f), uniforms, uniforms_size);
+    };
+    LoadShader(Pica::g_state.vs, initial.vs_program_binary, initial.vs_program_binary_size,
+               initial.vs_swizzle_data, initial.vs_swizzle_data_size, initial.vs_float_uniforms,
+               initial.vs_float_uniforms_size);
+    LoadShader(Pica::g_state.gs, initial.gs_program_binary, initial.gs_program_binary_size,
+               initial.gs_swizzle_data, initial.gs_swizzle_data_size, initial.gs_float_uniforms,
+               initial.gs_float_uniforms_size);
+}
+
+void Player::ProcessElement(const CiTrace::CTStreamElement& element) {
+    switch (element.type) {
+    case CiTrace::MemoryLoad: {
+        const auto& load = element.memory_load;
+        std::memcpy(memory->GetPhysicalPointer(load.physical_address),
+                    GetData(load.file_offset, load.size), load.size);
+        Memory::RasterizerInvalidateRegion(load.physical_address, load.size);
+        break;
+    }
+    case CiTrace::RegisterWrite: {
+        const auto& write = element.register_write;
+        switch (write.size) {
+        case CiTrace::CTRegisterWrite::SIZE_8:
+            WriteRegister(write.physical_address, static_cast<u8>(write.value));
+            break;
+        case CiTrace::CTRegisterWrite::SIZE_16:
+            WriteRegister(write.physical_address, static_cast<u16>(write.value));
+            break;
+        case CiTrace::CTRegisterWrite::SIZE_32:
+            WriteRegister(write.physical_address, static_cast<u32>(write.value));
+            break;
+        case CiTrace::CTRegisterWrite::SIZE_64:
+            WriteRegister(write.physical_address, static_cast<u64>(write.value));
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown register write size {:#x}", static_cast<u32>(write.size));
+            break;
+        }
+        break;
+    }
+    default:
+        LOG_ERROR(HW_GPU, "Unknown stream element type {:#x}", static_cast<u32>(element.type));
+        break;
+    }
+}
+
+void Player::Replay(const std::function<void(std::size_t, const FrameStats&)>& frame_callback) {
+    using Clock = std::chrono::steady_clock;
+
+    LoadInitialState();
+    Pica::CommandProcessor::TakeDrawStats();
+
+    std::size_t frame = 0;
+    auto frame_start = Clock::now();
+    for (const auto& element : stream) {
+        if (element.type != CiTrace::FrameMarker) {
+            ProcessElement(element);
+            continue;
+        }
+
+        VideoCore::g_gpu->SwapBuffers();
+
+        const auto draw_stats = Pica::CommandProcessor::TakeDrawStats();
+        FrameStats stats;
+        stats.duration = Clock::now() - frame_start;
+        stats.draws = draw_stats.draws;
+        stats.vertices = draw_stats.vertices;
+        frame_callback(frame++, stats);
+
+        // The callback may take a while, e.g. to dump the framebuffers, and isn't measured
+        frame_start = Clock::now();
+    }
+}
+
+bool Player::DumpFramebuffer(std::size_t screen, const std::string& filename) const {
+    const auto& framebuffer = GPU::g_regs.framebuffer_config[screen];
+    const PAddr address =
+        framebuffer.active_fb == 0 ? framebuffer.address_left1 : framebuffer.address_left2;
+    const auto format = framebuffer.color_format.Value();
+    if (format > GPU::Regs::PixelFormat::RGBA4) {
+        LOG_ERROR(HW_GPU, "Framebuffer of screen {} has unknown format {}", screen,
+                  static_cast<u32>(format));
+        return false;
+    }
+    const u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(format);
+
+    // The screens are rotated, so each row in memory is a column of the displayed image
+    const u32 width = framebuffer.width;
+    const u32 height = framebuffer.height;
+    const u64 row_size = std::max<u64>(framebuffer.stride, width * bytes_per_pixel);
+    if (width == 0 || height == 0 || !memory->IsValidPhysicalAddress(address) ||
+        !memory->IsValidPhysicalAddress(static_cast<PAddr>(address + row_size * height - 1))) {
+        LOG_ERROR(HW_GPU, "Framebuffer of screen {} is not in memory", screen);
+        return false;
+    }
+
+    const u8* pixels = memory->GetPhysicalPointer(address);
+    std::vector<u8> image;
+    image.reserve(width * height * 4);
+    for (u32 y = 0; y < height; ++y) {
+        const u8* row = pixels + framebuffer.stride * y;
+        for (u32 x = 0; x < width; ++x) {
+            const u8* pixel = row + x * bytes_per_pixel;
+            Common::Vec4<u8> color;
+            switch (format) {
+            case GPU::Regs::PixelFormat::RGBA8:
+                color = Color::DecodeRGBA8(pixel);
+                break;
+            case GPU::Regs::PixelFormat::RGB8:
+                color = Color::DecodeRGB8(pixel);
+                break;
+            case GPU::Regs::PixelFormat::RGB565:
+                color = Color::DecodeRGB565(pixel);
+                break;
+            case GPU::Regs::PixelFormat::RGB5A1:
+                color = Color::DecodeRGB5A1(pixel);
+                break;
+            case GPU::Regs::PixelFormat::RGBA4:
+                color = Color::DecodeRGBA4(pixel);
+                break;
+            }
+            // The displayed image ignores the alpha channel
+            image.insert(image.end(), {color.r(), color.g(), color.b(), 255});
+        }
+    }
+
+    const u32 result = lodepng::encode(filename, image, width, height);
+    if (result != 0) {
+        LOG_ERROR(HW_GPU, "Failed to write framebuffer to file={}: {}", filename,
+                  lodepng_error_text(result));
+        return false;
+    }
+    return true;
+}
+
+} // namespace TracePlayer
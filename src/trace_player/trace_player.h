@@ -0,0 +1,75 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace TracePlayer {
+
+class HeadlessWindow;
+
+/// Work done by the GPU emulation to replay one frame of a trace
+struct FrameStats {
+    std::chrono::nanoseconds duration{};
+    u64 draws = 0;
+    u64 vertices = 0;
+};
+
+/**
+ * Replays CiTrace files through the Pica command processor, without any emulated system or
+ * window. Rendering is done by the software rasterizer into the emulated VRAM, so the results
+ * can be read back with DumpFramebuffer.
+ */
+class Player {
+public:
+    Player();
+    ~Player();
+
+    /**
+     * Loads a trace and validates its contents.
+     * @return Whether the trace could be loaded
+     */
+    bool Load(const std::string& filename);
+
+    /**
+     * Resets the GPU to the initial state of the trace and replays all of its frames.
+     * @param frame_callback Called at the end of each frame, with the index of the frame
+     */
+    void Replay(const std::function<void(std::size_t, const FrameStats&)>& frame_callback);
+
+    /**
+     * Writes the framebuffer currently displayed on a screen to a PNG file. The image is stored
+     * in the orientation of the framebuffer in memory, i.e. rotated by 90 degrees.
+     * @param screen 0 for the top screen, 1 for the bottom screen
+     * @return Whether the image could be written
+     */
+    bool DumpFramebuffer(std::size_t screen, const std::string& filename) const;
+
+private:
+    void LoadInitialState();
+    void ProcessElement(const CiTrace::CTStreamElement& element);
+
+    /// Returns the data of the trace at offset, or nullptr if it has less than size bytes there
+    const u8* GetData(u32 offset, u64 size) const;
+
+    std::vector<u8> data;
+    CiTrace::CTHeader header{};
+    std::vector<CiTrace::CTStreamElement> stream;
+
+    std::unique_ptr<Memory::MemorySystem> memory;
+    std::unique_ptr<HeadlessWindow> window;
+};
+
+} // namespace TracePlayer
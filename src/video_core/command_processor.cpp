@@ -2,16 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/lock.h"
 #include "core/hle/service/gsp/gsp.h"
@@ -58,6 +61,9 @@ static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     return "unknown shader";
 }
 
+/// Only updated by the thread processing command lists
+static DrawStats draw_stats;
+
 static void WriteUniformBoolReg(Shader::ShaderSetup& setup, u32 value) {
     for (unsigned i = 0; i < setup.uniforms.b.size(); ++i)
         setup.uniforms.b[i] = (value & (1 << i)) != 0;
@@ -122,6 +128,143 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/// A distinct vertex of a draw call that has to be loaded and shaded
+struct BatchVertex {
+    u32 index;  ///< Position of the first reference to the vertex in the draw
+    u32 vertex; ///< Vertex number the attributes are loaded from
+};
+
+/**
+ * Maps the vertex numbers referenced by an indexed draw to their slot in the shaded batch.
+ *
+ * The table is direct-mapped over the index range of the current batch, so lookups never search,
+ * and its memory is reused across draws. Entries are tagged with the batch that wrote them, which
+ * avoids clearing the table at the start of every draw.
+ */
+class VertexCache {
+public:
+    static constexpr u32 INVALID_SLOT = 0xFFFFFFFF;
+
+    /// Prepares the cache for a batch referencing vertices in [min_vertex, max_vertex]
+    void BeginBatch(u32 min_vertex, u32 max_vertex) {
+        base_vertex = min_vertex;
+        const std::size_t range = max_vertex >= min_vertex ? max_vertex - min_vertex + 1 : 0;
+        if (entries.size() < range) {
+            entries.resize(range);
+        }
+
+        if (++batch_tag == 0) {
+            // The tag wrapped around, so stale entries could look valid again
+            std::fill(entries.begin(), entries.end(), Entry{});
+            batch_tag = 1;
+        }
+    }
+
+    /// Returns the slot of a vertex, which is INVALID_SLOT if it was not seen in this batch yet
+    u32& Slot(u32 vertex) {
+        Entry& entry = entries[vertex - base_vertex];
+        if (entry.tag != batch_tag) {
+            entry = {batch_tag, INVALID_SLOT};
+        }
+        return entry.slot;
+    }
+
+private:
+    struct Entry {
+        u32 tag = 0;
+        u32 slot = INVALID_SLOT;
+    };
+
+    std::vector<Entry> entries;
+    u32 base_vertex = 0;
+    u32 batch_tag = 0;
+};
+
+/// Minimum number of vertices per task for parallel shading to be worth the synchronization
+constexpr std::size_t MIN_VERTICES_PER_SHADING_TASK = 64;
+
+static Common::ThreadPool& GetVertexShadingPool() {
+    static Common::ThreadPool pool{Common::ThreadPool::DefaultWorkerCount(), "VertexShader"};
+    return pool;
+}
+
+/// Shader units used to shade the vertices of a batch, in groups of the shader engine's batch size
+using ShaderUnits = std::array<Shader::UnitState, Shader::MAX_BATCH_SIZE>;
+
+/// Loads and runs the vertex shader on a range of batch vertices using the given shader units
+static void ShadeVertexRange(const Shader::ShaderEngine& shader_engine, const VertexLoader& loader,
+                             u32 base_address, const BatchVertex* vertices,
+                             Shader::AttributeBuffer* outputs, std::size_t count,
+                             ShaderUnits& shader_units,
+                             DebugUtils::MemoryAccessTracker& memory_accesses) {
+    const auto& regs = g_state.regs;
+    const std::size_t batch_size = shader_engine.BatchSize(g_state.vs);
+    for (std::size_t first = 0; first < count; first += batch_size) {
+        const std::size_t num_units = std::min(batch_size, count - first);
+        for (std::size_t i = 0; i < num_units; ++i) {
+            // Initialize data for the current vertex
+            const BatchVertex& vertex = vertices[first + i];
+            Shader::AttributeBuffer input;
+            loader.LoadVertex(base_address, vertex.index, vertex.vertex, input, memory_accesses);
+
+            if (g_debug_context)
+                g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                         (void*)&input);
+            shader_units[i].LoadInput(regs.vs, input);
+        }
+
+        // Send to vertex shader
+        shader_engine.RunBatch(g_state.vs, shader_units.data(), num_units);
+        for (std::size_t i = 0; i < num_units; ++i) {
+            shader_units[i].WriteOutput(regs.vs, outputs[first + i]);
+        }
+    }
+}
+
+/**
+ * Shades all vertices of a batch. When enabled, the batch is split into chunks that are shaded on
+ * the vertex shading pool with one shader unit per chunk. Debugging features that observe
+ * individual vertices force the single-threaded path.
+ */
+static void ShadeVertices(const Shader::ShaderEngine& shader_engine, const VertexLoader& loader,
+                          u32 base_address, const std::vector<BatchVertex>& vertices,
+                          std::vector<Shader::AttributeBuffer>& outputs,
+                          DebugUtils::MemoryAccessTracker& memory_accesses) {
+    const std::size_t count = vertices.size();
+    const bool observed =
+        g_debug_context &&
+        (g_debug_context->recorder ||
+         g_debug_context->breakpoints[(int)DebugContext::Event::VertexShaderInvocation].enabled);
+
+    if (!VideoCore::g_parallel_vertex_shading_enabled || observed ||
+        count < 2 * MIN_VERTICES_PER_SHADING_TASK) {
+        ShaderUnits shader_units;
+        ShadeVertexRange(shader_engine, loader, base_address, vertices.data(), outputs.data(),
+                         count, shader_units, memory_accesses);
+        return;
+    }
+
+    auto& pool = GetVertexShadingPool();
+    const std::size_t num_tasks =
+        std::min(pool.NumThreads(), count / MIN_VERTICES_PER_SHADING_TASK);
+    // Keep the chunks a multiple of the batch size so that only the last one has a partial batch
+    const std::size_t chunk_size =
+        Common::AlignUp((count + num_tasks - 1) / num_tasks, shader_engine.BatchSize(g_state.vs));
+    pool.ParallelFor(num_tasks, [&](std::size_t task) {
+        const std::size_t begin = task * chunk_size;
+        const std::size_t end = std::min(begin + chunk_size, count);
+        if (begin >= end) {
+            return;
+        }
+
+        // Memory accesses are only tracked for the CiTrace recorder, which is never active here
+        DebugUtils::MemoryAccessTracker unused_accesses;
+        ShaderUnits shader_units;
+        ShadeVertexRange(shader_engine, loader, base_address, vertices.data() + begin,
+                         outputs.data() + begin, end - begin, shader_units, unused_accesses);
+    });
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -292,6 +435,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_debug_context)
             g_debug_context->OnEvent(DebugContext::Event::IncomingPrimitiveBatch, nullptr);
 
+        ++draw_stats.draws;
+        draw_stats.vertices += regs.pipeline.num_vertices;
+
         PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = g_state.primitive_assembler;
 
         bool accelerate_draw = VideoCore::g_hw_shader_enabled && primitive_assembler.IsEmpty();
@@ -354,19 +500,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
-
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
-
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
         g_state.geometry_pipeline.Reconfigure();
@@ -374,58 +508,71 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        const u32 num_vertices = regs.pipeline.num_vertices;
+        const auto get_vertex = [&](u32 index) -> u32 {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
 
-            bool vertex_cache_hit = false;
+        if (g_state.geometry_pipeline.NeedIndexInput()) {
+            for (u32 index = 0; index < num_vertices; ++index) {
+                g_state.geometry_pipeline.SubmitIndex(get_vertex(index));
+            }
+        } else {
+            // Collect the distinct vertices of the batch so that each one is loaded and shaded only
+            // once, and remember which of them every index refers to.
+            static std::vector<BatchVertex> batch_vertices;
+            static std::vector<u32> batch_slots;
+            static std::vector<Shader::AttributeBuffer> batch_outputs;
+            batch_vertices.clear();
+            batch_slots.resize(num_vertices);
 
             if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+                u32 min_vertex = 0xFFFF;
+                u32 max_vertex = 0;
+                for (u32 index = 0; index < num_vertices; ++index) {
+                    const u32 vertex = get_vertex(index);
+                    min_vertex = std::min(min_vertex, vertex);
+                    max_vertex = std::max(max_vertex, vertex);
                 }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                static VertexCache vertex_cache;
+                vertex_cache.BeginBatch(min_vertex, max_vertex);
+                for (u32 index = 0; index < num_vertices; ++index) {
+                    const u32 vertex = get_vertex(index);
+                    if (g_debug_context && g_debug_context->recorder) {
+                        const u32 size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                    u32& slot = vertex_cache.Slot(vertex);
+                    if (slot == VertexCache::INVALID_SLOT) {
+                        slot = static_cast<u32>(batch_vertices.size());
+                        batch_vertices.push_back({index, vertex});
                     }
+                    batch_slots[index] = slot;
                 }
-            }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
-
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
-
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                const u32 misses = static_cast<u32>(batch_vertices.size());
+                MICROPROFILE_META_CPU("Vertex cache hits", num_vertices - misses);
+                MICROPROFILE_META_CPU("Vertex cache misses", misses);
+            } else {
+                for (u32 index = 0; index < num_vertices; ++index) {
+                    batch_vertices.push_back({index, get_vertex(index)});
+                    batch_slots[index] = index;
                 }
             }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            batch_outputs.resize(batch_vertices.size());
+            ShadeVertices(*shader_engine, loader, base_address, batch_vertices, batch_outputs,
+                          memory_accesses);
+
+            // Send to geometry pipeline in the original order
+            for (u32 index = 0; index < num_vertices; ++index) {
+                g_state.geometry_pipeline.SubmitVertex(batch_outputs[batch_slots[index]]);
+            }
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -596,7 +743,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         ASSERT_MSG(lut_config.index < 256, "lut_config.index exceeded maximum value of 255!");
 
-        g_state.lighting.luts[lut_config.type][lut_config.index].raw = value;
+        g_state.lighting.SetLutEntry(lut_config.type, lut_config.index, value);
         lut_config.index.Assign(lut_config.index + 1);
         break;
     }
@@ -623,25 +770,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[7]): {
         auto& index = regs.texturing.proctex_lut_config.index;
-        auto& pt = g_state.proctex;
-
-        switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
-        case TexturingRegs::ProcTexLutTable::Noise:
-            pt.noise_table[index % pt.noise_table.size()].raw = value;
-            break;
-        case TexturingRegs::ProcTexLutTable::ColorMap:
-            pt.color_map_table[index % pt.color_map_table.size()].raw = value;
-            break;
-        case TexturingRegs::ProcTexLutTable::AlphaMap:
-            pt.alpha_map_table[index % pt.alpha_map_table.size()].raw = value;
-            break;
-        case TexturingRegs::ProcTexLutTable::Color:
-            pt.color_table[index % pt.color_table.size()].raw = value;
-            break;
-        case TexturingRegs::ProcTexLutTable::ColorDiff:
-            pt.color_diff_table[index % pt.color_diff_table.size()].raw = value;
-            break;
-        }
+        const auto table = regs.texturing.proctex_lut_config.ref_table.Value();
+        g_state.proctex.SetLutEntry(table, index, value);
         index.Assign(index + 1);
         break;
     }
@@ -686,6 +816,10 @@ void ProcessCommandList(PAddr list, u32 size) {
     }
 }
 
+DrawStats TakeDrawStats() {
+    return std::exchange(draw_stats, {});
+}
+
 static Common::Vec4<u8> DecodePixel(GPU::Regs::PixelFormat input_format, const u8* src_pixel) {
     switch (input_format) {
     case GPU::Regs::PixelFormat::RGBA8:
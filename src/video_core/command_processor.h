@@ -34,8 +34,17 @@ static_assert(std::is_standard_layout<CommandHeader>::value == true,
               "CommandHeader does not use standard layout");
 static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect size!");
 
+/// Work done by the command processor, used to measure the throughput of the GPU emulation
+struct DrawStats {
+    u64 draws = 0;
+    u64 vertices = 0;
+};
+
 void ProcessCommandList(PAddr list, u32 size);
 
+/// Returns the work done since the last call, and resets the counters
+DrawStats TakeDrawStats();
+
 void AfterCommandList();
 
 void ProcessDisplayTransfer(const GPU::Regs::DisplayTransferConfig&);
@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#if defined(_MSC_VER) && defined(ARCHITECTURE_x86_64)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <array>
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/thread.h"
@@ -16,6 +21,39 @@
 
 namespace VideoCore::GPUThread {
 
+/// Executes a single command on the GPU thread
+static void ExecuteCommand(VideoCore::RendererBase& renderer, const CommandRecord& command) {
+    switch (command.type) {
+    case CommandType::SubmitList:
+        Pica::CommandProcessor::ProcessCommandList(command.submit_list.list,
+                                                   command.submit_list.size);
+        break;
+    case CommandType::SwapBuffers:
+        renderer.SwapBuffers();
+        Pica::CommandProcessor::AfterSwapBuffers();
+        break;
+    case CommandType::MemoryFill:
+        Pica::CommandProcessor::ProcessMemoryFill(*command.memory_fill.config);
+        Pica::CommandProcessor::AfterMemoryFill(command.memory_fill.is_second_filler);
+        break;
+    case CommandType::DisplayTransfer:
+        Pica::CommandProcessor::ProcessDisplayTransfer(*command.display_transfer.config);
+        Pica::CommandProcessor::AfterDisplayTransfer();
+        break;
+    case CommandType::FlushRegion:
+        renderer.Rasterizer()->FlushRegion(command.region.addr, command.region.size);
+        break;
+    case CommandType::FlushAndInvalidateRegion:
+        renderer.Rasterizer()->FlushAndInvalidateRegion(command.region.addr, command.region.size);
+        break;
+    case CommandType::InvalidateRegion:
+        renderer.Rasterizer()->InvalidateRegion(command.region.addr, command.region.size);
+        break;
+    default:
+        UNREACHABLE();
+    }
+}
+
 /// Runs the GPU thread
 static void RunThread(VideoCore::RendererBase& renderer, SynchState& state, Core::System& system) {
 
@@ -32,44 +70,102 @@ static void RunThread(VideoCore::RendererBase& renderer, SynchState& state, Core
 
     Frontend::ScopeAcquireContext acquire_context{renderer.GetRenderWindow()};
 
-    CommandDataContainer next;
+    // Commands are popped from the ring in batches to amortize the cost of the atomic index updates
+    std::array<CommandRecord, 64> batch;
     while (state.is_running) {
         state.WaitForCommands();
 
-        CommandDataContainer next;
-        while (state.queue.Pop(next)) {
-            auto command = &next.data;
-            auto fence = next.fence;
-            if (const auto submit_list = std::get_if<SubmitListCommand>(command)) {
-                Pica::CommandProcessor::ProcessCommandList(submit_list->list, submit_list->size);
-            } else if (const auto data = std::get_if<SwapBuffersCommand>(command)) {
-                renderer.SwapBuffers();
-                Pica::CommandProcessor::AfterSwapBuffers();
-            } else if (const auto data = std::get_if<MemoryFillCommand>(command)) {
-                Pica::CommandProcessor::ProcessMemoryFill(*(data->config));
-                const bool is_second_filler = fence & (1llu << 63);
-                Pica::CommandProcessor::AfterMemoryFill(is_second_filler);
-            } else if (const auto data = std::get_if<DisplayTransferCommand>(command)) {
-                Pica::CommandProcessor::ProcessDisplayTransfer(*(data->config));
-                Pica::CommandProcessor::AfterDisplayTransfer();
-            } else if (const auto data = std::get_if<FlushRegionCommand>(command)) {
-                renderer.Rasterizer()->FlushRegion(data->addr, data->size);
-            } else if (const auto data = std::get_if<FlushAndInvalidateRegionCommand>(command)) {
-                renderer.Rasterizer()->FlushAndInvalidateRegion(data->addr, data->size);
-            } else if (const auto data = std::get_if<InvalidateRegionCommand>(command)) {
-                renderer.Rasterizer()->InvalidateRegion(data->addr, data->size);
-            } else {
-                UNREACHABLE();
+        std::size_t count;
+        while ((count = state.queue.Pop(batch.data(), batch.size())) != 0) {
+            for (std::size_t i = 0; i < count; ++i) {
+                ExecuteCommand(renderer, batch[i]);
+                state.SignalFence(batch[i].fence);
             }
-            state.signaled_fence = next.fence;
         }
+
+        // Nothing else is queued, so a command held back for coalescing would only wait
+        if (state.queue.PopPending(batch[0])) {
+            ExecuteCommand(renderer, batch[0]);
+            state.SignalFence(batch[0].fence);
+        }
+    }
+}
+
+void CommandQueue::Push(const CommandRecord& record) {
+    // Only this thread holds commands back, so there is nothing to lock for the other commands
+    if (!record.IsRegionCommand() && !has_pending) {
+        PushToRing(record);
+        return;
+    }
+
+    std::unique_lock lock{pending_mutex};
+    if (has_pending) {
+        const RegionCommand& held = pending.region;
+        const bool mergeable = record.type == pending.type &&
+                               record.region.addr <= held.addr + held.size &&
+                               held.addr <= record.region.addr + record.region.size;
+        if (mergeable) {
+            const VAddr start = std::min(held.addr, record.region.addr);
+            const u64 end =
+                std::max(held.addr + held.size, record.region.addr + record.region.size);
+            pending.region = {start, end - start};
+            // The merged command completes both fences, as fences are signaled in order
+            pending.fence = record.fence;
+            return;
+        }
+        PushToRing(pending);
+        has_pending = false;
+    }
+
+    // Nothing to coalesce with while the GPU thread is idle, so do not hold the command back then
+    if (record.IsRegionCommand() && ring.Size() != 0) {
+        pending = record;
+        has_pending = true;
+        return;
+    }
+
+    lock.unlock();
+    PushToRing(record);
+}
+
+void CommandQueue::Publish() {
+    std::lock_guard lock{pending_mutex};
+    if (has_pending) {
+        PushToRing(pending);
+        has_pending = false;
+    }
+}
+
+bool CommandQueue::PopPending(CommandRecord& out) {
+    if (!has_pending) {
+        return false;
+    }
+    // The producer can hold the lock while waiting for room in the ring, which only this thread
+    // makes, so don't wait for it
+    std::unique_lock lock{pending_mutex, std::try_to_lock};
+    // The commands in the ring are older than the held back one, so they are executed first
+    if (!lock.owns_lock() || !has_pending || ring.Size() != 0) {
+        return false;
+    }
+    out = pending;
+    has_pending = false;
+    return true;
+}
+
+void CommandQueue::PushToRing(const CommandRecord& record) {
+    // The ring is only full when the GPU thread is far behind, so just wait for it to catch up
+    while (ring.Push(&record, 1) == 0) {
+        std::this_thread::yield();
     }
 }
 
 ThreadManager::ThreadManager(Core::System& system, VideoCore::RendererBase& renderer)
     : system{system}, renderer{renderer} {
     synchronize_event = system.CoreTiming().RegisterEvent(
-        "GPUSynchronizeEvent", [this](u64 fence, s64) { state.WaitForSynchronization(fence); });
+        "GPUSynchronizeEvent", [this](u64 fence, s64) {
+            state.queue.Publish();
+            state.WaitForSynchronization(fence);
+        });
 
     thread = std::make_unique<std::thread>(RunThread, std::ref(renderer), std::ref(state),
                                            std::ref(system));
@@ -79,6 +175,7 @@ ThreadManager::ThreadManager(Core::System& system, VideoCore::RendererBase& rend
 ThreadManager::~ThreadManager() {
     // Notify GPU thread that a shutdown is pending
     state.is_running.exchange(false);
+    state.WakeFenceWaiters();
     thread->join();
 }
 
@@ -139,6 +236,7 @@ void ThreadManager::Synchronize(u64 fence, Settings::GpuTimingMode mode) {
     if (timeout_us > 0) {
         system.CoreTiming().ScheduleEvent(usToCycles(timeout_us), synchronize_event, fence);
     } else if (timeout_us == 0) {
+        state.queue.Publish();
         state.WaitForSynchronization(fence);
     }
 }
@@ -148,22 +246,26 @@ void ThreadManager::SubmitList(PAddr list, u32 size) {
         return;
     }
 
-    Synchronize(PushCommand(SubmitListCommand{list, size}),
-                Settings::values.gpu_timing_mode_submit_list);
+    CommandRecord command{CommandType::SubmitList};
+    command.submit_list = {list, size};
+    Synchronize(PushCommand(command), Settings::values.gpu_timing_mode_submit_list);
 }
 
 void ThreadManager::SwapBuffers() {
-    Synchronize(PushCommand(SwapBuffersCommand{}), Settings::values.gpu_timing_mode_swap_buffers);
+    Synchronize(PushCommand(CommandRecord{CommandType::SwapBuffers}),
+                Settings::values.gpu_timing_mode_swap_buffers);
 }
 
 void ThreadManager::DisplayTransfer(const GPU::Regs::DisplayTransferConfig* config) {
-    Synchronize(PushCommand(DisplayTransferCommand{config}),
-                Settings::values.gpu_timing_mode_display_transfer);
+    CommandRecord command{CommandType::DisplayTransfer};
+    command.display_transfer = {config};
+    Synchronize(PushCommand(command), Settings::values.gpu_timing_mode_display_transfer);
 }
 
 void ThreadManager::MemoryFill(const GPU::Regs::MemoryFillConfig* config, bool is_second_filler) {
-    Synchronize(PushCommand(MemoryFillCommand{config, is_second_filler}),
-                Settings::values.gpu_timing_mode_memory_fill);
+    CommandRecord command{CommandType::MemoryFill};
+    command.memory_fill = {config, is_second_filler};
+    Synchronize(PushCommand(command), Settings::values.gpu_timing_mode_memory_fill);
 }
 
 void ThreadManager::FlushRegion(VAddr addr, u64 size) {
@@ -172,8 +274,9 @@ void ThreadManager::FlushRegion(VAddr addr, u64 size) {
     }
 
     if (!IsGpuThread()) {
-        Synchronize(PushCommand(FlushRegionCommand{addr, size}),
-                    Settings::values.gpu_timing_mode_flush);
+        CommandRecord command{CommandType::FlushRegion};
+        command.region = {addr, size};
+        Synchronize(PushCommand(command), Settings::values.gpu_timing_mode_flush);
     } else {
         renderer.Rasterizer()->FlushRegion(addr, size);
     }
@@ -185,7 +288,9 @@ void ThreadManager::FlushAndInvalidateRegion(VAddr addr, u64 size) {
     }
 
     if (!IsGpuThread()) {
-        Synchronize(PushCommand(InvalidateRegionCommand{addr, size}),
+        CommandRecord command{CommandType::InvalidateRegion};
+        command.region = {addr, size};
+        Synchronize(PushCommand(command),
                     Settings::values.gpu_timing_mode_flush_and_invalidate);
     } else {
         renderer.Rasterizer()->InvalidateRegion(addr, size);
@@ -198,29 +303,63 @@ void ThreadManager::InvalidateRegion(VAddr addr, u64 size) {
     }
 
     if (!IsGpuThread()) {
-        Synchronize(PushCommand(InvalidateRegionCommand{addr, size}),
-                    Settings::values.gpu_timing_mode_invalidate);
+        CommandRecord command{CommandType::InvalidateRegion};
+        command.region = {addr, size};
+        Synchronize(PushCommand(command), Settings::values.gpu_timing_mode_invalidate);
     } else {
         renderer.Rasterizer()->InvalidateRegion(addr, size);
     }
 }
 
-u64 ThreadManager::PushCommand(CommandData&& command_data) {
-    const u64 fence{++state.last_fence};
-    state.queue.Push(CommandDataContainer(std::move(command_data), fence));
-    return fence;
+u64 ThreadManager::PushCommand(CommandRecord record) {
+    record.fence = ++state.last_fence;
+    state.queue.Push(record);
+    return record.fence;
 }
 
 MICROPROFILE_DEFINE(GPU_wait, "GPU", "Wait for the GPU", MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(GPU_wait_spin, "GPU", "Wait for the GPU (spin)", MP_RGB(160, 160, 224));
+MICROPROFILE_DEFINE(GPU_wait_park, "GPU", "Wait for the GPU (park)", MP_RGB(96, 96, 160));
+
+/// Hints to the CPU that we are in a spin-wait loop
+static inline void SpinPause() {
+#if defined(_MSC_VER) && defined(ARCHITECTURE_x86_64)
+    _mm_pause();
+#elif defined(ARCHITECTURE_x86_64)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
 void SynchState::WaitForSynchronization(u64 fence) {
-    if (signaled_fence >= fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
         return;
     }
 
     // Wait for the GPU to be idle (all commands to be executed)
     MICROPROFILE_SCOPE(GPU_wait);
-    while (signaled_fence < fence && is_running) {
+
+    // Most waits are satisfied within a few microseconds, so spin for a short while first.
+    constexpr int spin_count{1024};
+    {
+        MICROPROFILE_SCOPE(GPU_wait_spin);
+        for (int i = 0; i < spin_count; ++i) {
+            if (signaled_fence.load(std::memory_order_acquire) >= fence || !is_running) {
+                return;
+            }
+            SpinPause();
+        }
     }
+
+    // The GPU thread is still busy, park until it signals the fence
+    MICROPROFILE_SCOPE(GPU_wait_park);
+    std::unique_lock lock{fence_mutex};
+    ++fence_waiters;
+    fence_condition.wait(lock, [this, fence] { return signaled_fence >= fence || !is_running; });
+    --fence_waiters;
 }
 
 } // namespace VideoCore::GPUThread
@@ -13,8 +13,8 @@
 #include <mutex>
 #include <optional>
 #include <thread>
-#include <variant>
-#include "common/threadsafe_queue.h"
+#include <type_traits>
+#include "common/ring_buffer.h"
 #include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
 #include "core/settings.h"
@@ -26,105 +26,103 @@ class RendererBase;
 
 namespace VideoCore::GPUThread {
 
+/// Type of a command queued for the GPU thread
+enum class CommandType : u32 {
+    SubmitList,
+    SwapBuffers,
+    MemoryFill,
+    DisplayTransfer,
+    FlushRegion,
+    FlushAndInvalidateRegion,
+    InvalidateRegion,
+};
+
 /// Command to signal to the GPU thread that a command list is ready for processing
 struct SubmitListCommand {
-    // In order for the variant to be default constructable, the first element needs a default
-    // constructor
-    constexpr SubmitListCommand() : list(0), size(0) {}
-    explicit constexpr SubmitListCommand(PAddr list, u32 size) : list(list), size(size) {}
     PAddr list;
     u32 size;
 };
 
-static_assert(std::is_copy_assignable<SubmitListCommand>::value,
-              "SubmitListCommand is not copy assignable");
-static_assert(std::is_copy_constructible<SubmitListCommand>::value,
-              "SubmitListCommand is not copy constructable");
-
-/// Command to signal to the GPU thread that a swap buffers is pending
-struct SwapBuffersCommand final {
-    explicit constexpr SwapBuffersCommand() {}
-};
-
-static_assert(std::is_copy_assignable<SwapBuffersCommand>::value,
-              "SwapBuffersCommand is not copy assignable");
-static_assert(std::is_copy_constructible<SwapBuffersCommand>::value,
-              "SwapBuffersCommand is not copy constructable");
-
-struct MemoryFillCommand final {
-    explicit constexpr MemoryFillCommand(const GPU::Regs::MemoryFillConfig* config,
-                                         bool is_second_filler)
-        : config{config}, is_second_filler(is_second_filler) {}
-
+struct MemoryFillCommand {
     const GPU::Regs::MemoryFillConfig* config;
     bool is_second_filler;
 };
 
-static_assert(std::is_copy_assignable<MemoryFillCommand>::value,
-              "MemoryFillCommand is not copy assignable");
-static_assert(std::is_copy_constructible<MemoryFillCommand>::value,
-              "MemoryFillCommand is not copy constructable");
-
-struct DisplayTransferCommand final {
-    explicit constexpr DisplayTransferCommand(const GPU::Regs::DisplayTransferConfig* config)
-        : config{config} {}
-
+struct DisplayTransferCommand {
     const GPU::Regs::DisplayTransferConfig* config;
 };
-static_assert(std::is_copy_assignable<DisplayTransferCommand>::value,
-              "DisplayTransferCommand is not copy assignable");
-static_assert(std::is_copy_constructible<DisplayTransferCommand>::value,
-              "DisplayTransferCommand is not copy constructable");
-
-/// Command to signal to the GPU thread to flush a region
-struct FlushRegionCommand final {
-    explicit constexpr FlushRegionCommand(VAddr addr, u64 size) : addr{addr}, size{size} {}
 
+/// Command to signal to the GPU thread to flush and/or invalidate a region
+struct RegionCommand {
     VAddr addr;
     u64 size;
 };
-static_assert(std::is_copy_assignable<FlushRegionCommand>::value,
-              "FlushRegionCommand is not copy assignable");
-static_assert(std::is_copy_constructible<FlushRegionCommand>::value,
-              "FlushRegionCommand is not copy constructable");
 
-/// Command to signal to the GPU thread to flush and invalidate a region
-struct FlushAndInvalidateRegionCommand final {
-    explicit constexpr FlushAndInvalidateRegionCommand(VAddr addr, u64 size)
-        : addr{addr}, size{size} {}
-
-    VAddr addr;
-    u64 size;
+/// Plain-old-data record of a single GPU command, so that commands can be copied in and out of a
+/// preallocated ring without any per-command allocation.
+struct CommandRecord {
+    CommandType type;
+    u64 fence;
+    union {
+        SubmitListCommand submit_list;
+        MemoryFillCommand memory_fill;
+        DisplayTransferCommand display_transfer;
+        RegionCommand region;
+    };
+
+    /// Returns true if this is a flush and/or invalidate command
+    bool IsRegionCommand() const {
+        return type == CommandType::FlushRegion ||
+               type == CommandType::FlushAndInvalidateRegion ||
+               type == CommandType::InvalidateRegion;
+    }
 };
-static_assert(std::is_copy_assignable<FlushAndInvalidateRegionCommand>::value,
-              "FlushAndInvalidateRegionCommand is not copy assignable");
-static_assert(std::is_copy_constructible<FlushAndInvalidateRegionCommand>::value,
-              "FlushAndInvalidateRegionCommand is not copy constructable");
 
-/// Command to signal to the GPU thread to flush a region
-struct InvalidateRegionCommand final {
-    explicit constexpr InvalidateRegionCommand(VAddr addr, u64 size) : addr{addr}, size{size} {}
+static_assert(std::is_trivial_v<CommandRecord>, "CommandRecord must be trivial");
 
-    VAddr addr;
-    u64 size;
-};
-static_assert(std::is_copy_assignable<InvalidateRegionCommand>::value,
-              "InvalidateRegionCommand is not copy assignable");
-static_assert(std::is_copy_constructible<InvalidateRegionCommand>::value,
-              "InvalidateRegionCommand is not copy constructable");
+/// Single-producer, single-consumer queue of GPU commands backed by a preallocated ring.
+/// Consecutive flush/invalidate commands of the same type whose ranges overlap or touch are
+/// coalesced on the producer side, so the consumer only sees a single command for them.
+class CommandQueue final {
+public:
+    /// Number of records the ring can hold before the producer has to wait
+    static constexpr std::size_t capacity = 4096;
+
+    /// Queues a command. Region commands may be held back for coalescing until Publish is called,
+    /// a command that cannot be merged with them is pushed, or the consumer runs out of commands.
+    /// Producer thread only.
+    void Push(const CommandRecord& record);
+
+    /// Makes any held back region command visible to the consumer. Producer thread only.
+    void Publish();
 
-using CommandData =
-    std::variant<SubmitListCommand, SwapBuffersCommand, MemoryFillCommand, DisplayTransferCommand,
-                 FlushRegionCommand, FlushAndInvalidateRegionCommand, InvalidateRegionCommand>;
+    /// Pops up to max_count records into out, returning the number of records popped.
+    /// Consumer thread only.
+    std::size_t Pop(CommandRecord* out, std::size_t max_count) {
+        return ring.Pop(out, max_count);
+    }
+
+    /// Takes the held back region command once the ring has been drained, so that it is executed
+    /// even if the producer doesn't push or publish anything else. Consumer thread only.
+    bool PopPending(CommandRecord& out);
+
+    /// Returns the number of records in the ring, without the held back command
+    std::size_t Size() const {
+        return ring.Size();
+    }
 
-struct CommandDataContainer {
-    CommandDataContainer() = default;
+    bool Empty() const {
+        return Size() == 0 && !has_pending;
+    }
 
-    CommandDataContainer(CommandData&& data, u64 next_fence)
-        : data{std::move(data)}, fence{next_fence} {}
+private:
+    void PushToRing(const CommandRecord& record);
 
-    CommandData data;
-    u64 fence{};
+    Common::RingBuffer<CommandRecord, capacity> ring;
+    /// Guards the held back command, which both threads can take
+    std::mutex pending_mutex;
+    CommandRecord pending{};
+    std::atomic_bool has_pending{};
 };
 
 /// Struct used to synchronize the GPU thread
@@ -150,8 +148,28 @@ struct SynchState final {
         }
     }
 
+    /// Blocks the calling thread until the GPU thread has signaled the given fence. Spins briefly
+    /// before parking on fence_condition, so short waits do not pay for a context switch and long
+    /// waits do not burn a host core.
     void WaitForSynchronization(u64 fence);
 
+    /// Called by the GPU thread after each command to publish its fence and wake parked waiters
+    void SignalFence(u64 fence) {
+        // Both sides use sequentially consistent accesses so that either the waiter observes the
+        // new fence or we observe the waiter and notify it.
+        signaled_fence.store(fence);
+        if (fence_waiters.load() != 0) {
+            std::lock_guard lock{fence_mutex};
+            fence_condition.notify_all();
+        }
+    }
+
+    /// Wakes any thread parked in WaitForSynchronization, used on shutdown
+    void WakeFenceWaiters() {
+        std::lock_guard lock{fence_mutex};
+        fence_condition.notify_all();
+    }
+
     void SignalCommands() {
         if (queue.Empty()) {
             return;
@@ -169,10 +187,13 @@ struct SynchState final {
         // commands_condition.wait(lock, [this] { return !queue.Empty(); });
     }
 
-    using CommandQueue = Common::SPSCQueue<CommandDataContainer>;
     CommandQueue queue;
     u64 last_fence{};
     std::atomic<u64> signaled_fence{};
+
+    std::mutex fence_mutex;
+    std::condition_variable fence_condition;
+    std::atomic_int fence_waiters{};
 };
 
 /// Class used to manage the GPU thread
@@ -199,7 +220,7 @@ private:
     void Synchronize(u64 fence, Settings::GpuTimingMode mode);
 
     /// Pushes a command to be executed by the GPU thread
-    u64 PushCommand(CommandData&& command_data);
+    u64 PushCommand(CommandRecord record);
 
     /// Returns true if this is called by the GPU thread
     bool IsGpuThread() const {
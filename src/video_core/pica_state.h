@@ -96,7 +96,66 @@ struct State {
         UnionArray<ColorEntry, 256> color_table;
         UnionArray<ColorDifferenceEntry, 256> color_diff_table;
 
+        /// The noise, color map and alpha map LUTs converted to {value, difference} pairs of
+        /// floats, so that the software renderer doesn't convert them for every fragment
+        std::array<Common::Vec2<float>, 128> float_noise_table{};
+        std::array<Common::Vec2<float>, 128> float_color_map_table{};
+        std::array<Common::Vec2<float>, 128> float_alpha_map_table{};
+        /// The color and color difference LUTs converted to floats, used by the linear filters
+        std::array<Common::Vec4<float>, 256> float_color_table{};
+        std::array<Common::Vec4<float>, 256> float_color_diff_table{};
+
+        /// Writes an entry of a LUT and updates its float version. The index wraps around the
+        /// size of the LUT.
+        void SetLutEntry(TexturingRegs::ProcTexLutTable table, std::size_t index, u32 raw) {
+            switch (table) {
+            case TexturingRegs::ProcTexLutTable::Noise:
+                SetValueEntry(noise_table, float_noise_table, index, raw);
+                break;
+            case TexturingRegs::ProcTexLutTable::ColorMap:
+                SetValueEntry(color_map_table, float_color_map_table, index, raw);
+                break;
+            case TexturingRegs::ProcTexLutTable::AlphaMap:
+                SetValueEntry(alpha_map_table, float_alpha_map_table, index, raw);
+                break;
+            case TexturingRegs::ProcTexLutTable::Color:
+                index %= color_table.size();
+                color_table[index].raw = raw;
+                float_color_table[index] = color_table[index].ToVector().Cast<float>();
+                break;
+            case TexturingRegs::ProcTexLutTable::ColorDiff:
+                index %= color_diff_table.size();
+                color_diff_table[index].raw = raw;
+                float_color_diff_table[index] = color_diff_table[index].ToVector().Cast<float>();
+                break;
+            }
+        }
+
+        /// Converts all the LUTs to floats again, after they were written directly
+        void UpdateFloatLuts() {
+            for (std::size_t index = 0; index < 128; ++index) {
+                SetLutEntry(TexturingRegs::ProcTexLutTable::Noise, index, noise_table[index].raw);
+                SetLutEntry(TexturingRegs::ProcTexLutTable::ColorMap, index,
+                            color_map_table[index].raw);
+                SetLutEntry(TexturingRegs::ProcTexLutTable::AlphaMap, index,
+                            alpha_map_table[index].raw);
+            }
+            for (std::size_t index = 0; index < 256; ++index) {
+                SetLutEntry(TexturingRegs::ProcTexLutTable::Color, index, color_table[index].raw);
+                SetLutEntry(TexturingRegs::ProcTexLutTable::ColorDiff, index,
+                            color_diff_table[index].raw);
+            }
+        }
+
     private:
+        static void SetValueEntry(UnionArray<ValueEntry, 128>& lut,
+                                  std::array<Common::Vec2<float>, 128>& float_lut,
+                                  std::size_t index, u32 raw) {
+            index %= lut.size();
+            lut[index].raw = raw;
+            float_lut[index] = {lut[index].ToFloat(), lut[index].DiffToFloat()};
+        }
+
         friend class boost::serialization::access;
         template <class Archive>
         void serialize(Archive& ar, const unsigned int file_version) {
@@ -136,6 +195,25 @@ struct State {
         };
 
         std::array<UnionArray<LutEntry, 256>, 24> luts;
+
+        /// The LUT entries converted to {value, difference} pairs of floats, so that the software
+        /// renderer doesn't convert them for every fragment. Kept in sync by SetLutEntry.
+        std::array<std::array<Common::Vec2<float>, 256>, 24> float_luts{};
+
+        /// Writes an entry of a LUT and updates its float version
+        void SetLutEntry(std::size_t lut, std::size_t index, u32 raw) {
+            luts[lut][index].raw = raw;
+            float_luts[lut][index] = {luts[lut][index].ToFloat(), luts[lut][index].DiffToFloat()};
+        }
+
+        /// Converts all the LUTs to floats again, after they were written directly
+        void UpdateFloatLuts() {
+            for (std::size_t lut = 0; lut < luts.size(); ++lut) {
+                for (std::size_t index = 0; index < luts[lut].size(); ++index) {
+                    SetLutEntry(lut, index, luts[lut][index].raw);
+                }
+            }
+        }
     } lighting;
 
     struct {
@@ -246,6 +324,8 @@ private:
         cmd_list.head_ptr =
             reinterpret_cast<u32*>(VideoCore::g_memory->GetPhysicalPointer(cmd_list.addr));
         cmd_list.current_ptr = cmd_list.head_ptr + offset;
+        proctex.UpdateFloatLuts();
+        lighting.UpdateFloatLuts();
     }
 };
 
@@ -2043,11 +2043,9 @@ void RasterizerOpenGL::SyncAndUploadLUTsLF() {
         for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
             if (uniform_block_data.lighting_lut_dirty[index] || invalidate) {
                 std::array<GLvec2, 256> new_data;
-                const auto& source_lut = Pica::g_state.lighting.luts[index];
+                const auto& source_lut = Pica::g_state.lighting.float_luts[index];
                 std::transform(source_lut.begin(), source_lut.end(), new_data.begin(),
-                               [](const auto& entry) {
-                                   return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                               });
+                               [](const auto& entry) { return GLvec2{entry.x, entry.y}; });
 
                 if (new_data != lighting_lut_data[index] || invalidate) {
                     lighting_lut_data[index] = new_data;
@@ -2108,12 +2106,11 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
 
     // helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
     auto SyncProcTexValueLUT = [this, buffer, offset, invalidate, &bytes_used](
-                                   const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
+                                   const std::array<Common::Vec2<float>, 128>& lut,
                                    std::array<GLvec2, 128>& lut_data, GLint& lut_offset) {
         std::array<GLvec2, 128> new_data;
-        std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-            return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-        });
+        std::transform(lut.begin(), lut.end(), new_data.begin(),
+                       [](const auto& entry) { return GLvec2{entry.x, entry.y}; });
 
         if (new_data != lut_data || invalidate) {
             lut_data = new_data;
@@ -2126,21 +2123,21 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
 
     // Sync the proctex noise lut
     if (uniform_block_data.proctex_noise_lut_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
+        SyncProcTexValueLUT(Pica::g_state.proctex.float_noise_table, proctex_noise_lut_data,
                             uniform_block_data.data.proctex_noise_lut_offset);
         uniform_block_data.proctex_noise_lut_dirty = false;
     }
 
     // Sync the proctex color map
     if (uniform_block_data.proctex_color_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
+        SyncProcTexValueLUT(Pica::g_state.proctex.float_color_map_table, proctex_color_map_data,
                             uniform_block_data.data.proctex_color_map_offset);
         uniform_block_data.proctex_color_map_dirty = false;
     }
 
     // Sync the proctex alpha map
     if (uniform_block_data.proctex_alpha_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
+        SyncProcTexValueLUT(Pica::g_state.proctex.float_alpha_map_table, proctex_alpha_map_data,
                             uniform_block_data.data.proctex_alpha_map_offset);
         uniform_block_data.proctex_alpha_map_dirty = false;
     }
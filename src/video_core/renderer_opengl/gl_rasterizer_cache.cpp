@@ -39,6 +39,7 @@
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/texture_downloader_es.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filterer.h"
+#include "video_core/texture/morton_swizzle.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
 
@@ -89,39 +90,32 @@ static constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
 
 template <bool morton_to_gl, PixelFormat format>
 static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
+    using Pica::Texture::PixelConversion;
     constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if constexpr (morton_to_gl) {
-                if constexpr (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else if (format == PixelFormat::RGBA8 && GLES) {
-                    // because GLES does not have ABGR format
-                    // so we will do byteswapping here
-                    gl_ptr[0] = tile_ptr[3];
-                    gl_ptr[1] = tile_ptr[2];
-                    gl_ptr[2] = tile_ptr[1];
-                    gl_ptr[3] = tile_ptr[0];
-                } else if (format == PixelFormat::RGB8 && GLES) {
-                    gl_ptr[0] = tile_ptr[2];
-                    gl_ptr[1] = tile_ptr[1];
-                    gl_ptr[2] = tile_ptr[0];
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if constexpr (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
+    constexpr PixelConversion conversion =
+        format == PixelFormat::D24S8
+            ? PixelConversion::StencilFirst
+            : format == PixelFormat::D24 ? PixelConversion::PadTo4Bytes : PixelConversion::None;
+
+    // The rows of the tile are stored bottom to top in gl_buffer
+    u8* const gl_row = gl_buffer + 7 * stride * gl_bytes_per_pixel;
+    const auto gl_pitch = -static_cast<std::ptrdiff_t>(stride * gl_bytes_per_pixel);
+    if constexpr (morton_to_gl) {
+        if constexpr (format == PixelFormat::RGBA8 || format == PixelFormat::RGB8) {
+            if (GLES) {
+                // because GLES does not have ABGR format
+                // so we will do byteswapping here
+                Pica::Texture::MortonToLinearTile<bytes_per_pixel, PixelConversion::ReverseBytes>(
+                    tile_buffer, gl_row, gl_pitch);
+                return;
             }
         }
+        Pica::Texture::MortonToLinearTile<bytes_per_pixel, conversion>(tile_buffer, gl_row,
+                                                                      gl_pitch);
+    } else {
+        Pica::Texture::LinearToMortonTile<bytes_per_pixel, conversion>(tile_buffer, gl_row,
+                                                                      gl_pitch);
     }
 }
 
@@ -132,7 +126,6 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
     static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
-    gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
 
     const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
     const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
@@ -564,12 +557,22 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
             const auto rect = GetSubRect(FromInterval(load_interval));
             ASSERT(FromInterval(load_interval).GetInterval() == load_interval);
 
-            for (unsigned y = rect.bottom; y < rect.top; ++y) {
-                for (unsigned x = rect.left; x < rect.right; ++x) {
-                    auto vec4 =
-                        Pica::Texture::LookupTexture(texture_src_data, x, height - 1 - y, tex_info);
-                    const std::size_t offset = (x + (width * y)) * 4;
-                    std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+            if (load_start == addr && load_end == end) {
+                // The whole texture is in memory, so it can be decoded tile by tile
+                std::vector<Common::Vec4<u8>> decoded(width * height);
+                Pica::Texture::DecodeTexture(tex_info, texture_src_data, decoded.data());
+                for (unsigned y = 0; y < height; ++y) {
+                    std::memcpy(&gl_buffer[width * y * 4], &decoded[width * (height - 1 - y)],
+                                width * 4);
+                }
+            } else {
+                for (unsigned y = rect.bottom; y < rect.top; ++y) {
+                    for (unsigned x = rect.left; x < rect.right; ++x) {
+                        auto vec4 = Pica::Texture::LookupTexture(texture_src_data, x,
+                                                                 height - 1 - y, tex_info);
+                        const std::size_t offset = (x + (width * y)) * 4;
+                        std::memcpy(&gl_buffer[offset], vec4.AsArray(), 4);
+                    }
                 }
             }
         } else {
@@ -1731,24 +1734,26 @@ bool RasterizerCacheOpenGL::ValidateByReinterpretation(const Surface& surface,
 }
 
 void RasterizerCacheOpenGL::ClearAll(bool flush) {
-    const auto flush_interval = PageMap::interval_type::right_open(0x0, 0xFFFFFFFF);
+    const auto flush_interval = BlockMap::interval_type::right_open(0x0, 0xFFFFFFFF);
     // Force flush all surfaces from the cache
     if (flush) {
         FlushRegion(0x0, 0xFFFFFFFF);
     }
-    // Unmark all of the marked pages
-    for (auto& pair : RangeFromInterval(cached_pages, flush_interval)) {
+    // Unmark all of the marked blocks
+    for (auto& pair : RangeFromInterval(cached_blocks, flush_interval)) {
         const auto interval = pair.first & flush_interval;
 
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+        const PAddr interval_start_addr = boost::icl::first(interval)
+                                          << Memory::RASTERIZER_CACHE_BLOCK_BITS;
+        const PAddr interval_end_addr = boost::icl::last_next(interval)
+                                        << Memory::RASTERIZER_CACHE_BLOCK_BITS;
         const u32 interval_size = interval_end_addr - interval_start_addr;
 
         VideoCore::g_memory->RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
     }
 
     // Remove the whole cache without really looking at it.
-    cached_pages -= flush_interval;
+    cached_blocks -= flush_interval;
     dirty_regions -= SurfaceInterval(0x0, 0xFFFFFFFF);
     surface_cache -= SurfaceInterval(0x0, 0xFFFFFFFF);
     remove_surfaces.clear();
@@ -1877,7 +1882,7 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
     }
     surface->registered = true;
     surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
-    UpdatePagesCachedCount(surface->addr, surface->size, 1);
+    UpdateBlocksCachedCount(surface->addr, surface->size, 1);
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -1887,28 +1892,28 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = false;
-    UpdatePagesCachedCount(surface->addr, surface->size, -1);
+    UpdateBlocksCachedCount(surface->addr, surface->size, -1);
     surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
 }
 
-void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
-    const u32 num_pages =
-        ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
-    const u32 page_start = addr >> Memory::PAGE_BITS;
-    const u32 page_end = page_start + num_pages;
+void RasterizerCacheOpenGL::UpdateBlocksCachedCount(PAddr addr, u32 size, int delta) {
+    const u32 block_start = addr >> Memory::RASTERIZER_CACHE_BLOCK_BITS;
+    const u32 block_end = ((addr + size - 1) >> Memory::RASTERIZER_CACHE_BLOCK_BITS) + 1;
 
     // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
     // subtract after iterating
-    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
+    const auto blocks_interval = BlockMap::interval_type::right_open(block_start, block_end);
     if (delta > 0)
-        cached_pages.add({pages_interval, delta});
+        cached_blocks.add({blocks_interval, delta});
 
-    for (const auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
+    for (const auto& pair : RangeFromInterval(cached_blocks, blocks_interval)) {
+        const auto interval = pair.first & blocks_interval;
         const int count = pair.second;
 
-        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
+        const PAddr interval_start_addr = boost::icl::first(interval)
+                                          << Memory::RASTERIZER_CACHE_BLOCK_BITS;
+        const PAddr interval_end_addr = boost::icl::last_next(interval)
+                                        << Memory::RASTERIZER_CACHE_BLOCK_BITS;
         const u32 interval_size = interval_end_addr - interval_start_addr;
 
         if (delta > 0 && count == delta)
@@ -1922,7 +1927,7 @@ void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int del
     }
 
     if (delta < 0)
-        cached_pages.add({pages_interval, delta});
+        cached_blocks.add({blocks_interval, delta});
 }
 
 } // namespace OpenGL
@@ -96,7 +96,8 @@ static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval
 using SurfaceRect_Tuple = std::tuple<Surface, Common::Rectangle<u32>>;
 using SurfaceSurfaceRect_Tuple = std::tuple<Surface, Surface, Common::Rectangle<u32>>;
 
-using PageMap = boost::icl::interval_map<u32, int>;
+/// Number of surfaces in each block of Memory::RASTERIZER_CACHE_BLOCK_SIZE bytes
+using BlockMap = boost::icl::interval_map<u32, int>;
 
 enum class ScaleMatch {
     Exact,   // only accept same res scale
@@ -332,11 +333,11 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+    /// Increase/decrease the number of surface in the blocks touching the specified region
+    void UpdateBlocksCachedCount(PAddr addr, u32 size, int delta);
 
     SurfaceCache surface_cache;
-    PageMap cached_pages;
+    BlockMap cached_blocks;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
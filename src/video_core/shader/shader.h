@@ -29,6 +29,8 @@ namespace Pica::Shader {
 
 constexpr unsigned MAX_PROGRAM_CODE_LENGTH = 4096;
 constexpr unsigned MAX_SWIZZLE_DATA_LENGTH = 4096;
+/// Maximum number of shader units that ShaderEngine::RunBatch runs at once
+constexpr std::size_t MAX_BATCH_SIZE = 8;
 using ProgramCode = std::array<u32, MAX_PROGRAM_CODE_LENGTH>;
 using SwizzleData = std::array<u32, MAX_SWIZZLE_DATA_LENGTH>;
 
@@ -278,6 +280,8 @@ struct ShaderSetup {
         unsigned int entry_point;
         /// Used by the JIT, points to a compiled shader object.
         const void* cached_shader = nullptr;
+        /// Used by the JIT, points to a shader object compiled to run batches of units.
+        const void* cached_batch_shader = nullptr;
     } engine_data;
 
     void MarkProgramCodeDirty() {
@@ -340,6 +344,25 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /// Returns the number of units that RunBatch runs at once with the currently setup shader.
+    virtual std::size_t BatchSize(const ShaderSetup& setup) const {
+        return 1;
+    }
+
+    /**
+     * Runs the currently setup shader on several units, which is faster than running them one by
+     * one for engines with a batch size larger than one.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states, must be setup with input data before each invocation.
+     * @param count Number of units to run, at most MAX_BATCH_SIZE.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const {
+        for (std::size_t i = 0; i < count; ++i) {
+            Run(setup, states[i]);
+        }
+    }
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
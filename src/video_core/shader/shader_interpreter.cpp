@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <iterator>
 #include <numeric>
 #include <boost/container/static_vector.hpp>
 #include <boost/range/algorithm/fill.hpp>
@@ -34,6 +35,7 @@ struct CallStackElement {
     u8 loop_increment;  // Which value to add to the loop counter after an iteration
                         // TODO: Should this be a signed value? Does it even matter?
     u32 loop_address;   // The address where we'll return to after each loop iteration
+    bool is_loop;       // Whether this element is a LOOP, which BREAKC leaves
 };
 
 template <bool Debug>
@@ -47,12 +49,13 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     state.conditional_code[1] = false;
 
     auto call = [&program_counter, &call_stack](u32 offset, u32 num_instructions, u32 return_offset,
-                                                u8 repeat_count, u8 loop_increment) {
+                                                u8 repeat_count, u8 loop_increment,
+                                                bool is_loop = false) {
         // -1 to make sure when incrementing the PC we end up at the correct offset
         program_counter = offset - 1;
         ASSERT(call_stack.size() < call_stack.capacity());
-        call_stack.push_back(
-            {offset + num_instructions, return_offset, repeat_count, loop_increment, offset});
+        call_stack.push_back({offset + num_instructions, return_offset, repeat_count,
+                              loop_increment, offset, is_loop});
     };
 
     auto evaluate_condition = [&state](Instruction::FlowControlType flow_control) {
@@ -564,6 +567,24 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 }
                 break;
 
+            case OpCode::Id::BREAKC: {
+                Record<DebugDataRecord::COND_CMP_IN>(debug_data, iteration, state.conditional_code);
+                if (!evaluate_condition(instr.flow_control)) {
+                    break;
+                }
+
+                // Leave the innermost loop, along with the blocks entered inside of it
+                const auto loop = std::find_if(call_stack.rbegin(), call_stack.rend(),
+                                               [](const auto& element) { return element.is_loop; });
+                if (loop == call_stack.rend()) {
+                    LOG_ERROR(HW_GPU, "BREAKC outside of a LOOP at 0x{:03x}", program_counter);
+                    break;
+                }
+                program_counter = loop->return_address - 1;
+                call_stack.erase(std::prev(loop.base()), call_stack.end());
+                break;
+            }
+
             case OpCode::Id::CALL:
                 call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
                      program_counter + 1, 0, 0);
@@ -630,7 +651,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
                 Record<DebugDataRecord::LOOP_INT_IN>(debug_data, iteration, loop_param);
                 call(program_counter + 1, instr.flow_control.dest_offset - program_counter,
-                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z);
+                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z, true);
                 break;
             }
 
@@ -2,15 +2,50 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <optional>
+#include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
+#include "video_core/shader/shader_jit_x64_batch_compiler.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_jit_x64_disk_cache.h"
+#include "video_core/video_core.h"
 
 namespace Pica::Shader {
 
-JitX64Engine::JitX64Engine() = default;
-JitX64Engine::~JitX64Engine() = default;
+/// Maximum number of batch shaders kept compiled for a setup, as each one reserves
+/// MAX_BATCH_SHADER_SIZE bytes of code while games only switch between a few shaders in a frame
+constexpr std::size_t MAX_BATCH_CACHE_ENTRIES = 16;
+
+JitX64Engine::JitX64Engine() {
+    if (!VideoCore::g_use_disk_shader_cache) {
+        return;
+    }
+
+    // Skip games without title id
+    u64 program_id = 0;
+    if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) !=
+            Loader::ResultStatus::Success ||
+        program_id == 0) {
+        return;
+    }
+    disk_cache = std::make_unique<JitDiskCache>(program_id);
+}
+
+JitX64Engine::~JitX64Engine() {
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    LOG_INFO(HW_GPU, "Shader JIT loaded {} shaders in {:.2f} ms and compiled {} in {:.2f} ms",
+             shaders_loaded, Milliseconds(load_time).count(), shaders_compiled,
+             Milliseconds(compile_time).count());
+
+    if (disk_cache) {
+        disk_cache->Save();
+    }
+}
 
 void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
@@ -24,11 +59,55 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     if (iter != cache.end()) {
         setup.engine_data.cached_shader = iter->second.get();
     } else {
+        const auto start = std::chrono::steady_clock::now();
         auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
+        std::optional<JitShaderImage> image;
+        if (disk_cache) {
+            image = disk_cache->Find(code_hash, swizzle_hash);
+        }
+        if (image) {
+            shader->LoadImage(*image);
+            load_time += std::chrono::steady_clock::now() - start;
+            ++shaders_loaded;
+        } else {
+            shader->Compile(&setup.program_code, &setup.swizzle_data);
+            if (disk_cache) {
+                disk_cache->Add(code_hash, swizzle_hash, shader->GetImage());
+            }
+            compile_time += std::chrono::steady_clock::now() - start;
+            ++shaders_compiled;
+        }
         setup.engine_data.cached_shader = shader.get();
         cache.emplace_hint(iter, cache_key, std::move(shader));
     }
+
+    const std::size_t batch_size = VideoCore::g_shader_jit_batch_size;
+    BatchCache& batch_cache = batch_caches[&setup];
+    if (batch_size != batch_cache.batch_size) {
+        batch_cache.entries.clear();
+        batch_cache.batch_size = batch_size;
+    }
+
+    setup.engine_data.cached_batch_shader = nullptr;
+    if ((batch_size == 4 || batch_size == 8) && JitBatchShader::IsSupported()) {
+        auto& entries = batch_cache.entries;
+        auto batch_iter = entries.find(cache_key);
+        if (batch_iter == entries.end()) {
+            if (entries.size() >= MAX_BATCH_CACHE_ENTRIES) {
+                const auto lru = std::min_element(
+                    entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                        return a.second.last_use < b.second.last_use;
+                    });
+                entries.erase(lru);
+            }
+            auto shader = std::make_unique<JitBatchShader>(batch_size);
+            shader->Compile(&setup.program_code, &setup.swizzle_data);
+            batch_iter = entries.emplace(cache_key, BatchCacheEntry{std::move(shader)}).first;
+        }
+        batch_iter->second.last_use = ++batch_cache.clock;
+        batch_iter->second.shader->PrepareEntryPoint(entry_point);
+        setup.engine_data.cached_batch_shader = batch_iter->second.shader.get();
+    }
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
@@ -42,4 +121,24 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+std::size_t JitX64Engine::BatchSize(const ShaderSetup& setup) const {
+    const auto* shader = static_cast<const JitBatchShader*>(setup.engine_data.cached_batch_shader);
+    return shader ? shader->BatchSize() : 1;
+}
+
+void JitX64Engine::RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const {
+    const auto* shader = static_cast<const JitBatchShader*>(setup.engine_data.cached_batch_shader);
+    if (shader && count == shader->BatchSize()) {
+        MICROPROFILE_SCOPE(GPU_Shader);
+        if (shader->Run(setup, states, setup.engine_data.entry_point)) {
+            return;
+        }
+    }
+
+    // Partial batches, and batches whose units diverge, are run one unit at a time
+    for (std::size_t i = 0; i < count; ++i) {
+        Run(setup, states[i]);
+    }
+}
+
 } // namespace Pica::Shader
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include "common/common_types.h"
@@ -11,6 +12,8 @@
 
 namespace Pica::Shader {
 
+class JitBatchShader;
+class JitDiskCache;
 class JitShader;
 
 class JitX64Engine final : public ShaderEngine {
@@ -20,9 +23,35 @@ public:
 
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    std::size_t BatchSize(const ShaderSetup& setup) const override;
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
 
 private:
     std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+
+    /// Shaders compiled in previous sessions of the running title, if the disk cache is enabled
+    std::unique_ptr<JitDiskCache> disk_cache;
+
+    /// Statistics on how shaders were obtained, logged when the engine is destroyed
+    std::size_t shaders_loaded = 0;
+    std::size_t shaders_compiled = 0;
+    std::chrono::nanoseconds load_time{};
+    std::chrono::nanoseconds compile_time{};
+
+    /// Shader compiled for batches of units, with the clock value of its last setup so that the
+    /// least recently used one can be evicted
+    struct BatchCacheEntry {
+        std::unique_ptr<JitBatchShader> shader;
+        u64 last_use = 0;
+    };
+    /// Batch shaders of a setup, compiled for batches of batch_size units. Each setup has its own
+    /// cache, so that evicting or clearing its shaders never leaves another setup pointing to one.
+    struct BatchCache {
+        std::unordered_map<u64, BatchCacheEntry> entries;
+        std::size_t batch_size = 0;
+        u64 clock = 0;
+    };
+    std::unordered_map<const ShaderSetup*, BatchCache> batch_caches;
 };
 
 } // namespace Pica::Shader
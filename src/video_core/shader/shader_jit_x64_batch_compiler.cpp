@@ -0,0 +1,1042 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <nihstro/shader_bytecode.h>
+#include <smmintrin.h>
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/logging/log.h"
+#include "common/x64/cpu_detect.h"
+#include "common/x64/xbyak_abi.h"
+#include "common/x64/xbyak_util.h"
+#include "video_core/shader/shader_jit_x64_batch_compiler.h"
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Xbyak::Label;
+using Xbyak::Reg32;
+using Xbyak::Reg64;
+using Xbyak::Xmm;
+
+namespace Pica::Shader {
+
+typedef void (JitBatchShader::*JitBatchFunction)(Instruction instr);
+
+const JitBatchFunction batch_instr_table[64] = {
+    &JitBatchShader::Compile_ADD,         // add
+    &JitBatchShader::Compile_DP3,         // dp3
+    &JitBatchShader::Compile_DP4,         // dp4
+    &JitBatchShader::Compile_DPH,         // dph
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_Unsupported, // ex2
+    &JitBatchShader::Compile_Unsupported, // lg2
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_MUL,         // mul
+    &JitBatchShader::Compile_SGE,         // sge
+    &JitBatchShader::Compile_SLT,         // slt
+    &JitBatchShader::Compile_FLR,         // flr
+    &JitBatchShader::Compile_MAX,         // max
+    &JitBatchShader::Compile_MIN,         // min
+    &JitBatchShader::Compile_RCP,         // rcp
+    &JitBatchShader::Compile_RSQ,         // rsq
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_MOVA,        // mova
+    &JitBatchShader::Compile_MOV,         // mov
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_DPH,         // dphi
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_SGE,         // sgei
+    &JitBatchShader::Compile_SLT,         // slti
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    nullptr,                              // unknown
+    &JitBatchShader::Compile_NOP,         // nop
+    &JitBatchShader::Compile_END,         // end
+    &JitBatchShader::Compile_BREAKC,      // breakc
+    &JitBatchShader::Compile_CALL,        // call
+    &JitBatchShader::Compile_CALLC,       // callc
+    &JitBatchShader::Compile_CALLU,       // callu
+    &JitBatchShader::Compile_IF,          // ifu
+    &JitBatchShader::Compile_IF,          // ifc
+    &JitBatchShader::Compile_LOOP,        // loop
+    &JitBatchShader::Compile_Unsupported, // emit
+    &JitBatchShader::Compile_Unsupported, // sete
+    &JitBatchShader::Compile_JMP,         // jmpc
+    &JitBatchShader::Compile_JMP,         // jmpu
+    &JitBatchShader::Compile_CMP,         // cmp
+    &JitBatchShader::Compile_CMP,         // cmp
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // madi
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+    &JitBatchShader::Compile_MAD,         // mad
+};
+
+// Register usage mirrors the scalar JIT where possible. The vector registers hold one component of
+// an operand for every unit of the batch, so each source operand takes four of them.
+
+/// Pointer to the uniform memory
+static const Reg64 UNIFORMS = r9;
+/// Stack pointer at the start of the program, used to leave the program from within subroutines
+static const Reg64 SAVED_RSP = r13;
+/// VS loop count register (Multiplied by 16)
+static const Reg32 LOOPCOUNT_REG = r12d;
+/// Current VS loop iteration number
+static const Reg32 LOOPCOUNT = esi;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration (Multiplied by 16)
+static const Reg32 LOOPINC = edi;
+/// Pointer to the BatchRegisters of the batch
+static const Reg64 STATE = r15;
+
+/// Index of the first vector register of each swizzled source operand
+static constexpr int SRC1_INDEX = 0;
+static constexpr int SRC2_INDEX = 4;
+static constexpr int SRC3_INDEX = 8;
+/// Indices of the scratch vector registers
+static constexpr int SCRATCH_INDEX = 12;
+static constexpr int SCRATCH2_INDEX = 13;
+/// Constant vector of 1.0f in every lane
+static constexpr int ONE_INDEX = 14;
+/// Constant vector of -0.f in every lane, used to negate a vector with XOR
+static constexpr int NEGBIT_INDEX = 15;
+
+/// Distance in bytes between two components, and between two registers, of BatchRegisters
+static constexpr std::size_t LANES_SIZE = sizeof(BatchRegisters::Lanes);
+static constexpr std::size_t REGISTER_SIZE = sizeof(BatchRegisters::Register);
+static_assert(REGISTER_SIZE == 8 * 16, "Loop register offsets are scaled by 8");
+
+static std::size_t BatchInputOffset(const SourceRegister& reg) {
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Input:
+        return offsetof(BatchRegisters, input) + reg.GetIndex() * REGISTER_SIZE;
+
+    case RegisterType::Temporary:
+        return offsetof(BatchRegisters, temporary) + reg.GetIndex() * REGISTER_SIZE;
+
+    default:
+        UNREACHABLE();
+        return 0;
+    }
+}
+
+static std::size_t BatchOutputOffset(const DestRegister& reg) {
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Output:
+        return offsetof(BatchRegisters, output) + reg.GetIndex() * REGISTER_SIZE;
+
+    case RegisterType::Temporary:
+        return offsetof(BatchRegisters, temporary) + reg.GetIndex() * REGISTER_SIZE;
+
+    default:
+        UNREACHABLE();
+        return 0;
+    }
+}
+
+static bool IsMAD(Instruction instr) {
+    return instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+           instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI;
+}
+
+static SwizzlePattern GetSwizzle(Instruction instr,
+                                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>& swizzle_data) {
+    const unsigned operand_desc_id =
+        IsMAD(instr) ? instr.mad.operand_desc_id : instr.common.operand_desc_id;
+    return {swizzle_data[operand_desc_id]};
+}
+
+/// Returns a bit mask of the destination components written by an instruction
+static unsigned GetDestComponents(const SwizzlePattern& swiz) {
+    unsigned components = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        if (swiz.DestComponentEnabled(i)) {
+            components |= 1 << i;
+        }
+    }
+    return components;
+}
+
+JitBatchShader::JitBatchShader(std::size_t batch_size)
+    : Xbyak::CodeGenerator(MAX_BATCH_SHADER_SIZE), batch_size(batch_size) {
+    ASSERT(batch_size == 4 || batch_size == 8);
+
+    // Constants, sized for the widest batch
+    align(32);
+    L(one_label);
+    for (std::size_t i = 0; i < MAX_BATCH_SIZE; ++i) {
+        dd(0x3f800000);
+    }
+    L(negbit_label);
+    for (std::size_t i = 0; i < MAX_BATCH_SIZE; ++i) {
+        dd(0x80000000);
+    }
+    // Byte offset of each lane within a component, used to gather per-unit registers
+    L(lane_offsets_label);
+    for (std::size_t i = 0; i < MAX_BATCH_SIZE; ++i) {
+        dd(static_cast<u32>(i * sizeof(float24)));
+    }
+
+    // Common exit of the program, which can be reached from within subroutines
+    align(16);
+    L(abandon_label);
+    xor_(eax, eax);
+    L(exit_label);
+    mov(rsp, SAVED_RSP);
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    vzeroupper();
+    ret();
+}
+
+bool JitBatchShader::IsSupported() {
+    // AVX2 is needed for the integer operations on 256-bit registers and for gathers
+    return Common::GetCPUCaps().avx2;
+}
+
+Xmm JitBatchShader::VReg(int index) const {
+    if (batch_size == 8) {
+        return Xbyak::Ymm(index);
+    }
+    return Xmm(index);
+}
+
+void JitBatchShader::Compile_GatherComponent(const Xbyak::RegExp& base, unsigned address_register,
+                                             bool per_unit_registers, Xmm dest) {
+    const Xmm index = VReg(SCRATCH_INDEX);
+    const Xmm mask = VReg(SCRATCH2_INDEX);
+
+    vmovdqa(index, ptr[STATE + offsetof(BatchRegisters, address_registers) +
+                       address_register * LANES_SIZE]);
+    if (per_unit_registers) {
+        // Each unit reads the register from its own lane
+        vpslld(index, index, 7);
+        vpaddd(index, index, ptr[rip + lane_offsets_label]);
+    } else {
+        vpslld(index, index, 4);
+    }
+    vpcmpeqd(mask, mask, mask);
+    vgatherdps(dest, ptr[base + index], mask);
+}
+
+void JitBatchShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num,
+                                        SourceRegister src_reg, unsigned components,
+                                        const Operand& dest) {
+    const bool is_uniform = src_reg.GetRegisterType() == RegisterType::FloatUniform;
+    const std::size_t src_offset = is_uniform
+                                       ? Uniforms::GetFloatUniformOffset(src_reg.GetIndex())
+                                       : BatchInputOffset(src_reg);
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    unsigned operand_desc_id;
+    unsigned address_register_index;
+    unsigned offset_src;
+
+    if (IsMAD(instr)) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    if (src_num != offset_src) {
+        address_register_index = 0;
+    }
+
+    const SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+    const u8 sel = swiz.GetRawSelector(src_num);
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+
+    // Component of the operand that each component of the source register was loaded into
+    std::array<int, 4> loaded_into{-1, -1, -1, -1};
+
+    for (unsigned i = 0; i < 4; ++i) {
+        if (!(components & (1 << i))) {
+            continue;
+        }
+
+        // The selector of the X component is stored in the two most significant bits
+        const unsigned component = (sel >> (6 - 2 * i)) & 3;
+        if (loaded_into[component] != -1) {
+            vmovaps(dest[i], dest[loaded_into[component]]);
+            continue;
+        }
+        loaded_into[component] = i;
+
+        if (is_uniform) {
+            // Uniforms are the same for all units and are broadcast to every lane
+            const std::size_t offset = src_offset + component * sizeof(float24);
+            switch (address_register_index) {
+            case 0:
+                vbroadcastss(dest[i], dword[UNIFORMS + offset]);
+                break;
+            case 1:
+            case 2:
+                Compile_GatherComponent(UNIFORMS + offset, address_register_index - 1, false,
+                                        dest[i]);
+                break;
+            case 3:
+                vbroadcastss(dest[i], dword[UNIFORMS + LOOPCOUNT_REG.cvt64() + offset]);
+                break;
+            default:
+                UNREACHABLE();
+                break;
+            }
+        } else {
+            const std::size_t offset = src_offset + component * LANES_SIZE;
+            switch (address_register_index) {
+            case 0:
+                vmovaps(dest[i], ptr[STATE + offset]);
+                break;
+            case 1:
+            case 2:
+                Compile_GatherComponent(STATE + offset, address_register_index - 1, true,
+                                        dest[i]);
+                break;
+            case 3:
+                vmovaps(dest[i], ptr[STATE + LOOPCOUNT_REG.cvt64() * 8 + offset]);
+                break;
+            default:
+                UNREACHABLE();
+                break;
+            }
+        }
+
+        if (negate[src_num - 1]) {
+            vxorps(dest[i], dest[i], VReg(NEGBIT_INDEX));
+        }
+    }
+}
+
+void JitBatchShader::Compile_DestEnable(Instruction instr, const Operand& src) {
+    const DestRegister dest = IsMAD(instr) ? instr.mad.dest.Value() : instr.common.dest.Value();
+    const SwizzlePattern swiz = GetSwizzle(instr, *swizzle_data);
+    const std::size_t dest_offset = BatchOutputOffset(dest);
+
+    for (unsigned i = 0; i < 4; ++i) {
+        if (swiz.DestComponentEnabled(i)) {
+            vmovaps(ptr[STATE + dest_offset + i * LANES_SIZE], src[i]);
+        }
+    }
+}
+
+void JitBatchShader::Compile_DestEnableBroadcast(Instruction instr, Xmm src) {
+    Compile_DestEnable(instr, {src, src, src, src});
+}
+
+void JitBatchShader::Compile_SanitizedMul(Xmm lhs, Xmm rhs, Xmm temp) {
+    // See JitShader::Compile_SanitizedMul, this must produce the exact same results
+    vcmpordps(temp, lhs, rhs);
+    vmulps(lhs, lhs, rhs);
+    vcmpunordps(rhs, lhs, lhs);
+    vxorps(temp, temp, rhs);
+    vandps(lhs, lhs, temp);
+}
+
+void JitBatchShader::Compile_EvaluateCondition(Instruction instr) {
+    const Xmm cond0 = VReg(SCRATCH_INDEX);
+    const Xmm cond1 = VReg(SCRATCH2_INDEX);
+    const Xmm all_ones = VReg(SRC1_INDEX);
+
+    const auto load_condition = [&](Xmm dest, unsigned index, bool reference) {
+        vmovaps(dest, ptr[STATE + offsetof(BatchRegisters, conditional_code) + index * LANES_SIZE]);
+        if (!reference) {
+            vpcmpeqd(all_ones, all_ones, all_ones);
+            vxorps(dest, dest, all_ones);
+        }
+    };
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        load_condition(cond0, 0, instr.flow_control.refx.Value());
+        load_condition(cond1, 1, instr.flow_control.refy.Value());
+        vorps(cond0, cond0, cond1);
+        break;
+
+    case Instruction::FlowControlType::And:
+        load_condition(cond0, 0, instr.flow_control.refx.Value());
+        load_condition(cond1, 1, instr.flow_control.refy.Value());
+        vandps(cond0, cond0, cond1);
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        load_condition(cond0, 0, instr.flow_control.refx.Value());
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        load_condition(cond0, 1, instr.flow_control.refy.Value());
+        break;
+    }
+
+    // Branch uniformly if the condition has the same value for all units, otherwise the scalar
+    // JIT has to take over
+    Label uniform;
+    vmovmskps(eax, cond0);
+    test(eax, eax);
+    jz(uniform);
+    cmp(eax, static_cast<u32>((1 << batch_size) - 1));
+    jne(abandon_label, T_NEAR);
+    test(eax, eax);
+    L(uniform);
+}
+
+void JitBatchShader::Compile_UniformCondition(Instruction instr) {
+    std::size_t offset = Uniforms::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    cmp(byte[UNIFORMS + offset], 0);
+}
+
+void JitBatchShader::Compile_ADD(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    for (int i : BitSet32(components)) {
+        vaddps(src1[i], src1[i], src2[i]);
+    }
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_DP3(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b0111, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, 0b0111, src2);
+
+    for (int i = 0; i < 3; ++i) {
+        Compile_SanitizedMul(src1[i], src2[i], scratch);
+    }
+
+    // Same order of additions as the scalar JIT
+    vaddps(src1[0], src1[0], src1[1]);
+    vaddps(src1[0], src1[0], src1[2]);
+
+    Compile_DestEnableBroadcast(instr, src1[0]);
+}
+
+void JitBatchShader::Compile_DP4(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b1111, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, 0b1111, src2);
+
+    for (int i = 0; i < 4; ++i) {
+        Compile_SanitizedMul(src1[i], src2[i], scratch);
+    }
+
+    // Same order of additions as the two HADDPS of the scalar JIT
+    vaddps(src1[0], src1[0], src1[1]);
+    vaddps(src1[2], src1[2], src1[3]);
+    vaddps(src1[0], src1[0], src1[2]);
+
+    Compile_DestEnableBroadcast(instr, src1[0]);
+}
+
+void JitBatchShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, 0b0111, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, 0b1111, src2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b0111, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, 0b1111, src2);
+    }
+
+    // Set 4th component to 1.0
+    vmovaps(src1[3], VReg(ONE_INDEX));
+
+    for (int i = 0; i < 4; ++i) {
+        Compile_SanitizedMul(src1[i], src2[i], scratch);
+    }
+
+    vaddps(src1[0], src1[0], src1[1]);
+    vaddps(src1[2], src1[2], src1[3]);
+    vaddps(src1[0], src1[0], src1[2]);
+
+    Compile_DestEnableBroadcast(instr, src1[0]);
+}
+
+void JitBatchShader::Compile_MUL(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    for (int i : BitSet32(components)) {
+        Compile_SanitizedMul(src1[i], src2[i], scratch);
+    }
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_SGE(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, components, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, components, src2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    }
+
+    for (int i : BitSet32(components)) {
+        vcmpleps(src2[i], src2[i], src1[i]);
+        vandps(src2[i], src2[i], VReg(ONE_INDEX));
+    }
+
+    Compile_DestEnable(instr, src2);
+}
+
+void JitBatchShader::Compile_SLT(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, components, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, components, src2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    }
+
+    for (int i : BitSet32(components)) {
+        vcmpltps(src1[i], src1[i], src2[i]);
+        vandps(src1[i], src1[i], VReg(ONE_INDEX));
+    }
+
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_FLR(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    for (int i : BitSet32(components)) {
+        vroundps(src1[i], src1[i], _MM_FROUND_FLOOR);
+    }
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_MAX(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    for (int i : BitSet32(components)) {
+        vmaxps(src1[i], src1[i], src2[i]);
+    }
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_MIN(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, components, src2);
+    // SSE semantics match PICA200 ones: In case of NaN, SRC2 is returned.
+    for (int i : BitSet32(components)) {
+        vminps(src1[i], src1[i], src2[i]);
+    }
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b0001, src1);
+    // Same approximation as the RCPSS of the scalar JIT
+    vrcpps(src1[0], src1[0]);
+    Compile_DestEnableBroadcast(instr, src1[0]);
+}
+
+void JitBatchShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b0001, src1);
+    // Same approximation as the RSQRTSS of the scalar JIT
+    vrsqrtps(src1[0], src1[0]);
+    Compile_DestEnableBroadcast(instr, src1[0]);
+}
+
+void JitBatchShader::Compile_MOVA(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data)) & 0b0011;
+    if (components == 0) {
+        return; // NoOp
+    }
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+
+    // Convert floats to integers using truncation
+    for (int i : BitSet32(components)) {
+        vcvttps2dq(src1[i], src1[i]);
+        vmovdqa(ptr[STATE + offsetof(BatchRegisters, address_registers) + i * LANES_SIZE],
+                src1[i]);
+    }
+}
+
+void JitBatchShader::Compile_MOV(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, components, src1);
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_NOP(Instruction instr) {}
+
+void JitBatchShader::Compile_END(Instruction instr) {
+    sar(LOOPCOUNT_REG, 4);
+    mov(dword[STATE + offsetof(BatchRegisters, loop_counter)], LOOPCOUNT_REG);
+    mov(eax, 1);
+    jmp(exit_label, T_NEAR);
+}
+
+void JitBatchShader::Compile_BREAKC(Instruction instr) {
+    if (!looping) {
+        // Let the scalar JIT report the invalid program
+        Compile_Unsupported(instr);
+        return;
+    }
+    Compile_EvaluateCondition(instr);
+    ASSERT(loop_break_label);
+    jnz(*loop_break_label, T_NEAR);
+}
+
+void JitBatchShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return
+    push(qword, (instr.flow_control.dest_offset + instr.flow_control.num_instructions));
+
+    // Call the subroutine
+    call(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset that's on the stack
+    add(rsp, 8);
+}
+
+void JitBatchShader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    Label b;
+    jz(b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitBatchShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    jz(b);
+    Compile_CALL(instr);
+    L(b);
+}
+
+void JitBatchShader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    const Op ops[] = {instr.common.compare_op.x, instr.common.compare_op.y};
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, 0b0011, src1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, 0b0011, src2);
+
+    // GT and GE are emulated by swapping the operands of LT and LE, see JitShader::Compile_CMP
+    static const u8 cmp[] = {CMP_EQ, CMP_NEQ, CMP_LT, CMP_LE, CMP_LT, CMP_LE};
+
+    for (int i = 0; i < 2; ++i) {
+        const bool invert_op = (ops[i] == Op::GreaterThan || ops[i] == Op::GreaterEqual);
+        const Xmm lhs = invert_op ? src2[i] : src1[i];
+        const Xmm rhs = invert_op ? src1[i] : src2[i];
+
+        vcmpps(scratch, lhs, rhs, cmp[ops[i]]);
+        vmovaps(ptr[STATE + offsetof(BatchRegisters, conditional_code) + i * LANES_SIZE],
+                scratch);
+    }
+}
+
+void JitBatchShader::Compile_MAD(Instruction instr) {
+    const unsigned components = GetDestComponents(GetSwizzle(instr, *swizzle_data));
+    Compile_SwizzleSrc(instr, 1, instr.mad.src1, components, src1);
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2i, components, src2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3i, components, src3);
+    } else {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2, components, src2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3, components, src3);
+    }
+
+    for (int i : BitSet32(components)) {
+        Compile_SanitizedMul(src1[i], src2[i], scratch);
+        vaddps(src1[i], src1[i], src3[i]);
+    }
+
+    Compile_DestEnable(instr, src1);
+}
+
+void JitBatchShader::Compile_IF(Instruction instr) {
+    if (instr.flow_control.dest_offset < program_counter) {
+        // Backwards if-statements are not supported, let the scalar JIT report them
+        Compile_Unsupported(instr);
+        return;
+    }
+    Label l_else, l_endif;
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    jz(l_else, T_NEAR);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        L(l_else);
+        return;
+    }
+
+    jmp(l_endif, T_NEAR);
+
+    L(l_else);
+    // Compile the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    L(l_endif);
+}
+
+void JitBatchShader::Compile_LOOP(Instruction instr) {
+    if (instr.flow_control.dest_offset < program_counter || looping) {
+        // Backwards and nested loops are not supported, let the scalar JIT report them
+        Compile_Unsupported(instr);
+        return;
+    }
+
+    looping = true;
+
+    // The loop counter is the same for all units, see JitShader::Compile_LOOP
+    std::size_t offset = Uniforms::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    mov(LOOPCOUNT, dword[UNIFORMS + offset]);
+    mov(LOOPCOUNT_REG, LOOPCOUNT);
+    shr(LOOPCOUNT_REG, 4);
+    and_(LOOPCOUNT_REG, 0xFF0); // Y-component is the start
+    mov(LOOPINC, LOOPCOUNT);
+    shr(LOOPINC, 12);
+    and_(LOOPINC, 0xFF0);               // Z-component is the incrementer
+    movzx(LOOPCOUNT, LOOPCOUNT.cvt8()); // X-component is iteration count
+    add(LOOPCOUNT, 1);                  // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    L(l_loop_start);
+
+    loop_break_label = Xbyak::Label();
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    add(LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    sub(LOOPCOUNT, 1);           // Increment loop count by 1
+    jnz(l_loop_start, T_NEAR);   // Loop if not equal
+    L(*loop_break_label);
+    loop_break_label.reset();
+
+    looping = false;
+}
+
+void JitBatchShader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    if (inverted_condition) {
+        jz(b, T_NEAR);
+    } else {
+        jnz(b, T_NEAR);
+    }
+}
+
+void JitBatchShader::Compile_Unsupported(Instruction instr) {
+    jmp(abandon_label, T_NEAR);
+}
+
+void JitBatchShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitBatchShader::Compile_Return() {
+    // Peek return offset on the stack and check if we're at that offset
+    mov(rax, qword[rsp + 8]);
+    cmp(eax, (program_counter));
+
+    // If so, jump back to before CALL
+    Label b;
+    jnz(b);
+    ret();
+    L(b);
+}
+
+void JitBatchShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    L(instruction_labels[program_counter]);
+
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = batch_instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction, which the scalar JIT reports
+        Compile_Unsupported(instr);
+    }
+}
+
+void JitBatchShader::FindReturnOffsets() {
+    return_offsets.clear();
+
+    for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitBatchShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                             const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code_copy = *program_code_;
+    swizzle_data_copy = *swizzle_data_;
+    program_code = &program_code_copy;
+    swizzle_data = &swizzle_data_copy;
+
+    for (int i = 0; i < 4; ++i) {
+        src1[i] = VReg(SRC1_INDEX + i);
+        src2[i] = VReg(SRC2_INDEX + i);
+        src3[i] = VReg(SRC3_INDEX + i);
+    }
+    scratch = VReg(SCRATCH_INDEX);
+
+    // Reset flow control state
+    program = getCurr<CompiledShader*>();
+    program_counter = 0;
+    looping = false;
+    instruction_labels.fill(Xbyak::Label());
+    entry_point_usage.clear();
+
+    FindReturnOffsets();
+
+    // Same stack layout as the scalar JIT, see JitShader::Compile
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    mov(qword[rsp + 8], 0xFFFFFFFFFFFFFFFFULL);
+    mov(SAVED_RSP, rsp);
+
+    mov(UNIFORMS, ABI_PARAM1);
+    mov(STATE, ABI_PARAM2);
+
+    mov(LOOPCOUNT_REG, dword[STATE + offsetof(BatchRegisters, loop_counter)]);
+    shl(LOOPCOUNT_REG, 4);
+
+    vmovaps(VReg(ONE_INDEX), ptr[rip + one_label]);
+    vmovaps(VReg(NEGBIT_INDEX), ptr[rip + negbit_label]);
+
+    // Jump to start of the shader program
+    jmp(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    ready();
+
+    ASSERT_MSG(getSize() <= MAX_BATCH_SHADER_SIZE,
+               "Compiled a shader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled batch shader size={}", getSize());
+}
+
+void JitBatchShader::PrepareEntryPoint(unsigned entry_point) {
+    if (entry_point_usage.count(entry_point)) {
+        return;
+    }
+
+    RegisterUsage usage;
+
+    const auto use_source = [&usage](SourceRegister reg, bool relative) {
+        const u16 mask = relative ? 0xFFFF : static_cast<u16>(1 << reg.GetIndex());
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            usage.inputs |= mask;
+            break;
+        case RegisterType::Temporary:
+            usage.temporaries |= mask;
+            break;
+        default:
+            break;
+        }
+    };
+    const auto use_dest = [&usage](DestRegister reg) {
+        const u16 mask = static_cast<u16>(1 << reg.GetIndex());
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Output:
+            usage.outputs |= mask;
+            break;
+        case RegisterType::Temporary:
+            usage.temporaries |= mask;
+            break;
+        default:
+            break;
+        }
+    };
+
+    // Conservatively visit every instruction that may be reached from the entry point. Unused
+    // fields of an instruction may mark registers that are not actually used, which only costs
+    // some copying.
+    std::vector<bool> visited(MAX_PROGRAM_CODE_LENGTH);
+    std::vector<unsigned> pending{entry_point};
+    while (!pending.empty()) {
+        unsigned offset = pending.back();
+        pending.pop_back();
+
+        for (; offset < MAX_PROGRAM_CODE_LENGTH && !visited[offset]; ++offset) {
+            visited[offset] = true;
+
+            const Instruction instr = {program_code_copy[offset]};
+            const OpCode::Id opcode = instr.opcode.Value();
+            if (opcode == OpCode::Id::END) {
+                break;
+            }
+
+            switch (instr.opcode.Value().GetInfo().type) {
+            case OpCode::Type::Arithmetic: {
+                const bool is_inverted =
+                    (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+                const bool relative = instr.common.address_register_index != 0;
+                use_source(instr.common.GetSrc1(is_inverted), relative && !is_inverted);
+                use_source(instr.common.GetSrc2(is_inverted), relative && is_inverted);
+                use_dest(instr.common.dest.Value());
+                break;
+            }
+
+            case OpCode::Type::MultiplyAdd: {
+                const bool is_inverted = opcode == OpCode::Id::MADI;
+                const bool relative = instr.mad.address_register_index != 0;
+                use_source(instr.mad.GetSrc1(is_inverted), false);
+                use_source(instr.mad.GetSrc2(is_inverted), relative && !is_inverted);
+                use_source(instr.mad.GetSrc3(is_inverted), relative && is_inverted);
+                use_dest(instr.mad.dest.Value());
+                break;
+            }
+
+            default:
+                switch (opcode) {
+                case OpCode::Id::JMPC:
+                case OpCode::Id::JMPU:
+                case OpCode::Id::CALL:
+                case OpCode::Id::CALLC:
+                case OpCode::Id::CALLU:
+                case OpCode::Id::IFU:
+                case OpCode::Id::IFC:
+                case OpCode::Id::LOOP:
+                    pending.push_back(instr.flow_control.dest_offset);
+                    break;
+                default:
+                    break;
+                }
+                break;
+            }
+        }
+    }
+
+    entry_point_usage.emplace(entry_point, usage);
+}
+
+bool JitBatchShader::Run(const ShaderSetup& setup, UnitState* states,
+                         unsigned entry_point) const {
+    const RegisterUsage& usage = entry_point_usage.at(entry_point);
+
+    // The loop counter is shared by the batch
+    for (std::size_t unit = 1; unit < batch_size; ++unit) {
+        if (states[unit].address_registers[2] != states[0].address_registers[2]) {
+            return false;
+        }
+    }
+
+    BatchRegisters registers;
+
+    const auto load = [&](BatchRegisters::Register* batch_regs,
+                          Common::Vec4<float24>(UnitState::Registers::*unit_regs)[16], u16 mask) {
+        for (int reg : BitSet32(mask)) {
+            for (std::size_t unit = 0; unit < batch_size; ++unit) {
+                const Common::Vec4<float24>& value = (states[unit].registers.*unit_regs)[reg];
+                for (int comp = 0; comp < 4; ++comp) {
+                    batch_regs[reg][comp][unit] = value[comp];
+                }
+            }
+        }
+    };
+    const auto store = [&](const BatchRegisters::Register* batch_regs,
+                           Common::Vec4<float24>(UnitState::Registers::*unit_regs)[16], u16 mask) {
+        for (int reg : BitSet32(mask)) {
+            for (std::size_t unit = 0; unit < batch_size; ++unit) {
+                Common::Vec4<float24>& value = (states[unit].registers.*unit_regs)[reg];
+                for (int comp = 0; comp < 4; ++comp) {
+                    value[comp] = batch_regs[reg][comp][unit];
+                }
+            }
+        }
+    };
+
+    // Registers that are not written by the program are copied back unchanged, so it's fine to
+    // load every register the program may touch
+    load(registers.input, &UnitState::Registers::input, usage.inputs);
+    load(registers.temporary, &UnitState::Registers::temporary, usage.temporaries);
+    load(registers.output, &UnitState::Registers::output, usage.outputs);
+    for (std::size_t unit = 0; unit < batch_size; ++unit) {
+        for (int i = 0; i < 2; ++i) {
+            registers.conditional_code[i][unit] = states[unit].conditional_code[i] ? 0xFFFFFFFF : 0;
+            registers.address_registers[i][unit] = states[unit].address_registers[i];
+        }
+    }
+    registers.loop_counter = states[0].address_registers[2];
+
+    if (!program(&setup.uniforms, &registers, instruction_labels[entry_point].getAddress())) {
+        return false;
+    }
+
+    store(registers.temporary, &UnitState::Registers::temporary, usage.temporaries);
+    store(registers.output, &UnitState::Registers::output, usage.outputs);
+    for (std::size_t unit = 0; unit < batch_size; ++unit) {
+        for (int i = 0; i < 2; ++i) {
+            states[unit].conditional_code[i] = registers.conditional_code[i][unit] != 0;
+            states[unit].address_registers[i] = registers.address_registers[i][unit];
+        }
+        states[unit].address_registers[2] = registers.loop_counter;
+    }
+    return true;
+}
+
+} // namespace Pica::Shader
@@ -0,0 +1,195 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include <xbyak.h>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::SwizzlePattern;
+
+namespace Pica::Shader {
+
+/// Memory allocated for each compiled batch shader, which handles every component separately
+constexpr std::size_t MAX_BATCH_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 512;
+
+/**
+ * Register file of a batch of shader units in structure-of-arrays form. Every component of every
+ * register holds one value per unit, so that an instruction can process a component of all units
+ * with a single SIMD operation.
+ */
+struct BatchRegisters {
+    /// One component of a register for every unit of the batch
+    using Lanes = float24[MAX_BATCH_SIZE];
+    using Register = Lanes[4];
+
+    alignas(32) Register input[16];
+    alignas(32) Register temporary[16];
+    alignas(32) Register output[16];
+
+    /// Result of the last CMP instruction for each unit, as masks of all ones or all zeros
+    alignas(32) u32 conditional_code[2][MAX_BATCH_SIZE];
+
+    /// Address registers of each unit, set by the MOVA instruction
+    alignas(32) s32 address_registers[2][MAX_BATCH_SIZE];
+
+    /// The loop counter only depends on uniforms, so it is the same for all units
+    s32 loop_counter;
+};
+
+/**
+ * Shader JIT that runs a Pica shader program on several shader units at once, with each unit in a
+ * lane of the AVX registers. Flow control that depends on uniforms is executed like in the scalar
+ * JIT. Flow control that depends on the conditional codes is only supported as long as all units
+ * take the same path; if they diverge, the batch is abandoned and must be run by the scalar JIT.
+ */
+class JitBatchShader : public Xbyak::CodeGenerator {
+public:
+    /// Creates a compiler for batches of `batch_size` units, which must be 4 or 8
+    explicit JitBatchShader(std::size_t batch_size);
+
+    /// Returns whether the host CPU supports the instructions used by the batch JIT
+    static bool IsSupported();
+
+    std::size_t BatchSize() const {
+        return batch_size;
+    }
+
+    void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+
+    /**
+     * Finds the registers used by the program when it starts at `entry_point`. This must be called
+     * for an entry point before running the shader from it.
+     */
+    void PrepareEntryPoint(unsigned entry_point);
+
+    /**
+     * Runs the shader on BatchSize() units.
+     * @return false if the units took different paths through the program or executed an
+     *         instruction that the batch JIT doesn't support. The units are left untouched in that
+     *         case and have to be run one by one.
+     */
+    bool Run(const ShaderSetup& setup, UnitState* states, unsigned entry_point) const;
+
+    void Compile_ADD(Instruction instr);
+    void Compile_DP3(Instruction instr);
+    void Compile_DP4(Instruction instr);
+    void Compile_DPH(Instruction instr);
+    void Compile_MUL(Instruction instr);
+    void Compile_SGE(Instruction instr);
+    void Compile_SLT(Instruction instr);
+    void Compile_FLR(Instruction instr);
+    void Compile_MAX(Instruction instr);
+    void Compile_MIN(Instruction instr);
+    void Compile_RCP(Instruction instr);
+    void Compile_RSQ(Instruction instr);
+    void Compile_MOVA(Instruction instr);
+    void Compile_MOV(Instruction instr);
+    void Compile_NOP(Instruction instr);
+    void Compile_END(Instruction instr);
+    void Compile_BREAKC(Instruction instr);
+    void Compile_CALL(Instruction instr);
+    void Compile_CALLC(Instruction instr);
+    void Compile_CALLU(Instruction instr);
+    void Compile_IF(Instruction instr);
+    void Compile_LOOP(Instruction instr);
+    void Compile_JMP(Instruction instr);
+    void Compile_CMP(Instruction instr);
+    void Compile_MAD(Instruction instr);
+    void Compile_Unsupported(Instruction instr);
+
+private:
+    /// Registers of the batch that are accessed by a program
+    struct RegisterUsage {
+        u16 inputs = 0;
+        u16 temporaries = 0;
+        u16 outputs = 0;
+    };
+
+    /// Vector registers holding one component of an operand each
+    using Operand = std::array<Xbyak::Xmm, 4>;
+
+    /// Returns the vector register with the given index, sized for the batch
+    Xbyak::Xmm VReg(int index) const;
+
+    void Compile_Block(unsigned end);
+    void Compile_NextInstr();
+
+    /**
+     * Loads the components of a swizzled source register that are set in `components`.
+     * @param dest Registers that receive each component of the swizzled source register
+     */
+    void Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                            unsigned components, const Operand& dest);
+
+    /// Loads a component of a register indexed by a per-unit address register
+    void Compile_GatherComponent(const Xbyak::RegExp& base, unsigned address_register,
+                                 bool per_unit_registers, Xbyak::Xmm dest);
+
+    /// Stores the enabled components of `src` to the destination register of `instr`
+    void Compile_DestEnable(Instruction instr, const Operand& src);
+
+    /// Stores `src` to every enabled component of the destination register of `instr`
+    void Compile_DestEnableBroadcast(Instruction instr, Xbyak::Xmm src);
+
+    /// Same as JitShader::Compile_SanitizedMul, multiplying into `lhs`. Clobbers `rhs` and `temp`.
+    void Compile_SanitizedMul(Xbyak::Xmm lhs, Xbyak::Xmm rhs, Xbyak::Xmm temp);
+
+    /**
+     * Evaluates a conditional code condition for all units. If it evaluates the same for all of
+     * them, the zero flag is cleared when it's true and set when it's false. Otherwise the batch
+     * is abandoned.
+     */
+    void Compile_EvaluateCondition(Instruction instr);
+    void Compile_UniformCondition(Instruction instr);
+
+    void Compile_Return();
+    void FindReturnOffsets();
+
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code = nullptr;
+    const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data = nullptr;
+
+    /// Copies of the program and swizzle data, used to find the registers used from entry points
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> program_code_copy;
+    std::array<u32, MAX_SWIZZLE_DATA_LENGTH> swizzle_data_copy;
+
+    std::unordered_map<unsigned, RegisterUsage> entry_point_usage;
+
+    std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
+    std::optional<Xbyak::Label> loop_break_label;
+    std::vector<unsigned> return_offsets;
+    unsigned program_counter = 0;
+    bool looping = false;
+
+    /// Restores the stack and returns from the program, with the result in eax
+    Xbyak::Label exit_label;
+    /// Returns from the program, reporting that the batch has to be run by the scalar JIT
+    Xbyak::Label abandon_label;
+    Xbyak::Label one_label;
+    Xbyak::Label negbit_label;
+    Xbyak::Label lane_offsets_label;
+
+    std::size_t batch_size;
+
+    /// Registers loaded with the swizzled source operands, sized for the batch
+    Operand src1;
+    Operand src2;
+    Operand src3;
+    Xbyak::Xmm scratch;
+
+    using CompiledShader = bool(const void* uniforms, void* registers, const u8* start_addr);
+    CompiledShader* program = nullptr;
+};
+
+} // namespace Pica::Shader
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <nihstro/shader_bytecode.h>
 #include <smmintrin.h>
 #include <xmmintrin.h>
@@ -164,11 +165,25 @@ static void LogCritical(const char* msg) {
 
 void JitShader::Compile_Assert(bool condition, const char* msg) {
     if (!condition) {
-        mov(ABI_PARAM1, reinterpret_cast<std::size_t>(msg));
-        CallFarFunction(*this, LogCritical);
+        Compile_LogCritical(msg);
     }
 }
 
+void JitShader::Compile_LogCritical(const char* msg) {
+    // The message is copied into the code so that no pointer to host data is embedded
+    Label message, after_message;
+    jmp(after_message, T_NEAR);
+    L(message);
+    for (const char* c = msg; *c != '\0'; ++c) {
+        db(*c);
+    }
+    db(0);
+    L(after_message);
+
+    lea(ABI_PARAM1, ptr[rip + message]);
+    Compile_CallHostFunction(JitHostFunction::LogCritical);
+}
+
 /**
  * Loads and swizzles a source register into the specified XMM register.
  * @param instr VS instruction, used for determining how to load the source register
@@ -781,6 +796,25 @@ static void Emit(GSEmitter* emitter, Common::Vec4<float24> (*output)[16]) {
     emitter->Emit(*output);
 }
 
+static std::size_t GetHostFunctionAddress(JitHostFunction function) {
+    switch (function) {
+    case JitHostFunction::LogCritical:
+        return reinterpret_cast<std::size_t>(LogCritical);
+    case JitHostFunction::Emit:
+        return reinterpret_cast<std::size_t>(Emit);
+    }
+    UNREACHABLE();
+}
+
+void JitShader::Compile_CallHostFunction(JitHostFunction function) {
+    // Always encode `mov rax, imm64`, which Xbyak would shorten for addresses below 4GiB
+    db(0x48);
+    db(0xB8);
+    relocations.push_back({static_cast<u32>(getSize()), function});
+    dq(GetHostFunctionAddress(function));
+    call(rax);
+}
+
 void JitShader::Compile_EMIT(Instruction instr) {
     Label have_emitter, end;
     mov(rax, qword[STATE + offsetof(UnitState, emitter_ptr)]);
@@ -788,8 +822,7 @@ void JitShader::Compile_EMIT(Instruction instr) {
     jnz(have_emitter);
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    mov(ABI_PARAM1, reinterpret_cast<std::size_t>("Execute EMIT on VS"));
-    CallFarFunction(*this, LogCritical);
+    Compile_LogCritical("Execute EMIT on VS");
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     jmp(end);
 
@@ -798,7 +831,7 @@ void JitShader::Compile_EMIT(Instruction instr) {
     mov(ABI_PARAM1, rax);
     mov(ABI_PARAM2, STATE);
     add(ABI_PARAM2, static_cast<Xbyak::uint32>(offsetof(UnitState, registers.output)));
-    CallFarFunction(*this, Emit);
+    Compile_CallHostFunction(JitHostFunction::Emit);
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     L(end);
 }
@@ -810,8 +843,7 @@ void JitShader::Compile_SETE(Instruction instr) {
     jnz(have_emitter);
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    mov(ABI_PARAM1, reinterpret_cast<std::size_t>("Execute SETEMIT on VS"));
-    CallFarFunction(*this, LogCritical);
+    Compile_LogCritical("Execute SETEMIT on VS");
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     jmp(end);
 
@@ -919,15 +951,9 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     mov(COND0, byte[STATE + offsetof(UnitState, conditional_code[0])]);
     mov(COND1, byte[STATE + offsetof(UnitState, conditional_code[1])]);
 
-    // Used to set a register to one
-    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
-    mov(rax, reinterpret_cast<std::size_t>(&one));
-    movaps(ONE, xword[rax]);
-
-    // Used to negate registers
-    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
-    mov(rax, reinterpret_cast<std::size_t>(&neg));
-    movaps(NEGBIT, xword[rax]);
+    // Used to set a register to one, and to negate registers
+    movaps(ONE, xword[rip + one_vector]);
+    movaps(NEGBIT, xword[rip + negbit_vector]);
 
     // Jump to start of the shader program
     jmp(ABI_PARAM3);
@@ -943,19 +969,67 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
 
     ready();
 
+    for (std::size_t i = 0; i < instruction_labels.size(); ++i) {
+        instruction_offsets[i] = static_cast<u32>(instruction_labels[i].getAddress() - getCode());
+    }
+
     ASSERT_MSG(getSize() <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
     LOG_DEBUG(HW_GPU, "Compiled shader size={}", getSize());
 }
 
+JitShaderImage JitShader::GetImage() const {
+    JitShaderImage image;
+    image.code.assign(getCode(), getCode() + getSize());
+    image.program_offset = static_cast<u32>(reinterpret_cast<const u8*>(program) - getCode());
+    image.instruction_offsets = instruction_offsets;
+    image.relocations = relocations;
+    return image;
+}
+
+void JitShader::LoadImage(const JitShaderImage& image) {
+    ASSERT_MSG(image.code.size() <= MAX_SHADER_SIZE,
+               "Loaded a shader that exceeds the allocated size!");
+
+    std::vector<u8> code = image.code;
+    for (const JitRelocation& relocation : image.relocations) {
+        ASSERT(relocation.offset + sizeof(u64) <= code.size());
+        const u64 address = GetHostFunctionAddress(relocation.function);
+        std::memcpy(code.data() + relocation.offset, &address, sizeof(address));
+    }
+
+    reset();
+    for (const u8 byte : code) {
+        db(byte);
+    }
+    ready();
+
+    program = reinterpret_cast<CompiledShader*>(getCode() + image.program_offset);
+    instruction_offsets = image.instruction_offsets;
+    relocations = image.relocations;
+}
+
 JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {
     CompilePrelude();
 }
 
 void JitShader::CompilePrelude() {
+    CompilePrelude_Constants();
     log2_subroutine = CompilePrelude_Log2();
     exp2_subroutine = CompilePrelude_Exp2();
 }
 
+void JitShader::CompilePrelude_Constants() {
+    align(16);
+    L(one_vector);
+    for (int i = 0; i < 4; ++i) {
+        dd(0x3f800000);
+    }
+    L(negbit_vector);
+    for (int i = 0; i < 4; ++i) {
+        dd(0x80000000);
+    }
+}
+
 Xbyak::Label JitShader::CompilePrelude_Log2() {
     Xbyak::Label subroutine;
 
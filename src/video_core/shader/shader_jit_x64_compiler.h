@@ -24,6 +24,32 @@ namespace Pica::Shader {
 /// Memory allocated for each compiled shader
 constexpr std::size_t MAX_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 64;
 
+/// Host functions called by compiled shaders
+enum class JitHostFunction : u32 {
+    LogCritical,
+    Emit,
+};
+
+/// Location in the code of a compiled shader that holds the 64-bit address of a host function
+struct JitRelocation {
+    u32 offset;
+    JitHostFunction function;
+};
+
+/**
+ * Compiled shader in a form that can be stored and loaded in another process. All references
+ * within the code are relative to the instruction pointer, so only the addresses of host functions
+ * have to be patched when loading.
+ */
+struct JitShaderImage {
+    std::vector<u8> code;
+    /// Offset of the program entry in the code
+    u32 program_offset;
+    /// Offset of each Pica instruction in the code
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> instruction_offsets;
+    std::vector<JitRelocation> relocations;
+};
+
 /**
  * This class implements the shader JIT compiler. It recompiles a Pica shader program into x86_64
  * code that can be executed on the host machine directly.
@@ -33,12 +59,18 @@ public:
     JitShader();
 
     void Run(const ShaderSetup& setup, UnitState& state, unsigned offset) const {
-        program(&setup.uniforms, &state, instruction_labels[offset].getAddress());
+        program(&setup.uniforms, &state, getCode() + instruction_offsets[offset]);
     }
 
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
                  const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
 
+    /// Returns the compiled shader in a form that can be loaded with LoadImage
+    JitShaderImage GetImage() const;
+
+    /// Replaces the code of the shader by a previously compiled one
+    void LoadImage(const JitShaderImage& image);
+
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
     void Compile_DP4(Instruction instr);
@@ -100,6 +132,15 @@ private:
      */
     void Compile_Assert(bool condition, const char* msg);
 
+    /// Emits a call to LogCritical with a copy of `msg` stored in the code
+    void Compile_LogCritical(const char* msg);
+
+    /**
+     * Emits a call to a host function through an absolute address, which is recorded as a
+     * relocation so that the code can be loaded in another process.
+     */
+    void Compile_CallHostFunction(JitHostFunction function);
+
     /**
      * Analyzes the entire shader program for `CALL` instructions before emitting any code,
      * identifying the locations where a return needs to be inserted.
@@ -110,6 +151,7 @@ private:
      * Emits data and code for utility functions.
      */
     void CompilePrelude();
+    void CompilePrelude_Constants();
     Xbyak::Label CompilePrelude_Log2();
     Xbyak::Label CompilePrelude_Exp2();
 
@@ -119,6 +161,12 @@ private:
     /// Mapping of Pica VS instructions to pointers in the emitted code
     std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
 
+    /// Offsets of the Pica VS instructions in the emitted code, used to start the program
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> instruction_offsets{};
+
+    /// Addresses of host functions that need to be patched when loading the code elsewhere
+    std::vector<JitRelocation> relocations;
+
     /// Label pointing to the end of the current LOOP block. Used by the BREAKC instruction to break
     /// out of the loop.
     std::optional<Xbyak::Label> loop_break_label;
@@ -132,6 +180,8 @@ private:
     using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
     CompiledShader* program = nullptr;
 
+    Xbyak::Label one_vector;
+    Xbyak::Label negbit_vector;
     Xbyak::Label log2_subroutine;
     Xbyak::Label exp2_subroutine;
 };
@@ -0,0 +1,250 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <type_traits>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/x64/cpu_detect.h"
+#include "core/loader/loader.h"
+#include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_jit_x64_disk_cache.h"
+
+namespace Pica::Shader {
+
+constexpr u32 CACHE_MAGIC = Loader::MakeMagic('C', 'J', 'I', 'T');
+constexpr u32 CACHE_VERSION = 1;
+
+struct CacheHeader {
+    u32 magic;
+    u32 version;
+    /// Hash of the source revision of the build that compiled the shaders
+    u64 build_hash;
+    /// Host CPU features that the compiled code depends on
+    u32 cpu_features;
+    u32 num_entries;
+};
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+
+/// Each entry is followed by its relocations, its instruction offsets and its code
+struct EntryHeader {
+    u64 code_hash;
+    u64 swizzle_hash;
+    u32 program_offset;
+    u32 code_size;
+    u32 num_relocations;
+    u32 padding;
+};
+static_assert(std::is_trivially_copyable_v<EntryHeader>);
+static_assert(std::is_trivially_copyable_v<JitRelocation>);
+
+constexpr std::size_t INSTRUCTION_OFFSETS_SIZE = sizeof(u32) * MAX_PROGRAM_CODE_LENGTH;
+
+static u64 GetBuildHash() {
+    return Common::ComputeHash64(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+}
+
+static u32 GetCPUFeatures() {
+    const auto& caps = Common::GetCPUCaps();
+    return static_cast<u32>(caps.sse4_1) | static_cast<u32>(caps.avx) << 1 |
+           static_cast<u32>(caps.avx2) << 2;
+}
+
+static std::size_t GetEntrySize(const EntryHeader& entry) {
+    return sizeof(EntryHeader) + entry.num_relocations * sizeof(JitRelocation) +
+           INSTRUCTION_OFFSETS_SIZE + entry.code_size;
+}
+
+JitDiskCache::JitDiskCache(u64 program_id) : program_id(program_id), file(GetPath()) {
+    if (!file.IsOpen()) {
+        LOG_INFO(HW_GPU, "No shader JIT cache found for game with title id={:016X}", program_id);
+        return;
+    }
+    LoadEntries();
+}
+
+JitDiskCache::~JitDiskCache() = default;
+
+void JitDiskCache::LoadEntries() {
+    CacheHeader header;
+    if (file.GetSize() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "Shader JIT cache is truncated - ignoring");
+        file.Close();
+        return;
+    }
+    std::memcpy(&header, file.GetData(), sizeof(header));
+
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+        header.build_hash != GetBuildHash() || header.cpu_features != GetCPUFeatures()) {
+        LOG_INFO(HW_GPU, "Shader JIT cache is from another version of the emulator or another "
+                         "CPU - ignoring");
+        file.Close();
+        return;
+    }
+
+    std::size_t offset = sizeof(header);
+    u32 num_parsed = 0;
+    for (; num_parsed < header.num_entries; ++num_parsed) {
+        EntryHeader entry;
+        if (file.GetSize() - offset < sizeof(entry)) {
+            break;
+        }
+        std::memcpy(&entry, file.GetData() + offset, sizeof(entry));
+
+        const std::size_t size = GetEntrySize(entry);
+        if (entry.code_size > MAX_SHADER_SIZE || entry.program_offset >= entry.code_size ||
+            file.GetSize() - offset < size) {
+            break;
+        }
+
+        // A later entry with the same index replaces the earlier one
+        entries[entry.code_hash ^ entry.swizzle_hash] = EntryLocation{offset, size};
+        offset += size;
+    }
+
+    if (num_parsed != header.num_entries) {
+        LOG_ERROR(HW_GPU, "Shader JIT cache is corrupted - ignoring");
+        entries.clear();
+        file.Close();
+        return;
+    }
+
+    LOG_INFO(HW_GPU, "Found a shader JIT cache with {} entries", entries.size());
+}
+
+std::optional<JitShaderImage> JitDiskCache::Find(u64 code_hash, u64 swizzle_hash) const {
+    const auto iter = entries.find(code_hash ^ swizzle_hash);
+    if (iter == entries.end()) {
+        return std::nullopt;
+    }
+
+    const u8* data = file.GetData() + iter->second.offset;
+    EntryHeader entry;
+    std::memcpy(&entry, data, sizeof(entry));
+    if (entry.code_hash != code_hash || entry.swizzle_hash != swizzle_hash) {
+        return std::nullopt;
+    }
+    data += sizeof(entry);
+
+    JitShaderImage image;
+    image.program_offset = entry.program_offset;
+
+    image.relocations.resize(entry.num_relocations);
+    std::memcpy(image.relocations.data(), data, entry.num_relocations * sizeof(JitRelocation));
+    data += entry.num_relocations * sizeof(JitRelocation);
+    for (const JitRelocation& relocation : image.relocations) {
+        if (relocation.offset + sizeof(u64) > entry.code_size ||
+            relocation.function > JitHostFunction::Emit) {
+            LOG_ERROR(HW_GPU, "Invalid relocation in shader JIT cache entry={:016X}",
+                      iter->first);
+            return std::nullopt;
+        }
+    }
+
+    std::memcpy(image.instruction_offsets.data(), data, INSTRUCTION_OFFSETS_SIZE);
+    data += INSTRUCTION_OFFSETS_SIZE;
+    for (const u32 instruction_offset : image.instruction_offsets) {
+        if (instruction_offset >= entry.code_size) {
+            LOG_ERROR(HW_GPU, "Invalid instruction offset in shader JIT cache entry={:016X}",
+                      iter->first);
+            return std::nullopt;
+        }
+    }
+
+    image.code.assign(data, data + entry.code_size);
+    return image;
+}
+
+void JitDiskCache::Add(u64 code_hash, u64 swizzle_hash, const JitShaderImage& image) {
+    EntryHeader entry{};
+    entry.code_hash = code_hash;
+    entry.swizzle_hash = swizzle_hash;
+    entry.program_offset = image.program_offset;
+    entry.code_size = static_cast<u32>(image.code.size());
+    entry.num_relocations = static_cast<u32>(image.relocations.size());
+
+    std::vector<u8>& serialized = new_entries[code_hash ^ swizzle_hash];
+    serialized.resize(GetEntrySize(entry));
+    u8* data = serialized.data();
+
+    std::memcpy(data, &entry, sizeof(entry));
+    data += sizeof(entry);
+    std::memcpy(data, image.relocations.data(), image.relocations.size() * sizeof(JitRelocation));
+    data += image.relocations.size() * sizeof(JitRelocation);
+    std::memcpy(data, image.instruction_offsets.data(), INSTRUCTION_OFFSETS_SIZE);
+    data += INSTRUCTION_OFFSETS_SIZE;
+    std::memcpy(data, image.code.data(), image.code.size());
+}
+
+void JitDiskCache::Save() {
+    if (new_entries.empty() || !EnsureDirectories()) {
+        return;
+    }
+
+    CacheHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.build_hash = GetBuildHash();
+    header.cpu_features = GetCPUFeatures();
+    header.num_entries = 0;
+
+    // The old entries are copied out before the mapping is closed, as a mapped file can't be
+    // overwritten on every platform. Those replaced by new entries are left out.
+    std::vector<u8> contents(sizeof(header));
+    for (const auto& [key, location] : entries) {
+        if (new_entries.count(key) == 0) {
+            const u8* const data = file.GetData() + location.offset;
+            contents.insert(contents.end(), data, data + location.size);
+            ++header.num_entries;
+        }
+    }
+    for (const auto& [key, serialized] : new_entries) {
+        contents.insert(contents.end(), serialized.begin(), serialized.end());
+        ++header.num_entries;
+    }
+    std::memcpy(contents.data(), &header, sizeof(header));
+
+    entries.clear();
+    file.Close();
+    new_entries.clear();
+
+    const std::string path = GetPath();
+    FileUtil::IOFile out(path, "wb");
+    if (!out.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open shader JIT cache in path={}", path);
+        return;
+    }
+    if (out.WriteBytes(contents.data(), contents.size()) != contents.size()) {
+        LOG_ERROR(HW_GPU, "Failed to write shader JIT cache in path={}", path);
+        return;
+    }
+    LOG_INFO(HW_GPU, "Saved {} shaders to the shader JIT cache", header.num_entries);
+}
+
+bool JitDiskCache::EnsureDirectories() const {
+    const auto CreateDir = [](const std::string& dir) {
+        if (!FileUtil::CreateDir(dir)) {
+            LOG_ERROR(HW_GPU, "Failed to create directory={}", dir);
+            return false;
+        }
+        return true;
+    };
+
+    return CreateDir(FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir)) &&
+           CreateDir(GetBaseDir());
+}
+
+std::string JitDiskCache::GetBaseDir() const {
+    return FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) + DIR_SEP "jit";
+}
+
+std::string JitDiskCache::GetPath() const {
+    return FileUtil::SanitizePath(GetBaseDir() + DIR_SEP_CHR + fmt::format("{:016X}", program_id) +
+                                  ".bin");
+}
+
+} // namespace Pica::Shader
@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Pica::Shader {
+
+struct JitShaderImage;
+
+/**
+ * Per-title cache of shaders compiled by the JIT in previous sessions. The cache file is mapped
+ * into memory when opened, and an entry is only copied out of it when its shader is first used.
+ * Files written by another build of the emulator or on a CPU with different features are ignored,
+ * as the code they contain may not be valid anymore.
+ */
+class JitDiskCache {
+public:
+    /// Opens the cache of the title with the given program ID
+    explicit JitDiskCache(u64 program_id);
+    ~JitDiskCache();
+
+    /// Returns the shader compiled for the given program and swizzle data, if it's in the cache
+    std::optional<JitShaderImage> Find(u64 code_hash, u64 swizzle_hash) const;
+
+    /// Adds a shader compiled in this session, replacing any entry with the same hashes. It is
+    /// written to disk by Save.
+    void Add(u64 code_hash, u64 swizzle_hash, const JitShaderImage& image);
+
+    /// Writes the cache file, if shaders were added since it was opened
+    void Save();
+
+    /// Returns the number of shaders stored in the cache file when it was opened
+    std::size_t LoadedCount() const {
+        return entries.size();
+    }
+
+private:
+    /// Location of a valid entry in the mapped file
+    struct EntryLocation {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    /// Checks the cache file and indexes its entries. Discards the whole file if it's invalid.
+    void LoadEntries();
+
+    bool EnsureDirectories() const;
+    std::string GetBaseDir() const;
+    std::string GetPath() const;
+
+    u64 program_id;
+
+    FileUtil::MappedFile file;
+
+    /// Entries of the mapped file, indexed by the hashes of their program and swizzle data
+    std::unordered_map<u64, EntryLocation> entries;
+
+    /// Entries added in this session, serialized in the same format as in the file, with the same
+    /// index. They replace the entries of the file with the same index when saving.
+    std::unordered_map<u64, std::vector<u8>> new_entries;
+};
+
+} // namespace Pica::Shader
@@ -3,6 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif // ARCHITECTURE_x86_64
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
@@ -257,11 +261,77 @@ u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u
     }
 }
 
+#ifdef ARCHITECTURE_x86_64
+/**
+ * SSE2 version of EvaluateBlendEquation, which blends the four channels at once. The products of
+ * the colors and the factors fit in 16 bits, and the results are the same as the scalar code.
+ */
+static Common::Vec4<u8> EvaluateBlendEquationSSE2(const Common::Vec4<u8>& src,
+                                                  const Common::Vec4<u8>& srcfactor,
+                                                  const Common::Vec4<u8>& dest,
+                                                  const Common::Vec4<u8>& destfactor,
+                                                  FramebufferRegs::BlendEquation equation) {
+    static_assert(sizeof(Common::Vec4<u8>) == sizeof(u32));
+    const auto Load = [](const Common::Vec4<u8>& value) {
+        u32 raw;
+        std::memcpy(&raw, &value, sizeof(raw));
+        return _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(raw)), _mm_setzero_si128());
+    };
+
+    const __m128i src_value = Load(src);
+    const __m128i dest_value = Load(dest);
+    __m128i result;
+
+    switch (equation) {
+    case FramebufferRegs::BlendEquation::Min:
+        result = _mm_min_epi16(src_value, dest_value);
+        break;
+
+    case FramebufferRegs::BlendEquation::Max:
+        result = _mm_max_epi16(src_value, dest_value);
+        break;
+
+    default: {
+        const __m128i src_result = _mm_mullo_epi16(src_value, Load(srcfactor));
+        const __m128i dst_result = _mm_mullo_epi16(dest_value, Load(destfactor));
+
+        // Saturating at 0 gives the same result as clamping a negative quotient
+        __m128i sum;
+        if (equation == FramebufferRegs::BlendEquation::Add) {
+            sum = _mm_adds_epu16(src_result, dst_result);
+        } else if (equation == FramebufferRegs::BlendEquation::Subtract) {
+            sum = _mm_subs_epu16(src_result, dst_result);
+        } else {
+            sum = _mm_subs_epu16(dst_result, src_result);
+        }
+
+        // Sums from 255 * 255 up all give 255, so they are saturated to that. Below it, x / 255
+        // is exactly (x * 0x8081) >> 23.
+        const __m128i limit = _mm_set1_epi16(255 * 2);
+        sum = _mm_subs_epu16(_mm_adds_epu16(sum, limit), limit);
+        result = _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16(static_cast<s16>(0x8081))), 7);
+        break;
+    }
+    }
+
+    const u32 packed = static_cast<u32>(_mm_cvtsi128_si32(_mm_packus_epi16(result, result)));
+    Common::Vec4<u8> output;
+    std::memcpy(&output, &packed, sizeof(packed));
+    return output;
+}
+#endif // ARCHITECTURE_x86_64
+
 Common::Vec4<u8> EvaluateBlendEquation(const Common::Vec4<u8>& src,
                                        const Common::Vec4<u8>& srcfactor,
                                        const Common::Vec4<u8>& dest,
                                        const Common::Vec4<u8>& destfactor,
                                        FramebufferRegs::BlendEquation equation) {
+#ifdef ARCHITECTURE_x86_64
+    if (equation <= FramebufferRegs::BlendEquation::Max) {
+        return EvaluateBlendEquationSSE2(src, srcfactor, dest, destfactor, equation);
+    }
+#endif // ARCHITECTURE_x86_64
+
     Common::Vec4<int> result;
 
     auto src_result = (src * srcfactor).Cast<int>();
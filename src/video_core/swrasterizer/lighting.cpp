@@ -9,15 +9,11 @@ namespace Pica {
 
 static float LookupLightingLut(const Pica::State::Lighting& lighting, std::size_t lut_index,
                                u8 index, float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+    ASSERT_MSG(lut_index < lighting.float_luts.size(), "Out of range lut");
+    ASSERT_MSG(index < lighting.float_luts[lut_index].size(), "Out of range index");
 
-    const auto& lut = lighting.luts[lut_index][index];
-
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
-
-    return lut_value + lut_diff * delta;
+    const Common::Vec2<float>& lut = lighting.float_luts[lut_index][index];
+    return lut.x + lut.y * delta;
 }
 
 std::tuple<Common::Vec4<u8>, Common::Vec4<u8>> ComputeFragmentsColors(
@@ -14,29 +14,27 @@ using ProcTexShift = TexturingRegs::ProcTexShift;
 using ProcTexCombiner = TexturingRegs::ProcTexCombiner;
 using ProcTexFilter = TexturingRegs::ProcTexFilter;
 
-static float LookupLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut, float coord) {
+static float LookupLUT(const std::array<Common::Vec2<float>, 128>& lut, float coord) {
     // For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
     // coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
     // value entries and difference entries.
     coord *= 128;
     const int index_int = std::min(static_cast<int>(coord), 127);
     const float frac = coord - index_int;
-    return lut[index_int].ToFloat() + frac * lut[index_int].DiffToFloat();
+    return lut[index_int].x + frac * lut[index_int].y;
 }
 
 // These function are used to generate random noise for procedural texture. Their results are
 // verified against real hardware, but it's not known if the algorithm is the same as hardware.
-static unsigned int NoiseRand1D(unsigned int v) {
-    static constexpr std::array<unsigned int, 16> table{
+static constexpr unsigned int NoiseRand1D(unsigned int v) {
+    constexpr std::array<unsigned int, 16> table{
         {0, 4, 10, 8, 4, 9, 7, 12, 5, 15, 13, 14, 11, 15, 2, 11}};
     return ((v % 9 + 2) * 3 & 0xF) ^ table[(v / 9) & 0xF];
 }
 
-static float NoiseRand2D(unsigned int x, unsigned int y) {
-    static constexpr std::array<unsigned int, 16> table{
+static constexpr float NoiseRand2D(unsigned int u2, unsigned int v2) {
+    constexpr std::array<unsigned int, 16> table{
         {10, 2, 15, 8, 0, 7, 4, 5, 5, 13, 2, 6, 13, 9, 3, 14}};
-    unsigned int u2 = NoiseRand1D(x);
-    unsigned int v2 = NoiseRand1D(y);
     v2 += ((u2 & 3) == 1) ? 4 : 0;
     v2 ^= (u2 & 1) * 6;
     v2 += 10 + u2;
@@ -45,6 +43,26 @@ static float NoiseRand2D(unsigned int x, unsigned int y) {
     return -1.0f + v2 * 2.0f / 15.0f;
 }
 
+// NoiseRand1D only depends on v % 144, as 144 = 16 * 9, and its results are 4-bit. Both
+// functions are evaluated once at compile time and looked up for each fragment.
+static constexpr auto noise_rand_1d_table = [] {
+    std::array<u8, 144> table{};
+    for (unsigned int v = 0; v < table.size(); ++v) {
+        table[v] = static_cast<u8>(NoiseRand1D(v));
+    }
+    return table;
+}();
+
+static constexpr auto noise_rand_2d_table = [] {
+    std::array<std::array<float, 16>, 16> table{};
+    for (unsigned int u2 = 0; u2 < 16; ++u2) {
+        for (unsigned int v2 = 0; v2 < 16; ++v2) {
+            table[u2][v2] = NoiseRand2D(u2, v2);
+        }
+    }
+    return table;
+}();
+
 static float NoiseCoef(float u, float v, const TexturingRegs& regs, const State::ProcTex& state) {
     const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
     const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
@@ -57,12 +75,17 @@ static float NoiseCoef(float u, float v, const TexturingRegs& regs, const State:
     const float x_frac = x - x_int;
     const float y_frac = y - y_int;
 
-    const float g0 = NoiseRand2D(x_int, y_int) * (x_frac + y_frac);
-    const float g1 = NoiseRand2D(x_int + 1, y_int) * (x_frac + y_frac - 1);
-    const float g2 = NoiseRand2D(x_int, y_int + 1) * (x_frac + y_frac - 1);
-    const float g3 = NoiseRand2D(x_int + 1, y_int + 1) * (x_frac + y_frac - 2);
-    const float x_noise = LookupLUT(state.noise_table, x_frac);
-    const float y_noise = LookupLUT(state.noise_table, y_frac);
+    const unsigned int u0 = noise_rand_1d_table[static_cast<unsigned int>(x_int) % 144];
+    const unsigned int u1 = noise_rand_1d_table[static_cast<unsigned int>(x_int + 1) % 144];
+    const unsigned int v0 = noise_rand_1d_table[static_cast<unsigned int>(y_int) % 144];
+    const unsigned int v1 = noise_rand_1d_table[static_cast<unsigned int>(y_int + 1) % 144];
+
+    const float g0 = noise_rand_2d_table[u0][v0] * (x_frac + y_frac);
+    const float g1 = noise_rand_2d_table[u1][v0] * (x_frac + y_frac - 1);
+    const float g2 = noise_rand_2d_table[u0][v1] * (x_frac + y_frac - 1);
+    const float g3 = noise_rand_2d_table[u1][v1] * (x_frac + y_frac - 2);
+    const float x_noise = LookupLUT(state.float_noise_table, x_frac);
+    const float y_noise = LookupLUT(state.float_noise_table, y_frac);
     return Common::BilinearInterp(g0, g1, g2, g3, x_noise, y_noise);
 }
 
@@ -113,7 +136,7 @@ static void ClampCoord(float& coord, ProcTexClamp mode) {
 }
 
 static float CombineAndMap(float u, float v, ProcTexCombiner combiner,
-                           const std::array<State::ProcTex::ValueEntry, 128>& map_table) {
+                           const std::array<Common::Vec2<float>, 128>& map_table) {
     float f;
     switch (combiner) {
     case ProcTexCombiner::U:
@@ -180,7 +203,8 @@ Common::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const Stat
     ClampCoord(v, regs.proctex.v_clamp);
 
     // Combine and map
-    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, state.color_map_table);
+    const float lut_coord =
+        CombineAndMap(u, v, regs.proctex.color_combiner, state.float_color_map_table);
 
     // Look up the color
     // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
@@ -195,8 +219,8 @@ Common::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const Stat
     case ProcTexFilter::LinearMipmapNearest: {
         const int index_int = static_cast<int>(index);
         const float frac = index - index_int;
-        const auto color_value = state.color_table[index_int].ToVector().Cast<float>();
-        const auto color_diff = state.color_diff_table[index_int].ToVector().Cast<float>();
+        const auto& color_value = state.float_color_table[index_int];
+        const auto& color_diff = state.float_color_diff_table[index_int];
         final_color = (color_value + frac * color_diff).Cast<u8>();
         break;
     }
@@ -211,7 +235,7 @@ Common::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const Stat
         // Note: in separate alpha mode, the alpha channel skips the color LUT look up stage. It
         // uses the output of CombineAndMap directly instead.
         const float final_alpha =
-            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.alpha_map_table);
+            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.float_alpha_map_table);
         return Common::MakeVec<u8>(final_color.rgb(), static_cast<u8>(final_alpha * 255));
     } else {
         return final_color;
@@ -5,7 +5,9 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <optional>
 #include <tuple>
+#include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
@@ -13,6 +15,7 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/quaternion.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
@@ -27,6 +30,10 @@
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/swrasterizer/rasterizer_x64.h"
+#endif // ARCHITECTURE_x86_64
+#include "video_core/swrasterizer/texture_cache.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
@@ -119,14 +126,34 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/// A triangle that passed culling, with everything needed to rasterize any part of it
+struct Triangle {
+    Vertex v0;
+    Vertex v1;
+    Vertex v2;
+
+    /// Vertex positions in rasterizer coordinates
+    std::array<Common::Vec3<Fix12P4>, 3> vtxpos;
+
+    /// Biases added to the barycentric coordinates to implement the filling rules
+    int bias0;
+    int bias1;
+    int bias2;
+
+    /// Bounding box of the covered pixel centers, clipped to the scissor box in Include mode
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
+
 /**
- * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * Culls a triangle and computes the data needed to rasterize it. The "reversed" flag allows for
+ * implementing culling via recursion.
  */
-static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+static std::optional<Triangle> SetupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                                             bool reversed = false) {
     const auto& regs = g_state.regs;
-    MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
     static auto FloatToFix = [](float24 flt) {
@@ -138,26 +165,24 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
     };
 
-    Common::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
-                                    ScreenToRasterizerCoordinates(v1.screenpos),
-                                    ScreenToRasterizerCoordinates(v2.screenpos)};
+    std::array<Common::Vec3<Fix12P4>, 3> vtxpos{ScreenToRasterizerCoordinates(v0.screenpos),
+                                                ScreenToRasterizerCoordinates(v1.screenpos),
+                                                ScreenToRasterizerCoordinates(v2.screenpos)};
 
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+            return SetupTriangle(v0, v2, v1, true);
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
-            return;
+            return SetupTriangle(v0, v2, v1, true);
         }
 
         // Cull away triangles which are wound clockwise.
         if (SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0)
-            return;
+            return std::nullopt;
     }
 
     u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
@@ -165,14 +190,14 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
     u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
 
-    // Convert the scissor box coordinates to 12.4 fixed point
-    u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
-    u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
-    // x2,y2 have +1 added to cover the entire sub-pixel area
-    u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
-    u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
-
     if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Include) {
+        // Convert the scissor box coordinates to 12.4 fixed point
+        u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
+        u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
+        // x2,y2 have +1 added to cover the entire sub-pixel area
+        u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
+        u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
+
         // Calculate the new bounds
         min_x = std::max(min_x, scissor_x1);
         min_y = std::max(min_y, scissor_y1);
@@ -210,8 +235,232 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    return Triangle{v0,    v1,    v2,    vtxpos, bias0, bias1,
+                    bias2, min_x, min_y, max_x,  max_y};
+}
+
+/**
+ * Computes the values interpolated at the center of the pixel (x, y), in 12.4 fixed point.
+ * @return false if the pixel isn't drawn, because it isn't covered by the triangle or is excluded
+ *         by the scissor box
+ */
+static bool ComputePixelInputs(const Triangle& triangle, u16 x, u16 y, PixelInputs& inputs) {
+    const auto& regs = g_state.regs;
+    const Vertex& v0 = triangle.v0;
+    const Vertex& v1 = triangle.v1;
+    const Vertex& v2 = triangle.v2;
+    const auto& vtxpos = triangle.vtxpos;
+
+    // Do not process the pixel if it's inside the scissor box and the scissor mode is set to
+    // Exclude
+    if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
+        // Convert the scissor box coordinates to 12.4 fixed point
+        u16 scissor_x1 = (u16)(regs.rasterizer.scissor_test.x1 << 4);
+        u16 scissor_y1 = (u16)(regs.rasterizer.scissor_test.y1 << 4);
+        // x2,y2 have +1 added to cover the entire sub-pixel area
+        u16 scissor_x2 = (u16)((regs.rasterizer.scissor_test.x2 + 1) << 4);
+        u16 scissor_y2 = (u16)((regs.rasterizer.scissor_test.y2 + 1) << 4);
+
+        if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
+            return false;
+    }
+
+    // Calculate the barycentric coordinates w0, w1 and w2
+    int w0 = triangle.bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
+    int w1 = triangle.bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
+    int w2 = triangle.bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+    int wsum = w0 + w1 + w2;
+
+    // If current pixel is not covered by the current primitive
+    if (w0 < 0 || w1 < 0 || w2 < 0)
+        return false;
+
     auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
+    auto& baricentric_coordinates = inputs.baricentric_coordinates;
+    baricentric_coordinates = Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                                              float24::FromFloat32(static_cast<float>(w1)),
+                                              float24::FromFloat32(static_cast<float>(w2)));
+    float24& interpolated_w_inverse = inputs.interpolated_w_inverse;
+    interpolated_w_inverse =
+        float24::FromFloat32(1.0f) / Common::Dot(w_inverse, baricentric_coordinates);
+
+    // interpolated_z = z / w
+    float interpolated_z_over_w =
+        (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+         v2.screenpos[2].ToFloat32() * w2) /
+        wsum;
+
+    // Not fully accurate. About 3 bits in precision are missing.
+    // Z-Buffer (z / w * scale + offset)
+    float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    float depth_offset = float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    float depth = interpolated_z_over_w * depth_scale + depth_offset;
+
+    // Potentially switch to W-Buffer
+    if (regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering) {
+        // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+        depth *= interpolated_w_inverse.ToFloat32() * wsum;
+    }
+
+    // Clamp the result
+    inputs.depth = std::clamp(depth, 0.0f, 1.0f);
+
+    // Perspective correct attribute interpolation:
+    // Attribute values cannot be calculated by simple linear interpolation since
+    // they are not linear in screen space. For example, when interpolating a
+    // texture coordinate across two vertices, something simple like
+    //     u = (u0*w0 + u1*w1)/(w0+w1)
+    // will not work. However, the attribute value divided by the
+    // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+    // in screenspace. Hence, we can linearly interpolate these two independently and
+    // calculate the interpolated attribute by dividing the results.
+    // I.e.
+    //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+    //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+    //     u = u_over_w / one_over_w
+    //
+    // The generalization to three vertices is straightforward in baricentric coordinates.
+    auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
+        auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
+        float24 interpolated_attr_over_w = Common::Dot(attr_over_w, baricentric_coordinates);
+        return interpolated_attr_over_w * interpolated_w_inverse;
+    };
+
+    inputs.primary_color = Common::Vec4<u8>{
+        static_cast<u8>(round(
+            GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() * 255)),
+        static_cast<u8>(round(
+            GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() * 255)),
+        static_cast<u8>(round(
+            GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() * 255)),
+        static_cast<u8>(round(
+            GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() * 255)),
+    };
+
+    auto& uv = inputs.uv;
+    uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+    uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
+    uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
+    uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
+    uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
+    uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+    return true;
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Gathers the values used by ComputeQuadInputs, which must match those of ComputePixelInputs
+static QuadSetup MakeQuadSetup(const Triangle& triangle) {
+    const auto& regs = g_state.regs;
+    const std::array<const Vertex*, 3> vertices{&triangle.v0, &triangle.v1, &triangle.v2};
+
+    QuadSetup setup;
+    setup.bias = {triangle.bias0, triangle.bias1, triangle.bias2};
+    for (std::size_t i = 0; i < 3; ++i) {
+        const Vertex& vertex = *vertices[i];
+        setup.x[i] = triangle.vtxpos[i].x;
+        setup.y[i] = triangle.vtxpos[i].y;
+        setup.w_inverse[i] = vertex.pos.w.ToFloat32();
+        setup.z[i] = vertex.screenpos[2].ToFloat32();
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            setup.color[channel][i] = vertex.color[channel].ToFloat32();
+        }
+        setup.tc[0][i] = vertex.tc0.u().ToFloat32();
+        setup.tc[1][i] = vertex.tc0.v().ToFloat32();
+        setup.tc[2][i] = vertex.tc1.u().ToFloat32();
+        setup.tc[3][i] = vertex.tc1.v().ToFloat32();
+        setup.tc[4][i] = vertex.tc2.u().ToFloat32();
+        setup.tc[5][i] = vertex.tc2.v().ToFloat32();
+    }
+
+    setup.depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    setup.depth_offset = float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    setup.w_buffer =
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering;
+
+    setup.scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
+    setup.scissor_x1 = static_cast<u16>(regs.rasterizer.scissor_test.x1 << 4);
+    setup.scissor_y1 = static_cast<u16>(regs.rasterizer.scissor_test.y1 << 4);
+    setup.scissor_x2 = static_cast<u16>((regs.rasterizer.scissor_test.x2 + 1) << 4);
+    setup.scissor_y2 = static_cast<u16>((regs.rasterizer.scissor_test.y2 + 1) << 4);
+    return setup;
+}
+#endif // ARCHITECTURE_x86_64
+
+static TextureCache texture_cache;
+
+/// Decoded textures of the texture units, or nullptr for disabled units
+static std::array<const DecodedTexture*, 3> bound_textures{};
+
+/// Decoded faces of the cube map of texture unit 0, if it uses one
+static std::array<const DecodedTexture*, 6> bound_cube_faces{};
+
+/// Whether the bound textures match the texture registers and the memory they were decoded from
+static bool textures_bound = false;
+
+/// Looks up the decoded textures sampled by the next triangles, decoding them if needed
+static void BindTextures() {
+    const auto& regs = g_state.regs;
+    const auto textures = regs.texturing.GetTextures();
+
+    texture_cache.Trim();
+    bound_textures = {};
+    bound_cube_faces = {};
+    for (std::size_t i = 0; i < textures.size(); ++i) {
+        const auto& texture = textures[i];
+        if (!texture.enabled) {
+            continue;
+        }
+
+        auto info = Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+        bound_textures[i] = texture_cache.GetTexture(info);
+
+        const auto type = texture.config.type.Value();
+        if (i == 0 && (type == TexturingRegs::TextureConfig::TextureCube ||
+                       type == TexturingRegs::TextureConfig::ShadowCube)) {
+            for (std::size_t face = 0; face < bound_cube_faces.size(); ++face) {
+                info.physical_address = regs.texturing.GetCubePhysicalAddress(
+                    static_cast<TexturingRegs::CubeFace>(face));
+                bound_cube_faces[face] = texture_cache.GetTexture(info);
+            }
+        }
+    }
+}
+
+/// Returns the decoded texture sampled by a texture unit at the given address, if it is bound
+static const DecodedTexture* FindBoundTexture(std::size_t unit, PAddr address) {
+    const DecodedTexture* texture = bound_textures[unit];
+    if (texture != nullptr && texture->info.physical_address == address) {
+        return texture;
+    }
+    if (unit == 0) {
+        for (const DecodedTexture* face : bound_cube_faces) {
+            if (face != nullptr && face->info.physical_address == address) {
+                return face;
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Rasterizes the pixels of a triangle whose centers are inside the given region, in 12.4 fixed
+ * point. Pixels are processed in the same order whatever the region, so splitting the screen into
+ * regions gives the same result as rasterizing the whole triangle at once.
+ */
+static void RasterizeTriangle(const Triangle& triangle, u32 region_min_x, u32 region_min_y,
+                              u32 region_max_x, u32 region_max_y) {
+    const auto& regs = g_state.regs;
+    const Vertex& v0 = triangle.v0;
+    const Vertex& v1 = triangle.v1;
+    const Vertex& v2 = triangle.v2;
+
+    const u16 min_x = static_cast<u16>(std::max<u32>(triangle.min_x, region_min_x));
+    const u16 min_y = static_cast<u16>(std::max<u32>(triangle.min_y, region_min_y));
+    const u16 max_x = static_cast<u16>(std::min<u32>(triangle.max_x, region_max_x));
+    const u16 max_y = static_cast<u16>(std::min<u32>(triangle.max_y, region_max_y));
+
     auto textures = regs.texturing.GetTextures();
     auto tev_stages = regs.texturing.GetTevStages();
 
@@ -220,73 +469,47 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
 
+    // The inputs of the fragment pipeline are computed for QUAD_WIDTH pixels at once with SIMD
+    // when the host supports it. The rest of the pipeline runs one pixel at a time.
+    PixelInputs pixel_inputs;
+    std::array<PixelInputs, QUAD_WIDTH> quad_inputs;
+    u32 quad_mask = 0;
+#ifdef ARCHITECTURE_x86_64
+    static const bool use_quads = IsQuadRasterizationSupported();
+    QuadSetup quad_setup;
+    if (use_quads) {
+        quad_setup = MakeQuadSetup(triangle);
+    }
+#else
+    constexpr bool use_quads = false;
+#endif // ARCHITECTURE_x86_64
+
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
         for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
+            const PixelInputs* inputs = &pixel_inputs;
+            if (use_quads) {
+                const u32 lane = ((x - min_x - 8) >> 4) % QUAD_WIDTH;
+#ifdef ARCHITECTURE_x86_64
+                if (lane == 0) {
+                    quad_mask = ComputeQuadInputs(quad_setup, x, y, max_x, quad_inputs);
+                }
+#endif // ARCHITECTURE_x86_64
+                if (!(quad_mask & (1 << lane)))
                     continue;
-            }
-
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
-
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
+                inputs = &quad_inputs[lane];
+            } else if (!ComputePixelInputs(triangle, x, y, pixel_inputs)) {
                 continue;
-
-            auto baricentric_coordinates =
-                Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                                float24::FromFloat32(static_cast<float>(w1)),
-                                float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Common::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
             }
 
-            // Clamp the result
-            depth = std::clamp(depth, 0.0f, 1.0f);
-
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
+            const auto& baricentric_coordinates = inputs->baricentric_coordinates;
+            const float24 interpolated_w_inverse = inputs->interpolated_w_inverse;
+            const float depth = inputs->depth;
+            const Common::Vec4<u8>& primary_color = inputs->primary_color;
+            const auto& uv = inputs->uv;
+
+            // See ComputePixelInputs for how attributes are interpolated
             auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
                 auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
                 float24 interpolated_attr_over_w =
@@ -294,29 +517,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 return interpolated_attr_over_w * interpolated_w_inverse;
             };
 
-            Common::Vec4<u8> primary_color{
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
-                    255)),
-            };
-
-            Common::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
-
             Common::Vec4<u8> texture_color[4]{};
             for (int i = 0; i < 3; ++i) {
                 const auto& texture = textures[i];
@@ -404,13 +604,17 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     t = texture.config.height - 1 -
                         GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    const u8* texture_data =
-                        VideoCore::g_memory->GetPhysicalPointer(texture_address);
-                    auto info =
-                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
-
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    const DecodedTexture* decoded = FindBoundTexture(i, texture_address);
+                    if (decoded != nullptr) {
+                        texture_color[i] = decoded->Lookup(s, t);
+                    } else {
+                        const u8* texture_data =
+                            VideoCore::g_memory->GetPhysicalPointer(texture_address);
+                        auto info =
+                            Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                        texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    }
                 }
 
                 if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -891,8 +1095,120 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     }
 }
 
+/// Width and height of the screen tiles that are rasterized in parallel, in pixels
+constexpr u32 TILE_SIZE = 32;
+
+/// Region covering the whole screen, in 12.4 fixed point
+constexpr u32 FULL_REGION_END = 0x10000;
+
+/// Pixel coordinates are below 4096, so a fixed grid of tiles covers every possible triangle
+constexpr u32 TILES_PER_ROW = (FULL_REGION_END >> 4) / TILE_SIZE;
+
+static Common::ThreadPool& GetRasterizerPool() {
+    static Common::ThreadPool pool{Common::ThreadPool::DefaultWorkerCount(), "Rasterizer"};
+    return pool;
+}
+
+/// Triangles queued since the last flush, in submission order
+static std::vector<Triangle> queued_triangles;
+
+/// Indices of the queued triangles that touch each tile, in submission order
+static std::vector<std::vector<u32>> tile_triangles(TILES_PER_ROW * TILES_PER_ROW);
+
+/// Tiles touched by at least one queued triangle
+static std::vector<u32> active_tiles;
+
+/// Adds a triangle to the lists of the tiles that its bounding box overlaps
+static void BinTriangle(const Triangle& triangle) {
+    // The last pixel center inside the bounding box is 8 subpixels before its end
+    const u32 first_tile_x = (triangle.min_x >> 4) / TILE_SIZE;
+    const u32 first_tile_y = (triangle.min_y >> 4) / TILE_SIZE;
+    const u32 last_tile_x = ((triangle.max_x >> 4) - 1) / TILE_SIZE;
+    const u32 last_tile_y = ((triangle.max_y >> 4) - 1) / TILE_SIZE;
+
+    const u32 index = static_cast<u32>(queued_triangles.size());
+    queued_triangles.push_back(triangle);
+
+    for (u32 tile_y = first_tile_y; tile_y <= last_tile_y; ++tile_y) {
+        for (u32 tile_x = first_tile_x; tile_x <= last_tile_x; ++tile_x) {
+            const u32 tile = tile_y * TILES_PER_ROW + tile_x;
+            if (tile_triangles[tile].empty()) {
+                active_tiles.push_back(tile);
+            }
+            tile_triangles[tile].push_back(index);
+        }
+    }
+}
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+    const std::optional<Triangle> triangle = SetupTriangle(v0, v1, v2);
+    if (!triangle || triangle->min_x >= triangle->max_x || triangle->min_y >= triangle->max_y) {
+        return;
+    }
+
+    // The textures are only looked up again once the texture registers or their memory change
+    if (!textures_bound) {
+        BindTextures();
+        textures_bound = true;
+    }
+
+    if (VideoCore::g_parallel_rasterization_enabled) {
+        BinTriangle(*triangle);
+        return;
+    }
+
+    // Keep the submission order if the setting was changed while triangles were queued
+    FlushTriangles();
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+    RasterizeTriangle(*triangle, 0, 0, FULL_REGION_END, FULL_REGION_END);
+}
+
+void FlushTriangles() {
+    if (queued_triangles.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    // Tiles don't share any pixel, and each tile draws its triangles in submission order, so every
+    // pixel goes through the same operations in the same order as with a single thread
+    GetRasterizerPool().ParallelFor(active_tiles.size(), [](std::size_t task) {
+        const u32 tile = active_tiles[task];
+        const u32 region_min_x = (tile % TILES_PER_ROW) * TILE_SIZE << 4;
+        const u32 region_min_y = (tile / TILES_PER_ROW) * TILE_SIZE << 4;
+        const u32 region_max_x = region_min_x + (TILE_SIZE << 4);
+        const u32 region_max_y = region_min_y + (TILE_SIZE << 4);
+        for (const u32 index : tile_triangles[tile]) {
+            RasterizeTriangle(queued_triangles[index], region_min_x, region_min_y, region_max_x,
+                              region_max_y);
+        }
+    });
+
+    for (const u32 tile : active_tiles) {
+        tile_triangles[tile].clear();
+    }
+    active_tiles.clear();
+    queued_triangles.clear();
+}
+
+void InvalidateTextures(PAddr addr, u32 size) {
+    // The queued triangles sample the textures as they were when they were queued
+    FlushTriangles();
+    texture_cache.InvalidateRegion(addr, size);
+    textures_bound = false;
+}
+
+void UnbindTextures() {
+    // The queued triangles sample the textures bound when they were queued
+    FlushTriangles();
+    textures_bound = false;
+}
+
+void ClearTextures() {
+    FlushTriangles();
+    texture_cache.Clear();
+    textures_bound = false;
 }
 
 } // namespace Pica::Rasterizer
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
@@ -39,6 +40,34 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
+/// Number of horizontally adjacent pixels whose inputs are computed together
+constexpr u32 QUAD_WIDTH = 4;
+
+/// Values interpolated from the vertices of a triangle at the center of a pixel
+struct PixelInputs {
+    Common::Vec3<float24> baricentric_coordinates;
+    float24 interpolated_w_inverse;
+    float depth;
+    Common::Vec4<u8> primary_color;
+    std::array<Common::Vec2<float24>, 3> uv;
+};
+
+/**
+ * Rasterizes a triangle. When parallel rasterization is enabled, the triangle is only queued, and
+ * is drawn by the next call to FlushTriangles.
+ */
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/// Draws the queued triangles, splitting the screen into tiles that are drawn on worker threads
+void FlushTriangles();
+
+/// Notifies the rasterizer that a region of memory was written, which may contain textures
+void InvalidateTextures(PAddr addr, u32 size);
+
+/// Notifies the rasterizer that the texture unit registers were written
+void UnbindTextures();
+
+/// Removes all decoded textures, and stops watching the memory they were decoded from
+void ClearTextures();
+
 } // namespace Pica::Rasterizer
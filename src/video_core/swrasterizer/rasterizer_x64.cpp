@@ -0,0 +1,162 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <smmintrin.h>
+#include "common/x64/cpu_detect.h"
+#include "video_core/swrasterizer/rasterizer_x64.h"
+
+// The rest of the emulator is built for the baseline x86-64 instruction set, so only the functions
+// of this file may use SSE4.1. They are only called when the host CPU supports it.
+#if defined(__GNUC__) || defined(__clang__)
+#define SSE41_FUNCTION __attribute__((target("sse4.1")))
+#else
+#define SSE41_FUNCTION
+#endif
+
+namespace Pica::Rasterizer {
+
+static_assert(QUAD_WIDTH == 4, "ComputeQuadInputs processes one pixel per SSE lane");
+
+/// Multiplies like float24::operator*, which returns 0 instead of NaN for 0 * inf
+SSE41_FUNCTION static __m128 MulFloat24(__m128 a, __m128 b) {
+    const __m128 result = _mm_mul_ps(a, b);
+    const __m128 result_nan = _mm_cmpunord_ps(result, result);
+    const __m128 input_nan = _mm_cmpunord_ps(a, b);
+    return _mm_andnot_ps(_mm_andnot_ps(input_nan, result_nan), result);
+}
+
+/// Same as Common::Dot on float24 vectors, with the same order of operations
+SSE41_FUNCTION static __m128 DotFloat24(const std::array<float, 3>& attr, const __m128 bary[3]) {
+    const __m128 sum = _mm_add_ps(MulFloat24(_mm_set1_ps(attr[0]), bary[0]),
+                                  MulFloat24(_mm_set1_ps(attr[1]), bary[1]));
+    return _mm_add_ps(sum, MulFloat24(_mm_set1_ps(attr[2]), bary[2]));
+}
+
+/// Same as GetInterpolatedAttribute in RasterizeTriangle
+SSE41_FUNCTION static __m128 Interpolate(const std::array<float, 3>& attr, const __m128 bary[3],
+                                         __m128 w_inverse) {
+    return MulFloat24(DotFloat24(attr, bary), w_inverse);
+}
+
+/// Same as std::clamp, which returns NaN when the value is NaN
+SSE41_FUNCTION static __m128 Clamp(__m128 value, __m128 low, __m128 high) {
+    const __m128 clamped_high = _mm_blendv_ps(value, high, _mm_cmplt_ps(high, value));
+    return _mm_blendv_ps(clamped_high, low, _mm_cmplt_ps(value, low));
+}
+
+/// Same as std::round, which rounds halfway cases away from zero
+SSE41_FUNCTION static __m128 RoundHalfAwayFromZero(__m128 value) {
+    const __m128 truncated = _mm_round_ps(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m128 sign = _mm_and_ps(value, _mm_set1_ps(-0.0f));
+    const __m128 abs_fraction = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(value, truncated));
+    const __m128 round_up = _mm_cmpge_ps(abs_fraction, _mm_set1_ps(0.5f));
+    const __m128 increment = _mm_and_ps(round_up, _mm_or_ps(_mm_set1_ps(1.0f), sign));
+    return _mm_add_ps(truncated, increment);
+}
+
+/**
+ * Computes SignedArea(vtx_a, vtx_b, {x, y}) for every lane, wrapping on overflow like the scalar
+ * code does.
+ */
+SSE41_FUNCTION static __m128i SignedArea(const QuadSetup& setup, int a, int b, __m128i x, u32 y) {
+    const u32 row_term = static_cast<u32>(setup.x[b] - setup.x[a]) * (y - setup.y[a]);
+    const __m128i column_term = _mm_mullo_epi32(_mm_set1_epi32(setup.y[b] - setup.y[a]),
+                                                _mm_sub_epi32(x, _mm_set1_epi32(setup.x[a])));
+    return _mm_sub_epi32(_mm_set1_epi32(static_cast<s32>(row_term)), column_term);
+}
+
+bool IsQuadRasterizationSupported() {
+    return Common::GetCPUCaps().sse4_1;
+}
+
+SSE41_FUNCTION u32 ComputeQuadInputs(const QuadSetup& setup, u32 x, u32 y, u32 end_x,
+                                     std::array<PixelInputs, QUAD_WIDTH>& inputs) {
+    const __m128i lane_x = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 16, 32, 48));
+
+    // Calculate the barycentric coordinates w0, w1 and w2
+    const __m128i w0 =
+        _mm_add_epi32(_mm_set1_epi32(setup.bias[0]), SignedArea(setup, 1, 2, lane_x, y));
+    const __m128i w1 =
+        _mm_add_epi32(_mm_set1_epi32(setup.bias[1]), SignedArea(setup, 2, 0, lane_x, y));
+    const __m128i w2 =
+        _mm_add_epi32(_mm_set1_epi32(setup.bias[2]), SignedArea(setup, 0, 1, lane_x, y));
+    const __m128i wsum = _mm_add_epi32(_mm_add_epi32(w0, w1), w2);
+
+    // A pixel is covered when none of its barycentric coordinates is negative
+    const __m128i outside = _mm_or_si128(_mm_or_si128(w0, w1), w2);
+    u32 mask = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+    mask &= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(lane_x, _mm_set1_epi32(end_x))));
+
+    if (setup.scissor_exclude && static_cast<s32>(y) >= setup.scissor_y1 &&
+        static_cast<s32>(y) < setup.scissor_y2) {
+        const __m128i excluded =
+            _mm_andnot_si128(_mm_cmplt_epi32(lane_x, _mm_set1_epi32(setup.scissor_x1)),
+                             _mm_cmplt_epi32(lane_x, _mm_set1_epi32(setup.scissor_x2)));
+        mask &= ~_mm_movemask_ps(_mm_castsi128_ps(excluded));
+    }
+
+    if (mask == 0) {
+        return 0;
+    }
+
+    const __m128 bary[3] = {_mm_cvtepi32_ps(w0), _mm_cvtepi32_ps(w1), _mm_cvtepi32_ps(w2)};
+    const __m128 wsum_float = _mm_cvtepi32_ps(wsum);
+    const __m128 w_inverse = _mm_div_ps(_mm_set1_ps(1.0f), DotFloat24(setup.w_inverse, bary));
+
+    // Depth uses plain float operations, unlike the float24 attributes
+    const __m128 z_over_w =
+        _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(setup.z[0]), bary[0]),
+                                         _mm_mul_ps(_mm_set1_ps(setup.z[1]), bary[1])),
+                              _mm_mul_ps(_mm_set1_ps(setup.z[2]), bary[2])),
+                   wsum_float);
+    __m128 depth = _mm_add_ps(_mm_mul_ps(z_over_w, _mm_set1_ps(setup.depth_scale)),
+                              _mm_set1_ps(setup.depth_offset));
+    if (setup.w_buffer) {
+        depth = _mm_mul_ps(depth, _mm_mul_ps(w_inverse, wsum_float));
+    }
+    depth = Clamp(depth, _mm_setzero_ps(), _mm_set1_ps(1.0f));
+
+    alignas(16) std::array<std::array<float, QUAD_WIDTH>, 3> bary_out;
+    alignas(16) std::array<float, QUAD_WIDTH> w_inverse_out;
+    alignas(16) std::array<float, QUAD_WIDTH> depth_out;
+    alignas(16) std::array<std::array<s32, QUAD_WIDTH>, 4> color_out;
+    alignas(16) std::array<std::array<float, QUAD_WIDTH>, 6> tc_out;
+    for (std::size_t i = 0; i < 3; ++i) {
+        _mm_store_ps(bary_out[i].data(), bary[i]);
+    }
+    _mm_store_ps(w_inverse_out.data(), w_inverse);
+    _mm_store_ps(depth_out.data(), depth);
+    for (std::size_t i = 0; i < 4; ++i) {
+        const __m128 color = RoundHalfAwayFromZero(
+            _mm_mul_ps(Interpolate(setup.color[i], bary, w_inverse), _mm_set1_ps(255.0f)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(color_out[i].data()),
+                        _mm_cvttps_epi32(color));
+    }
+    for (std::size_t i = 0; i < 6; ++i) {
+        _mm_store_ps(tc_out[i].data(), Interpolate(setup.tc[i], bary, w_inverse));
+    }
+
+    for (u32 lane = 0; lane < QUAD_WIDTH; ++lane) {
+        if (!(mask & (1 << lane))) {
+            continue;
+        }
+        PixelInputs& pixel = inputs[lane];
+        pixel.baricentric_coordinates = {float24::FromFloat32(bary_out[0][lane]),
+                                         float24::FromFloat32(bary_out[1][lane]),
+                                         float24::FromFloat32(bary_out[2][lane])};
+        pixel.interpolated_w_inverse = float24::FromFloat32(w_inverse_out[lane]);
+        pixel.depth = depth_out[lane];
+        pixel.primary_color = {static_cast<u8>(color_out[0][lane]),
+                               static_cast<u8>(color_out[1][lane]),
+                               static_cast<u8>(color_out[2][lane]),
+                               static_cast<u8>(color_out[3][lane])};
+        for (std::size_t i = 0; i < 3; ++i) {
+            pixel.uv[i] = {float24::FromFloat32(tc_out[i * 2][lane]),
+                           float24::FromFloat32(tc_out[i * 2 + 1][lane])};
+        }
+    }
+    return mask;
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,53 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * Per-triangle values used to compute the inputs of the fragment pipeline with SSE4.1. Attributes
+ * are stored per vertex, and positions are in 12.4 fixed point.
+ */
+struct QuadSetup {
+    std::array<s32, 3> x;
+    std::array<s32, 3> y;
+    std::array<s32, 3> bias;
+
+    std::array<float, 3> w_inverse;
+    std::array<float, 3> z;
+    /// Primary color channels
+    std::array<std::array<float, 3>, 4> color;
+    /// Components u and v of the three texture coordinates
+    std::array<std::array<float, 3>, 6> tc;
+
+    float depth_scale;
+    float depth_offset;
+    bool w_buffer;
+
+    /// Scissor box whose pixels are not drawn, if the scissor mode is Exclude
+    bool scissor_exclude;
+    s32 scissor_x1;
+    s32 scissor_y1;
+    s32 scissor_x2;
+    s32 scissor_y2;
+};
+
+/// Returns whether the host CPU supports ComputeQuadInputs
+bool IsQuadRasterizationSupported();
+
+/**
+ * Computes the inputs of the fragment pipeline for QUAD_WIDTH horizontally adjacent pixels,
+ * starting at (x, y). Pixels at or after `end_x` are ignored. The results are bit-exact with the
+ * scalar code in RasterizeTriangle.
+ * @return Mask of the pixels covered by the triangle, with bit i set for pixel (x + 16 * i, y)
+ */
+u32 ComputeQuadInputs(const QuadSetup& setup, u32 x, u32 y, u32 end_x,
+                      std::array<PixelInputs, QUAD_WIDTH>& inputs);
+
+} // namespace Pica::Rasterizer
@@ -2,7 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "video_core/pica_state.h"
+#include "video_core/regs.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
 
 namespace VideoCore {
@@ -13,4 +16,46 @@ void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
     Pica::Clipper::ProcessTriangle(v0, v1, v2);
 }
 
+SWRasterizer::~SWRasterizer() {
+    Pica::Rasterizer::ClearTextures();
+}
+
+void SWRasterizer::DrawTriangles() {
+    Pica::Rasterizer::FlushTriangles();
+
+    // The framebuffer may be sampled as a texture by the next draws
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    if (framebuffer.allow_color_write != 0) {
+        Pica::Rasterizer::InvalidateTextures(
+            framebuffer.GetColorBufferPhysicalAddress(),
+            num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(framebuffer.color_format));
+    }
+    if (framebuffer.allow_depth_stencil_write != 0) {
+        Pica::Rasterizer::InvalidateTextures(
+            framebuffer.GetDepthBufferPhysicalAddress(),
+            num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format));
+    }
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // The textures are looked up once for all the triangles drawn until their registers change
+    if (id >= PICA_REG_INDEX(texturing.main_config) &&
+        id <= PICA_REG_INDEX(texturing.texture2_format)) {
+        Pica::Rasterizer::UnbindTextures();
+    }
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::InvalidateTextures(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::InvalidateTextures(addr, size);
+}
+
+void SWRasterizer::ClearAll(bool flush) {
+    Pica::Rasterizer::ClearTextures();
+}
+
 } // namespace VideoCore
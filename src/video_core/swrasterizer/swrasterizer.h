@@ -14,15 +14,19 @@ struct OutputVertex;
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    ~SWRasterizer() override;
+
+private:
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override {}
     void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
 };
 
 } // namespace VideoCore
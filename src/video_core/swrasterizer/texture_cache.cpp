@@ -0,0 +1,146 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <optional>
+#include "common/assert.h"
+#include "common/hash.h"
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+/// The cache is emptied when the decoded textures use more memory than this
+constexpr std::size_t MAX_DECODED_SIZE = 128 * 1024 * 1024;
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decode", MP_RGB(100, 100, 255));
+
+struct TextureKey {
+    PAddr address;
+    u32 format;
+    u32 width;
+    u32 height;
+};
+static_assert(sizeof(TextureKey) == 4 * sizeof(u32), "TextureKey must not have padding");
+
+static bool IsSameTexture(const Texture::TextureInfo& a, const Texture::TextureInfo& b) {
+    return a.physical_address == b.physical_address && a.format == b.format &&
+           a.width == b.width && a.height == b.height;
+}
+
+u32 TextureCache::GetEncodedSize(const Texture::TextureInfo& info) {
+    // LookupTexture reads whole tiles, up to the one containing the last texel
+    const u32 tile_size = static_cast<u32>(Texture::CalculateTileSize(info.format));
+    return (info.height - 1) / 8 * static_cast<u32>(info.stride) +
+           ((info.width - 1) / 8 + 1) * tile_size;
+}
+
+const DecodedTexture* TextureCache::GetTexture(const Texture::TextureInfo& info) {
+    if (info.width == 0 || info.height == 0) {
+        return nullptr;
+    }
+    const u32 size = GetEncodedSize(info);
+    const PAddr end = info.physical_address + size;
+    if (end < info.physical_address ||
+        !VideoCore::g_memory->IsValidPhysicalAddress(info.physical_address) ||
+        !VideoCore::g_memory->IsValidPhysicalAddress(end - 1)) {
+        return nullptr;
+    }
+
+    const TextureKey key{info.physical_address, static_cast<u32>(info.format), info.width,
+                         info.height};
+    Entry& entry = entries[Common::ComputeStructHash64(key)];
+    if (!entry.dirty && IsSameTexture(entry.texture.info, info)) {
+        return &entry.texture;
+    }
+
+    // The texture was modified, or the slot held another texture
+    const u8* source = VideoCore::g_memory->GetPhysicalPointer(info.physical_address);
+    const u64 hash = Common::ComputeHash64(source, size);
+    const bool is_same_texture = IsSameTexture(entry.texture.info, info) && entry.size == size;
+    if (!entry.dirty) {
+        UpdateBlocksCachedCount(entry.texture.info.physical_address, entry.size, -1);
+    }
+
+    if (!is_same_texture || hash != entry.hash) {
+        MICROPROFILE_SCOPE(GPU_TextureDecode);
+        decoded_size -= entry.texture.texels.size() * sizeof(Common::Vec4<u8>);
+        entry.texture.info = info;
+        entry.texture.texels.resize(info.width * info.height);
+        Texture::DecodeTexture(info, source, entry.texture.texels.data());
+        decoded_size += entry.texture.texels.size() * sizeof(Common::Vec4<u8>);
+        entry.size = size;
+        entry.hash = hash;
+    }
+
+    entry.dirty = false;
+    UpdateBlocksCachedCount(info.physical_address, size, 1);
+    return &entry.texture;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    for (auto& [key, entry] : entries) {
+        const PAddr texture_addr = entry.texture.info.physical_address;
+        if (entry.dirty || addr >= texture_addr + entry.size || addr + size <= texture_addr) {
+            continue;
+        }
+        // The pages are only watched while the texture is clean, so that the emulated CPU can
+        // write the rest of the texture without invalidating it again
+        entry.dirty = true;
+        UpdateBlocksCachedCount(texture_addr, entry.size, -1);
+    }
+}
+
+void TextureCache::Trim() {
+    if (decoded_size > MAX_DECODED_SIZE) {
+        Clear();
+    }
+}
+
+void TextureCache::Clear() {
+    for (const auto& [key, entry] : entries) {
+        if (!entry.dirty) {
+            UpdateBlocksCachedCount(entry.texture.info.physical_address, entry.size, -1);
+        }
+    }
+    entries.clear();
+    decoded_size = 0;
+}
+
+void TextureCache::UpdateBlocksCachedCount(PAddr addr, u32 size, int delta) {
+    const u32 block_start = addr >> Memory::RASTERIZER_CACHE_BLOCK_BITS;
+    const u32 block_end = ((addr + size - 1) >> Memory::RASTERIZER_CACHE_BLOCK_BITS) + 1;
+
+    // Consecutive blocks which become cached or uncached are marked together
+    std::optional<u32> run_start;
+    const auto MarkRun = [&](u32 run_end) {
+        if (run_start) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(
+                *run_start << Memory::RASTERIZER_CACHE_BLOCK_BITS,
+                (run_end - *run_start) << Memory::RASTERIZER_CACHE_BLOCK_BITS, delta > 0);
+            run_start.reset();
+        }
+    };
+
+    for (u32 block = block_start; block < block_end; ++block) {
+        const auto iter = cached_blocks.try_emplace(block, 0).first;
+        const int count = iter->second += delta;
+        ASSERT(count >= 0);
+        if (count == 0) {
+            cached_blocks.erase(iter);
+        }
+
+        if (delta > 0 ? count == delta : count == 0) {
+            if (!run_start) {
+                run_start = block;
+            }
+        } else {
+            MarkRun(block);
+        }
+    }
+    MarkRun(block_end);
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,74 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace Pica::Rasterizer {
+
+/// A texture decoded to RGBA8, stored row by row in the coordinates used by LookupTexture
+struct DecodedTexture {
+    Texture::TextureInfo info;
+    std::vector<Common::Vec4<u8>> texels;
+
+    Common::Vec4<u8> Lookup(unsigned int s, unsigned int t) const {
+        return texels[t * info.width + s];
+    }
+};
+
+/**
+ * Cache of the textures sampled by the software rasterizer, so that each texture is decoded once
+ * instead of once per sampled texel. Textures are identified by their address, format and size,
+ * and are decoded again when their contents change.
+ *
+ * The pages of clean textures are marked as cached, so that writes by the emulated CPU invalidate
+ * them through the rasterizer hooks, like for the OpenGL rasterizer cache. The cache is only used
+ * by the thread processing command lists, which also receives the hooks.
+ */
+class TextureCache {
+public:
+    /**
+     * Returns the decoded contents of a texture, decoding it if it isn't cached or if it was
+     * modified. The result stays valid until the next call to Trim or Clear.
+     * @return The decoded texture, or nullptr if it isn't entirely in emulated memory
+     */
+    const DecodedTexture* GetTexture(const Texture::TextureInfo& info);
+
+    /// Marks the textures overlapping a region as possibly modified
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Removes all textures from the cache if they use more memory than the budget
+    void Trim();
+
+    /// Removes all textures from the cache
+    void Clear();
+
+private:
+    struct Entry {
+        DecodedTexture texture;
+        /// Size in bytes of the encoded texture
+        u32 size = 0;
+        /// Hash of the encoded texture when it was decoded
+        u64 hash = 0;
+        /// Whether the texture may have been written since it was decoded
+        bool dirty = true;
+    };
+
+    static u32 GetEncodedSize(const Texture::TextureInfo& info);
+
+    /// Increases or decreases the number of textures in the blocks touching the region
+    void UpdateBlocksCachedCount(PAddr addr, u32 size, int delta);
+
+    std::unordered_map<u64, Entry> entries;
+    std::size_t decoded_size = 0;
+    /// Number of textures in each block of Memory::RASTERIZER_CACHE_BLOCK_SIZE bytes, if any
+    std::unordered_map<u32, int> cached_blocks;
+};
+
+} // namespace Pica::Rasterizer
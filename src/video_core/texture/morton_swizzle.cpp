@@ -0,0 +1,235 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif // ARCHITECTURE_x86_64
+#include "video_core/texture/morton_swizzle.h"
+#include "video_core/utils.h"
+
+namespace Pica::Texture {
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+constexpr u32 LinearBytesPerPixel() {
+    static_assert(conversion != PixelConversion::StencilFirst || bytes_per_pixel == 4);
+    static_assert(conversion != PixelConversion::PadTo4Bytes || bytes_per_pixel == 3);
+    return conversion == PixelConversion::PadTo4Bytes ? 4 : bytes_per_pixel;
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void ConvertToLinear(const u8* tile_pixel, u8* linear_pixel) {
+    if constexpr (conversion == PixelConversion::ReverseBytes) {
+        for (u32 i = 0; i < bytes_per_pixel; ++i) {
+            linear_pixel[i] = tile_pixel[bytes_per_pixel - 1 - i];
+        }
+    } else if constexpr (conversion == PixelConversion::StencilFirst) {
+        linear_pixel[0] = tile_pixel[3];
+        std::memcpy(linear_pixel + 1, tile_pixel, 3);
+    } else if constexpr (conversion == PixelConversion::PadTo4Bytes) {
+        std::memcpy(linear_pixel + 1, tile_pixel, 3);
+    } else {
+        std::memcpy(linear_pixel, tile_pixel, bytes_per_pixel);
+    }
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void ConvertToTile(const u8* linear_pixel, u8* tile_pixel) {
+    if constexpr (conversion == PixelConversion::ReverseBytes) {
+        for (u32 i = 0; i < bytes_per_pixel; ++i) {
+            tile_pixel[i] = linear_pixel[bytes_per_pixel - 1 - i];
+        }
+    } else if constexpr (conversion == PixelConversion::StencilFirst) {
+        std::memcpy(tile_pixel, linear_pixel + 1, 3);
+        tile_pixel[3] = linear_pixel[0];
+    } else if constexpr (conversion == PixelConversion::PadTo4Bytes) {
+        std::memcpy(tile_pixel, linear_pixel + 1, 3);
+    } else {
+        std::memcpy(tile_pixel, linear_pixel, bytes_per_pixel);
+    }
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void MortonToLinearTileGeneric(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    constexpr u32 linear_bytes_per_pixel = LinearBytesPerPixel<bytes_per_pixel, conversion>();
+    for (u32 y = 0; y < 8; ++y) {
+        u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        if constexpr (conversion == PixelConversion::None) {
+            // Pixels (x, y) and (x + 1, y) are next to each other in the tile when x is even
+            for (u32 x = 0; x < 8; x += 2) {
+                std::memcpy(row + x * bytes_per_pixel,
+                            tile + VideoCore::MortonInterleave(x, y) * bytes_per_pixel,
+                            2 * bytes_per_pixel);
+            }
+        } else {
+            for (u32 x = 0; x < 8; ++x) {
+                ConvertToLinear<bytes_per_pixel, conversion>(
+                    tile + VideoCore::MortonInterleave(x, y) * bytes_per_pixel,
+                    row + x * linear_bytes_per_pixel);
+            }
+        }
+    }
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+static void LinearToMortonTileGeneric(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    constexpr u32 linear_bytes_per_pixel = LinearBytesPerPixel<bytes_per_pixel, conversion>();
+    for (u32 y = 0; y < 8; ++y) {
+        const u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        if constexpr (conversion == PixelConversion::None) {
+            for (u32 x = 0; x < 8; x += 2) {
+                std::memcpy(tile + VideoCore::MortonInterleave(x, y) * bytes_per_pixel,
+                            row + x * bytes_per_pixel, 2 * bytes_per_pixel);
+            }
+        } else {
+            for (u32 x = 0; x < 8; ++x) {
+                ConvertToTile<bytes_per_pixel, conversion>(
+                    row + x * linear_bytes_per_pixel,
+                    tile + VideoCore::MortonInterleave(x, y) * bytes_per_pixel);
+            }
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+static __m128i Load(const u8* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+static void Store(u8* dest, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+}
+
+/// Converts four 4-byte pixels, from the tile to the rows or the other way around
+template <PixelConversion conversion, bool to_linear>
+static __m128i Convert4BytePixels(__m128i pixels) {
+    if constexpr (conversion == PixelConversion::ReverseBytes) {
+        const __m128i swapped_words =
+            _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, 0xB1), 0xB1);
+        return _mm_or_si128(_mm_slli_epi16(swapped_words, 8), _mm_srli_epi16(swapped_words, 8));
+    } else if constexpr (conversion == PixelConversion::StencilFirst) {
+        // The stencil byte moves between the top and the bottom of each pixel
+        if constexpr (to_linear) {
+            return _mm_or_si128(_mm_slli_epi32(pixels, 8), _mm_srli_epi32(pixels, 24));
+        } else {
+            return _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+        }
+    } else {
+        return pixels;
+    }
+}
+
+// The kernels below process two rows at a time. With 4-byte pixels, rows y and y + 1 are made of
+// the 2x2 blocks at 0, 16, 64 and 80 bytes from the pixel (0, y). With 2-byte pixels, they are
+// made of the 4x2 blocks at 0 and 32 bytes from it.
+
+template <PixelConversion conversion>
+static void MortonToLinearTile4Bytes(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* const blocks = tile + VideoCore::MortonInterleave(0, y) * 4;
+        const __m128i a = Convert4BytePixels<conversion, true>(Load(blocks));
+        const __m128i b = Convert4BytePixels<conversion, true>(Load(blocks + 16));
+        const __m128i c = Convert4BytePixels<conversion, true>(Load(blocks + 64));
+        const __m128i d = Convert4BytePixels<conversion, true>(Load(blocks + 80));
+
+        u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        Store(row, _mm_unpacklo_epi64(a, b));
+        Store(row + 16, _mm_unpacklo_epi64(c, d));
+        Store(row + pitch, _mm_unpackhi_epi64(a, b));
+        Store(row + pitch + 16, _mm_unpackhi_epi64(c, d));
+    }
+}
+
+template <PixelConversion conversion>
+static void LinearToMortonTile4Bytes(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        const __m128i left = Load(row);
+        const __m128i right = Load(row + 16);
+        const __m128i next_left = Load(row + pitch);
+        const __m128i next_right = Load(row + pitch + 16);
+
+        u8* const blocks = tile + VideoCore::MortonInterleave(0, y) * 4;
+        Store(blocks, Convert4BytePixels<conversion, false>(_mm_unpacklo_epi64(left, next_left)));
+        Store(blocks + 16,
+              Convert4BytePixels<conversion, false>(_mm_unpackhi_epi64(left, next_left)));
+        Store(blocks + 64,
+              Convert4BytePixels<conversion, false>(_mm_unpacklo_epi64(right, next_right)));
+        Store(blocks + 80,
+              Convert4BytePixels<conversion, false>(_mm_unpackhi_epi64(right, next_right)));
+    }
+}
+
+static void MortonToLinearTile2Bytes(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        // Each 4x2 block holds pairs of pixels alternating between the two rows
+        const u8* const blocks = tile + VideoCore::MortonInterleave(0, y) * 2;
+        const __m128i left = _mm_shuffle_epi32(Load(blocks), _MM_SHUFFLE(3, 1, 2, 0));
+        const __m128i right = _mm_shuffle_epi32(Load(blocks + 32), _MM_SHUFFLE(3, 1, 2, 0));
+
+        u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        Store(row, _mm_unpacklo_epi64(left, right));
+        Store(row + pitch, _mm_unpackhi_epi64(left, right));
+    }
+}
+
+static void LinearToMortonTile2Bytes(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* const row = linear + static_cast<std::ptrdiff_t>(y) * pitch;
+        const __m128i current = Load(row);
+        const __m128i next = Load(row + pitch);
+
+        u8* const blocks = tile + VideoCore::MortonInterleave(0, y) * 2;
+        Store(blocks, _mm_unpacklo_epi32(current, next));
+        Store(blocks + 32, _mm_unpackhi_epi32(current, next));
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+void MortonToLinearTile(const u8* tile, u8* linear, std::ptrdiff_t pitch) {
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (bytes_per_pixel == 4) {
+        MortonToLinearTile4Bytes<conversion>(tile, linear, pitch);
+        return;
+    } else if constexpr (bytes_per_pixel == 2 && conversion == PixelConversion::None) {
+        MortonToLinearTile2Bytes(tile, linear, pitch);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+    MortonToLinearTileGeneric<bytes_per_pixel, conversion>(tile, linear, pitch);
+}
+
+template <u32 bytes_per_pixel, PixelConversion conversion>
+void LinearToMortonTile(u8* tile, const u8* linear, std::ptrdiff_t pitch) {
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (bytes_per_pixel == 4) {
+        LinearToMortonTile4Bytes<conversion>(tile, linear, pitch);
+        return;
+    } else if constexpr (bytes_per_pixel == 2 && conversion == PixelConversion::None) {
+        LinearToMortonTile2Bytes(tile, linear, pitch);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+    LinearToMortonTileGeneric<bytes_per_pixel, conversion>(tile, linear, pitch);
+}
+
+#define INSTANTIATE_MORTON_TILE(bytes_per_pixel, conversion)                                       \
+    template void MortonToLinearTile<bytes_per_pixel, conversion>(const u8*, u8*, std::ptrdiff_t); \
+    template void LinearToMortonTile<bytes_per_pixel, conversion>(u8*, const u8*, std::ptrdiff_t);
+
+INSTANTIATE_MORTON_TILE(1, PixelConversion::None)
+INSTANTIATE_MORTON_TILE(2, PixelConversion::None)
+INSTANTIATE_MORTON_TILE(3, PixelConversion::None)
+INSTANTIATE_MORTON_TILE(4, PixelConversion::None)
+INSTANTIATE_MORTON_TILE(3, PixelConversion::ReverseBytes)
+INSTANTIATE_MORTON_TILE(4, PixelConversion::ReverseBytes)
+INSTANTIATE_MORTON_TILE(4, PixelConversion::StencilFirst)
+INSTANTIATE_MORTON_TILE(3, PixelConversion::PadTo4Bytes)
+
+#undef INSTANTIATE_MORTON_TILE
+
+} // namespace Pica::Texture
@@ -0,0 +1,42 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Pica::Texture {
+
+/// Conversion applied to the pixels copied between a tile in Morton order and rows of pixels
+enum class PixelConversion {
+    /// Pixels are copied unchanged
+    None,
+    /// The bytes of each pixel are in reverse order in the rows
+    ReverseBytes,
+    /// 4-byte D24S8 pixels whose stencil byte comes first in the rows instead of last
+    StencilFirst,
+    /// 3-byte pixels stored in the upper 3 bytes of 4-byte pixels in the rows. The lowest byte of
+    /// the row pixels is left untouched.
+    PadTo4Bytes,
+};
+
+/**
+ * Copies the pixels of an 8x8 tile in Morton order to rows of pixels.
+ * @tparam bytes_per_pixel Size of the pixels in the tile, from 1 to 4
+ * @param tile Pointer to the beginning of the tile
+ * @param linear Pointer to the first pixel of row 0 of the tile
+ * @param pitch Distance in bytes between two rows, negative if the rows are stored bottom to top
+ */
+template <u32 bytes_per_pixel, PixelConversion conversion = PixelConversion::None>
+void MortonToLinearTile(const u8* tile, u8* linear, std::ptrdiff_t pitch);
+
+/**
+ * Copies rows of pixels to an 8x8 tile in Morton order. This is the inverse of
+ * MortonToLinearTile.
+ */
+template <u32 bytes_per_pixel, PixelConversion conversion = PixelConversion::None>
+void LinearToMortonTile(u8* tile, const u8* linear, std::ptrdiff_t pitch);
+
+} // namespace Pica::Texture
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/logging/log.h"
@@ -13,6 +15,10 @@
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/texture/texture_decode_x64.h"
+#endif // ARCHITECTURE_x86_64
+
 using TextureFormat = Pica::TexturingRegs::TextureFormat;
 
 namespace Pica::Texture {
@@ -211,6 +217,53 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+/// Decodes an 8x8 tile texel by texel, with the reference LookupTexelInTile
+static void DecodeTile(const u8* source, const TextureInfo& info, Common::Vec4<u8>* dest,
+                       std::size_t dest_stride) {
+    for (unsigned int y = 0; y < 8; ++y) {
+        for (unsigned int x = 0; x < 8; ++x) {
+            dest[y * dest_stride + x] = LookupTexelInTile(source, x, y, info, false);
+        }
+    }
+}
+
+void DecodeTexture(const TextureInfo& info, const u8* source, Common::Vec4<u8>* dest) {
+    const std::size_t tile_size = CalculateTileSize(info.format);
+#ifdef ARCHITECTURE_x86_64
+    const bool use_ssse3 = IsSSSE3TileDecodingSupported();
+#endif // ARCHITECTURE_x86_64
+
+    // Tiles which are cut by the edges of the texture are decoded here first
+    std::array<Common::Vec4<u8>, TILE_SIZE> partial_tile;
+
+    for (unsigned int y = 0; y < info.height; y += 8) {
+        const u8* line = source + (y / 8) * info.stride;
+        const unsigned int height = std::min(8u, info.height - y);
+        for (unsigned int x = 0; x < info.width; x += 8) {
+            const u8* tile = line + (x / 8) * tile_size;
+            const unsigned int width = std::min(8u, info.width - x);
+            const bool is_partial = width < 8 || height < 8;
+            Common::Vec4<u8>* tile_dest =
+                is_partial ? partial_tile.data() : dest + y * info.width + x;
+            const std::size_t dest_stride = is_partial ? 8 : info.width;
+
+#ifdef ARCHITECTURE_x86_64
+            if (!use_ssse3 || !DecodeTileSSSE3(info.format, tile, tile_dest, dest_stride)) {
+                DecodeTile(tile, info, tile_dest, dest_stride);
+            }
+#else
+            DecodeTile(tile, info, tile_dest, dest_stride);
+#endif // ARCHITECTURE_x86_64
+
+            if (is_partial) {
+                for (unsigned int row = 0; row < height; ++row) {
+                    std::copy_n(&partial_tile[row * 8], width, dest + (y + row) * info.width + x);
+                }
+            }
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
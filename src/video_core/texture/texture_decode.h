@@ -55,4 +55,14 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole texture to RGBA8, one 8x8 tile at a time. The results are the same as calling
+ * LookupTexture for each texel, and use SIMD decoders when the host CPU supports them.
+ * @param info TextureInfo describing the texture
+ * @param source Pointer to the beginning of the texture
+ * @param dest Destination of the info.width * info.height texels, stored row by row with the
+ *             coordinates used by LookupTexture
+ */
+void DecodeTexture(const TextureInfo& info, const u8* source, Common::Vec4<u8>* dest);
+
 } // namespace Pica::Texture
@@ -0,0 +1,399 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <tmmintrin.h>
+#include "common/color.h"
+#include "common/x64/cpu_detect.h"
+#include "video_core/texture/etc1.h"
+#include "video_core/texture/texture_decode_x64.h"
+#include "video_core/utils.h"
+
+// The rest of the emulator is built for the baseline x86-64 instruction set, so only the functions
+// of this file may use SSSE3. They are only called when the host CPU supports it.
+#if defined(__GNUC__) || defined(__clang__)
+#define SSSE3_FUNCTION __attribute__((target("ssse3")))
+#else
+#define SSSE3_FUNCTION
+#endif
+
+namespace Pica::Texture {
+
+using TextureFormat = TexturingRegs::TextureFormat;
+
+/// Number of vectors holding the texels of a tile in Morton order, each with one 2x2 block
+constexpr std::size_t BLOCKS_PER_TILE = 16;
+
+SSSE3_FUNCTION static __m128i Load(const u8* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+/// Same as Color::Convert4To8 on each lane, whose value must be less than 16
+SSSE3_FUNCTION static __m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 4), value);
+}
+
+/// Same as Color::Convert5To8 on each 16-bit lane
+SSSE3_FUNCTION static __m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+/// Same as Color::Convert6To8 on each 16-bit lane
+SSSE3_FUNCTION static __m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+
+/// Returns the lanes of `a` where `mask` is set, and the lanes of `b` elsewhere
+SSSE3_FUNCTION static __m128i Select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/// Builds 8 RGBA8 texels from channels stored in 16-bit lanes
+SSSE3_FUNCTION static void PackChannels(__m128i r, __m128i g, __m128i b, __m128i a,
+                                        __m128i* texels) {
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+    texels[0] = _mm_unpacklo_epi16(rg, ba);
+    texels[1] = _mm_unpackhi_epi16(rg, ba);
+}
+
+/// Builds 16 texels {i, i, i, 255} from 16 intensity bytes
+SSSE3_FUNCTION static void ExpandIntensity(__m128i intensity, __m128i* texels) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<s32>(0xFF000000));
+    const __m128i shuffle =
+        _mm_setr_epi8(0, 0, 0, -128, 1, 1, 1, -128, 2, 2, 2, -128, 3, 3, 3, -128);
+    for (int i = 0; i < 4; ++i) {
+        // The zeroing indices stay negative when the offset is added
+        const __m128i block_shuffle = _mm_add_epi8(shuffle, _mm_set1_epi8(4 * i));
+        texels[i] = _mm_or_si128(_mm_shuffle_epi8(intensity, block_shuffle), alpha);
+    }
+}
+
+/// Builds 16 texels {0, 0, 0, a} from 16 alpha bytes
+SSSE3_FUNCTION static void ExpandAlpha(__m128i alpha, __m128i* texels) {
+    const __m128i shuffle =
+        _mm_setr_epi8(-128, -128, -128, 0, -128, -128, -128, 1, -128, -128, -128, 2, -128, -128,
+                      -128, 3);
+    for (int i = 0; i < 4; ++i) {
+        const __m128i block_shuffle = _mm_add_epi8(shuffle, _mm_set1_epi8(4 * i));
+        texels[i] = _mm_shuffle_epi8(alpha, block_shuffle);
+    }
+}
+
+/// Splits 16 bytes into 32 nibbles, the low nibble of each byte coming first
+SSSE3_FUNCTION static void SplitNibbles(__m128i bytes, __m128i& first, __m128i& second) {
+    const __m128i mask = _mm_set1_epi8(0xF);
+    const __m128i low = _mm_and_si128(bytes, mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+    first = _mm_unpacklo_epi8(low, high);
+    second = _mm_unpackhi_epi8(low, high);
+}
+
+SSSE3_FUNCTION static void DecodeRGBA8(const u8* source, __m128i* texels) {
+    const __m128i shuffle =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE; ++i) {
+        texels[i] = _mm_shuffle_epi8(Load(source + 16 * i), shuffle);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeRGB8(const u8* source, __m128i* texels) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<s32>(0xFF000000));
+    const __m128i shuffle =
+        _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE - 1; ++i) {
+        texels[i] = _mm_or_si128(_mm_shuffle_epi8(Load(source + 12 * i), shuffle), alpha);
+    }
+
+    // The last block is loaded 4 bytes earlier, to not read past the end of the tile
+    const __m128i last_shuffle =
+        _mm_setr_epi8(6, 5, 4, -128, 9, 8, 7, -128, 12, 11, 10, -128, 15, 14, 13, -128);
+    texels[15] = _mm_or_si128(_mm_shuffle_epi8(Load(source + 12 * 15 - 4), last_shuffle), alpha);
+}
+
+SSSE3_FUNCTION static void DecodeRGB5A1(const u8* source, __m128i* texels) {
+    const __m128i mask = _mm_set1_epi16(0x1F);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 2; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixel, 11));
+        const __m128i g = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixel, 6), mask));
+        const __m128i b = Expand5To8(_mm_and_si128(_mm_srli_epi16(pixel, 1), mask));
+        const __m128i a =
+            _mm_mullo_epi16(_mm_and_si128(pixel, _mm_set1_epi16(1)), _mm_set1_epi16(255));
+        PackChannels(r, g, b, a, &texels[2 * i]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeRGB565(const u8* source, __m128i* texels) {
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 2; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        const __m128i r = Expand5To8(_mm_srli_epi16(pixel, 11));
+        const __m128i g = Expand6To8(_mm_and_si128(_mm_srli_epi16(pixel, 5), _mm_set1_epi16(0x3F)));
+        const __m128i b = Expand5To8(_mm_and_si128(pixel, _mm_set1_epi16(0x1F)));
+        PackChannels(r, g, b, _mm_set1_epi16(255), &texels[2 * i]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeRGBA4(const u8* source, __m128i* texels) {
+    const __m128i mask = _mm_set1_epi16(0xF);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 2; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        const __m128i r = Expand4To8(_mm_srli_epi16(pixel, 12));
+        const __m128i g = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixel, 8), mask));
+        const __m128i b = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixel, 4), mask));
+        const __m128i a = Expand4To8(_mm_and_si128(pixel, mask));
+        PackChannels(r, g, b, a, &texels[2 * i]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeIA8(const u8* source, __m128i* texels) {
+    const __m128i first_shuffle =
+        _mm_setr_epi8(1, 1, 1, 0, 3, 3, 3, 2, 5, 5, 5, 4, 7, 7, 7, 6);
+    const __m128i second_shuffle =
+        _mm_setr_epi8(9, 9, 9, 8, 11, 11, 11, 10, 13, 13, 13, 12, 15, 15, 15, 14);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 2; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        texels[2 * i] = _mm_shuffle_epi8(pixel, first_shuffle);
+        texels[2 * i + 1] = _mm_shuffle_epi8(pixel, second_shuffle);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeRG8(const u8* source, __m128i* texels) {
+    const __m128i alpha = _mm_set1_epi32(static_cast<s32>(0xFF000000));
+    const __m128i first_shuffle =
+        _mm_setr_epi8(1, 0, -128, -128, 3, 2, -128, -128, 5, 4, -128, -128, 7, 6, -128, -128);
+    const __m128i second_shuffle =
+        _mm_setr_epi8(9, 8, -128, -128, 11, 10, -128, -128, 13, 12, -128, -128, 15, 14, -128, -128);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 2; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        texels[2 * i] = _mm_or_si128(_mm_shuffle_epi8(pixel, first_shuffle), alpha);
+        texels[2 * i + 1] = _mm_or_si128(_mm_shuffle_epi8(pixel, second_shuffle), alpha);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeI8(const u8* source, __m128i* texels) {
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 4; ++i) {
+        ExpandIntensity(Load(source + 16 * i), &texels[4 * i]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeA8(const u8* source, __m128i* texels) {
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 4; ++i) {
+        ExpandAlpha(Load(source + 16 * i), &texels[4 * i]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeIA4(const u8* source, __m128i* texels) {
+    const __m128i first_shuffle = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+    const __m128i second_shuffle =
+        _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+    const __m128i mask = _mm_set1_epi8(0xF);
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 4; ++i) {
+        const __m128i pixel = Load(source + 16 * i);
+        const __m128i intensity = Expand4To8(_mm_and_si128(_mm_srli_epi16(pixel, 4), mask));
+        const __m128i alpha = Expand4To8(_mm_and_si128(pixel, mask));
+        const __m128i low = _mm_unpacklo_epi8(intensity, alpha);
+        const __m128i high = _mm_unpackhi_epi8(intensity, alpha);
+        texels[4 * i] = _mm_shuffle_epi8(low, first_shuffle);
+        texels[4 * i + 1] = _mm_shuffle_epi8(low, second_shuffle);
+        texels[4 * i + 2] = _mm_shuffle_epi8(high, first_shuffle);
+        texels[4 * i + 3] = _mm_shuffle_epi8(high, second_shuffle);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeI4(const u8* source, __m128i* texels) {
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 8; ++i) {
+        __m128i first, second;
+        SplitNibbles(Load(source + 16 * i), first, second);
+        ExpandIntensity(Expand4To8(first), &texels[8 * i]);
+        ExpandIntensity(Expand4To8(second), &texels[8 * i + 4]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeA4(const u8* source, __m128i* texels) {
+    for (std::size_t i = 0; i < BLOCKS_PER_TILE / 8; ++i) {
+        __m128i first, second;
+        SplitNibbles(Load(source + 16 * i), first, second);
+        ExpandAlpha(Expand4To8(first), &texels[8 * i]);
+        ExpandAlpha(Expand4To8(second), &texels[8 * i + 4]);
+    }
+}
+
+/// Writes the texels of a tile stored in Morton order row by row
+SSSE3_FUNCTION static void StoreMortonTile(const __m128i* texels, Common::Vec4<u8>* dest,
+                                           std::size_t dest_stride) {
+    for (u32 y = 0; y < 8; ++y) {
+        // The texels of an even row are in the first half of the 2x2 blocks. The blocks to the
+        // right of a block are 4 and 16 texels further in Morton order.
+        const u32 block = VideoCore::MortonInterleave(0, y) / 4;
+        __m128i left, right;
+        if (y % 2 == 0) {
+            left = _mm_unpacklo_epi64(texels[block], texels[block + 1]);
+            right = _mm_unpacklo_epi64(texels[block + 4], texels[block + 5]);
+        } else {
+            left = _mm_unpackhi_epi64(texels[block], texels[block + 1]);
+            right = _mm_unpackhi_epi64(texels[block + 4], texels[block + 5]);
+        }
+        auto* row = reinterpret_cast<__m128i*>(dest + y * dest_stride);
+        _mm_storeu_si128(row, left);
+        _mm_storeu_si128(row + 1, right);
+    }
+}
+
+/**
+ * Returns a mask of the texels of an ETC1 subtile whose bit is set in one of the 16-bit index
+ * fields. The texels are in row order, while the fields are indexed in column order.
+ */
+SSSE3_FUNCTION static __m128i GetETC1IndexBits(u16 field) {
+    const __m128i byte_index = _mm_setr_epi8(0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1);
+    const __m128i bit = _mm_setr_epi8(1, 16, 1, 16, 2, 32, 2, 32, 4, 64, 4, 64, 8, -128, 8, -128);
+    const __m128i bytes = _mm_shuffle_epi8(_mm_set1_epi16(static_cast<s16>(field)), byte_index);
+    return _mm_cmpeq_epi8(_mm_and_si128(bytes, bit), bit);
+}
+
+/**
+ * Decodes a 4x4 ETC1 subtile the same way as SampleETC1Subtile
+ * @param alpha Alpha of the 16 texels of the subtile, in row order
+ */
+SSSE3_FUNCTION static void DecodeETC1Subtile(u64 color, __m128i alpha, Common::Vec4<u8>* dest,
+                                             std::size_t dest_stride) {
+    const bool flip = (color >> 32) & 1;
+    const bool differential = (color >> 33) & 1;
+    const auto& table_1 = etc1_modifier_table[(color >> 37) & 7];
+    const auto& table_2 = etc1_modifier_table[(color >> 34) & 7];
+
+    __m128i channels[3];
+    const __m128i second_half = flip ? _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)
+                                     : _mm_setr_epi8(0, 0, -1, -1, 0, 0, -1, -1, 0, 0, -1, -1, 0,
+                                                     0, -1, -1);
+    const __m128i subindex = GetETC1IndexBits(static_cast<u16>(color));
+    const __m128i negate = GetETC1IndexBits(static_cast<u16>(color >> 16));
+
+    // The modifiers are looked up in {table_1[0], table_1[1], table_2[0], table_2[1]}
+    const __m128i table_index = _mm_or_si128(_mm_and_si128(subindex, _mm_set1_epi8(1)),
+                                             _mm_and_si128(second_half, _mm_set1_epi8(2)));
+    const __m128i tables = _mm_setr_epi8(table_1[0], table_1[1], table_2[0], table_2[1], 0, 0, 0,
+                                         0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i modifier = _mm_shuffle_epi8(tables, table_index);
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        // The red, green and blue fields are at bits 56, 48 and 40
+        const u32 shift = 56 - 8 * static_cast<u32>(i);
+        u8 base_1, base_2;
+        if (differential) {
+            const int base = static_cast<int>((color >> (shift + 3)) & 0x1F);
+            const int delta = static_cast<int>(((color >> shift) & 0x7) ^ 0x4) - 0x4;
+            base_1 = Color::Convert5To8(static_cast<u8>(base));
+            base_2 = Color::Convert5To8(static_cast<u8>(base + delta));
+        } else {
+            base_1 = Color::Convert4To8(static_cast<u8>((color >> (shift + 4)) & 0xF));
+            base_2 = Color::Convert4To8(static_cast<u8>((color >> shift) & 0xF));
+        }
+
+        // Saturating arithmetic does the clamping to [0, 255]
+        const __m128i base =
+            Select(second_half, _mm_set1_epi8(static_cast<s8>(base_2)),
+                   _mm_set1_epi8(static_cast<s8>(base_1)));
+        channels[i] = Select(negate, _mm_subs_epu8(base, modifier), _mm_adds_epu8(base, modifier));
+    }
+
+    const __m128i rg_low = _mm_unpacklo_epi8(channels[0], channels[1]);
+    const __m128i rg_high = _mm_unpackhi_epi8(channels[0], channels[1]);
+    const __m128i ba_low = _mm_unpacklo_epi8(channels[2], alpha);
+    const __m128i ba_high = _mm_unpackhi_epi8(channels[2], alpha);
+    const __m128i rows[4]{
+        _mm_unpacklo_epi16(rg_low, ba_low),
+        _mm_unpackhi_epi16(rg_low, ba_low),
+        _mm_unpacklo_epi16(rg_high, ba_high),
+        _mm_unpackhi_epi16(rg_high, ba_high),
+    };
+    for (std::size_t y = 0; y < 4; ++y) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + y * dest_stride), rows[y]);
+    }
+}
+
+SSSE3_FUNCTION static void DecodeETC1Tile(const u8* source, bool has_alpha,
+                                          Common::Vec4<u8>* dest, std::size_t dest_stride) {
+    // The alpha nibbles are stored in column order, like the color indices
+    const __m128i alpha_order =
+        _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+    for (u32 subtile = 0; subtile < 4; ++subtile) {
+        __m128i alpha = _mm_set1_epi8(-1);
+        if (has_alpha) {
+            __m128i nibbles, unused;
+            SplitNibbles(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)), nibbles,
+                         unused);
+            alpha = Expand4To8(_mm_shuffle_epi8(nibbles, alpha_order));
+            source += sizeof(u64);
+        }
+
+        u64 color;
+        std::memcpy(&color, source, sizeof(color));
+        source += sizeof(u64);
+
+        const u32 x = (subtile % 2) * 4;
+        const u32 y = (subtile / 2) * 4;
+        DecodeETC1Subtile(color, alpha, dest + y * dest_stride + x, dest_stride);
+    }
+}
+
+bool IsSSSE3TileDecodingSupported() {
+    return Common::GetCPUCaps().ssse3;
+}
+
+SSSE3_FUNCTION bool DecodeTileSSSE3(TextureFormat format, const u8* source,
+                                    Common::Vec4<u8>* dest, std::size_t dest_stride) {
+    __m128i texels[BLOCKS_PER_TILE];
+    switch (format) {
+    case TextureFormat::RGBA8:
+        DecodeRGBA8(source, texels);
+        break;
+    case TextureFormat::RGB8:
+        DecodeRGB8(source, texels);
+        break;
+    case TextureFormat::RGB5A1:
+        DecodeRGB5A1(source, texels);
+        break;
+    case TextureFormat::RGB565:
+        DecodeRGB565(source, texels);
+        break;
+    case TextureFormat::RGBA4:
+        DecodeRGBA4(source, texels);
+        break;
+    case TextureFormat::IA8:
+        DecodeIA8(source, texels);
+        break;
+    case TextureFormat::RG8:
+        DecodeRG8(source, texels);
+        break;
+    case TextureFormat::I8:
+        DecodeI8(source, texels);
+        break;
+    case TextureFormat::A8:
+        DecodeA8(source, texels);
+        break;
+    case TextureFormat::IA4:
+        DecodeIA4(source, texels);
+        break;
+    case TextureFormat::I4:
+        DecodeI4(source, texels);
+        break;
+    case TextureFormat::A4:
+        DecodeA4(source, texels);
+        break;
+    case TextureFormat::ETC1:
+    case TextureFormat::ETC1A4:
+        // ETC1 tiles are made of 4x4 subtiles instead of being in Morton order
+        DecodeETC1Tile(source, format == TextureFormat::ETC1A4, dest, dest_stride);
+        return true;
+    default:
+        return false;
+    }
+    StoreMortonTile(texels, dest, dest_stride);
+    return true;
+}
+
+} // namespace Pica::Texture
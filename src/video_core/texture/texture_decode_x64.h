@@ -0,0 +1,29 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Texture {
+
+/// Returns whether the host CPU supports DecodeTileSSSE3
+bool IsSSSE3TileDecodingSupported();
+
+/**
+ * Decodes an 8x8 texture tile to RGBA8 with SSSE3. The results are bit-exact with
+ * LookupTexelInTile.
+ * @param format Format of the tile
+ * @param source Pointer to the beginning of the tile
+ * @param dest Destination of the texel (0, 0) of the tile
+ * @param dest_stride Distance in texels between two rows of the destination
+ * @return false if there is no SSSE3 decoder for the format, in which case nothing is written
+ */
+bool DecodeTileSSSE3(TexturingRegs::TextureFormat format, const u8* source,
+                     Common::Vec4<u8>* dest, std::size_t dest_stride);
+
+} // namespace Pica::Texture
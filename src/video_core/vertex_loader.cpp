@@ -1,10 +1,16 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/memory_ref.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -15,8 +21,61 @@
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/vertex_loader_jit_x64.h"
+#endif
+
 namespace Pica {
 
+/// Loads an attribute with the given format and number of elements
+template <PipelineRegs::VertexAttributeFormat format, u32 elements>
+static void LoadAttribute(const u8* source, Common::Vec4<float24>& attribute) {
+    using Format = PipelineRegs::VertexAttributeFormat;
+    using T = std::conditional_t<
+        format == Format::BYTE, s8,
+        std::conditional_t<format == Format::UBYTE, u8,
+                           std::conditional_t<format == Format::SHORT, s16, float>>>;
+
+    for (u32 comp = 0; comp < elements; ++comp) {
+        T value;
+        std::memcpy(&value, source + comp * sizeof(T), sizeof(T));
+        attribute[comp] = float24::FromFloat32(static_cast<float>(value));
+    }
+    for (u32 comp = elements; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+template <PipelineRegs::VertexAttributeFormat format>
+static constexpr std::array<AttributeLoadFunc, 4> attribute_loaders_for_format{
+    &LoadAttribute<format, 1>,
+    &LoadAttribute<format, 2>,
+    &LoadAttribute<format, 3>,
+    &LoadAttribute<format, 4>,
+};
+
+/// Attribute loaders indexed by format and number of elements minus one
+static constexpr std::array<std::array<AttributeLoadFunc, 4>, 4> attribute_loaders{
+    attribute_loaders_for_format<PipelineRegs::VertexAttributeFormat::BYTE>,
+    attribute_loaders_for_format<PipelineRegs::VertexAttributeFormat::UBYTE>,
+    attribute_loaders_for_format<PipelineRegs::VertexAttributeFormat::SHORT>,
+    attribute_loaders_for_format<PipelineRegs::VertexAttributeFormat::FLOAT>,
+};
+
+#ifdef ARCHITECTURE_x86_64
+/// Maximum number of compiled loaders kept, games only use a few attribute layouts in a frame
+constexpr std::size_t MAX_JIT_LOADER_CACHE_ENTRIES = 64;
+
+/// Compiled loaders keyed by the hash of their attribute layout, with the jit_loader_cache_clock
+/// value of their last setup so that the least recently used one can be evicted
+struct JitLoaderCacheEntry {
+    std::unique_ptr<VertexLoaderJit> loader;
+    u64 last_use = 0;
+};
+static std::unordered_map<u64, JitLoaderCacheEntry> jit_loader_cache;
+static u64 jit_loader_cache_clock = 0;
+#endif
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -69,13 +128,115 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
     }
 
     is_setup = true;
+
+    SetupSpecializedLoader(attribute_config.GetPhysicalBaseAddress());
+}
+
+void VertexLoader::SetupSpecializedLoader(u32 base_address) {
+    specialized_base_address = base_address;
+    use_specialized_loader = true;
+
+    // Packed description of each attribute, used to look up the compiled loader
+    std::array<u64, 16> layout{};
+
+    // Vertices past the end of the memory holding an attribute are left to the generic path
+    std::size_t vertex_count = std::numeric_limits<u32>::max();
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            const MemoryRef source =
+                VideoCore::g_memory->GetPhysicalRef(base_address + vertex_attribute_sources[i]);
+            const u32 element_size =
+                (vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
+                    ? 4
+                    : (vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::SHORT)
+                          ? 2
+                          : 1;
+            const std::size_t attribute_size = vertex_attribute_elements[i] * element_size;
+            if (!source || source.GetSize() < attribute_size) {
+                // Let the generic path report the invalid address
+                use_specialized_loader = false;
+                return;
+            }
+            vertex_attribute_pointers[i] = source.GetPtr();
+            if (vertex_attribute_strides[i] != 0) {
+                vertex_count = std::min<std::size_t>(
+                    vertex_count,
+                    (source.GetSize() - attribute_size) / vertex_attribute_strides[i] + 1);
+            }
+
+            const auto format = static_cast<std::size_t>(vertex_attribute_formats[i]);
+            vertex_attribute_load_funcs[i] =
+                attribute_loaders[format][vertex_attribute_elements[i] - 1];
+            layout[i] = static_cast<u64>(vertex_attribute_strides[i]) << 32 | format << 4 |
+                        vertex_attribute_elements[i];
+        } else if (vertex_attribute_is_default[i]) {
+            layout[i] = 1 << 8;
+        }
+    }
+    specialized_vertex_count = static_cast<u32>(vertex_count);
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled) {
+        const u64 cache_key =
+            Common::ComputeHash64(layout.data(), num_total_attributes * sizeof(u64));
+        auto iter = jit_loader_cache.find(cache_key);
+        if (iter == jit_loader_cache.end()) {
+            if (jit_loader_cache.size() >= MAX_JIT_LOADER_CACHE_ENTRIES) {
+                // Only one VertexLoader is alive at a time, and it is the one being set up
+                const auto lru = std::min_element(
+                    jit_loader_cache.begin(), jit_loader_cache.end(),
+                    [](const auto& a, const auto& b) {
+                        return a.second.last_use < b.second.last_use;
+                    });
+                jit_loader_cache.erase(lru);
+            }
+            auto loader = std::make_unique<VertexLoaderJit>(
+                num_total_attributes, vertex_attribute_formats, vertex_attribute_elements,
+                vertex_attribute_strides, vertex_attribute_is_default);
+            iter = jit_loader_cache.emplace(cache_key, JitLoaderCacheEntry{std::move(loader)})
+                       .first;
+        }
+        iter->second.last_use = ++jit_loader_cache_clock;
+        jit_loader = iter->second.loader.get();
+    }
+#endif
+}
+
+void VertexLoader::LoadVertexSpecialized(int vertex, Shader::AttributeBuffer& input) const {
+    DEBUG_ASSERT(static_cast<u32>(vertex) < specialized_vertex_count);
+
+#ifdef ARCHITECTURE_x86_64
+    if (jit_loader) {
+        jit_loader->Run(vertex_attribute_pointers.data(), static_cast<u32>(vertex), input,
+                        g_state.input_default_attributes);
+        return;
+    }
+#endif
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            vertex_attribute_load_funcs[i](
+                vertex_attribute_pointers[i] + vertex_attribute_strides[i] * vertex, input.attr[i]);
+        } else if (vertex_attribute_is_default[i]) {
+            input.attr[i] = g_state.input_default_attributes.attr[i];
+        }
+    }
 }
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
+    // Memory accesses are only tracked for the CiTrace recorder
+    if (use_specialized_loader && base_address == specialized_base_address &&
+        static_cast<u32>(vertex) < specialized_vertex_count &&
+        !(g_debug_context && g_debug_context->recorder)) {
+        LoadVertexSpecialized(vertex, input);
+        return;
+    }
+
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
             // Load per-vertex data from the loader arrays
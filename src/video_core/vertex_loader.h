@@ -2,6 +2,8 @@
 
 #include <array>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -14,6 +16,11 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+class VertexLoaderJit;
+
+/// Loads a single attribute from host memory into a shader input register
+using AttributeLoadFunc = void (*)(const u8* source, Common::Vec4<float24>& attribute);
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -23,13 +30,20 @@ public:
 
     void Setup(const PipelineRegs& regs);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    /// Resolves the host pointers of the attribute arrays and picks the specialized loaders
+    void SetupSpecializedLoader(u32 base_address);
+
+    /// Loads a vertex below specialized_vertex_count with the specialized loaders, without
+    /// tracking memory accesses
+    void LoadVertexSpecialized(int vertex, Shader::AttributeBuffer& input) const;
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -37,6 +51,18 @@ private:
     std::array<bool, 16> vertex_attribute_is_default;
     int num_total_attributes = 0;
     bool is_setup = false;
+
+    /// Physical base address the specialized loader was set up for
+    u32 specialized_base_address = 0;
+    /// Host pointers to the attribute data of vertex 0, used by the specialized loaders
+    std::array<const u8*, 16> vertex_attribute_pointers{};
+    /// Number of vertices whose attributes all lie within the memory behind the host pointers
+    u32 specialized_vertex_count = 0;
+    /// Loader specialized on the format and element count of each attribute
+    std::array<AttributeLoadFunc, 16> vertex_attribute_load_funcs{};
+    /// Compiled loader for the whole attribute layout, owned by the layout cache
+    const VertexLoaderJit* jit_loader = nullptr;
+    bool use_specialized_loader = false;
 };
 
 } // namespace Pica
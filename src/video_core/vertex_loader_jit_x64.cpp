@@ -0,0 +1,147 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include <xmmintrin.h>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader_jit_x64.h"
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+
+namespace Pica {
+
+using Format = PipelineRegs::VertexAttributeFormat;
+
+// The generated code only uses registers that are caller-saved on both Windows and SysV
+static const Xbyak::Reg64 POINTERS = ABI_PARAM1.cvt64();
+static const Xbyak::Reg64 VERTEX = ABI_PARAM2.cvt64();
+static const Xbyak::Reg64 INPUT = ABI_PARAM3.cvt64();
+static const Xbyak::Reg64 DEFAULTS = ABI_PARAM4.cvt64();
+
+VertexLoaderJit::VertexLoaderJit(int num_attributes, const std::array<Format, 16>& formats,
+                                 const std::array<u32, 16>& elements,
+                                 const std::array<u32, 16>& strides,
+                                 const std::array<bool, 16>& is_default) {
+    program = getCurr<CompiledLoader*>();
+
+    // Used to set the w component of attributes with less than four elements to one
+    static const __m128 one_w = {0.f, 0.f, 0.f, 1.f};
+
+    // The vertex number is passed as a u32, so the upper half of the register is undefined
+    mov(VERTEX.cvt32(), VERTEX.cvt32());
+
+    for (int i = 0; i < num_attributes; ++i) {
+        const std::size_t offset = i * sizeof(Common::Vec4<float24>);
+        if (elements[i] != 0) {
+            imul(rax, VERTEX, static_cast<int>(strides[i]));
+            add(rax, qword[POINTERS + i * sizeof(const u8*)]);
+
+            Compile_LoadAttribute(formats[i], elements[i]);
+            if (elements[i] < 4) {
+                mov(r11, reinterpret_cast<std::size_t>(&one_w));
+                orps(xmm0, xword[r11]);
+            }
+            movaps(xword[INPUT + offset], xmm0);
+        } else if (is_default[i]) {
+            movaps(xmm0, xword[DEFAULTS + offset]);
+            movaps(xword[INPUT + offset], xmm0);
+        }
+    }
+
+    ret();
+    ready();
+
+    LOG_DEBUG(HW_GPU, "Compiled vertex loader size={}", getSize());
+}
+
+void VertexLoaderJit::Compile_LoadAttribute(Format format, u32 elements) {
+    ASSERT(elements >= 1 && elements <= 4);
+
+    // Only the bytes that belong to the attribute are read, as the data may end right at the end
+    // of a memory region.
+    switch (format) {
+    case Format::BYTE:
+    case Format::UBYTE:
+        switch (elements) {
+        case 1:
+            movzx(r10d, byte[rax]);
+            movd(xmm0, r10d);
+            break;
+        case 2:
+            movzx(r10d, word[rax]);
+            movd(xmm0, r10d);
+            break;
+        case 3:
+            movzx(r10d, word[rax]);
+            movzx(r11d, byte[rax + 2]);
+            shl(r11d, 16);
+            or_(r10d, r11d);
+            movd(xmm0, r10d);
+            break;
+        case 4:
+            movd(xmm0, dword[rax]);
+            break;
+        }
+        if (format == Format::BYTE) {
+            // Sign-extend by moving each byte to the top of its lane and shifting it back down
+            punpcklbw(xmm0, xmm0);
+            punpcklwd(xmm0, xmm0);
+            psrad(xmm0, 24);
+        } else {
+            pxor(xmm1, xmm1);
+            punpcklbw(xmm0, xmm1);
+            punpcklwd(xmm0, xmm1);
+        }
+        cvtdq2ps(xmm0, xmm0);
+        break;
+
+    case Format::SHORT:
+        switch (elements) {
+        case 1:
+            movzx(r10d, word[rax]);
+            movd(xmm0, r10d);
+            break;
+        case 2:
+            movd(xmm0, dword[rax]);
+            break;
+        case 3:
+            movd(xmm0, dword[rax]);
+            movzx(r10d, word[rax + 4]);
+            pinsrw(xmm0, r10d, 2);
+            break;
+        case 4:
+            movq(xmm0, qword[rax]);
+            break;
+        }
+        punpcklwd(xmm0, xmm0);
+        psrad(xmm0, 16);
+        cvtdq2ps(xmm0, xmm0);
+        break;
+
+    case Format::FLOAT:
+        switch (elements) {
+        case 1:
+            movss(xmm0, dword[rax]);
+            break;
+        case 2:
+            movq(xmm0, qword[rax]);
+            break;
+        case 3:
+            movq(xmm0, qword[rax]);
+            movss(xmm1, dword[rax + 8]);
+            movlhps(xmm0, xmm1);
+            break;
+        case 4:
+            movups(xmm0, xword[rax]);
+            break;
+        }
+        break;
+    }
+}
+
+} // namespace Pica
@@ -0,0 +1,59 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <xbyak.h>
+#include "common/common_types.h"
+#include "video_core/regs_pipeline.h"
+
+namespace Pica {
+
+namespace Shader {
+struct AttributeBuffer;
+}
+
+/**
+ * x86-64 routine that loads all attributes of a vertex for one specific attribute layout. The
+ * formats, element counts and strides of the layout are baked into the generated code, and byte,
+ * short and float data is converted to the shader input registers with SSE.
+ */
+class VertexLoaderJit : public Xbyak::CodeGenerator {
+public:
+    /**
+     * Generates the loader.
+     * @param num_attributes Number of input attributes of the layout
+     * @param formats Format of each attribute
+     * @param elements Number of elements loaded from memory for each attribute, 0 if not loaded
+     * @param strides Distance in bytes between the data of two consecutive vertices
+     * @param is_default Whether an attribute that is not loaded takes the default value
+     */
+    VertexLoaderJit(int num_attributes,
+                    const std::array<PipelineRegs::VertexAttributeFormat, 16>& formats,
+                    const std::array<u32, 16>& elements, const std::array<u32, 16>& strides,
+                    const std::array<bool, 16>& is_default);
+
+    /**
+     * Loads a vertex.
+     * @param attribute_pointers Host pointers to the data of vertex 0 for each attribute
+     * @param vertex Number of the vertex to load
+     * @param input Shader input registers to write to
+     * @param defaults Default attribute values
+     */
+    void Run(const u8* const* attribute_pointers, u32 vertex, Shader::AttributeBuffer& input,
+             const Shader::AttributeBuffer& defaults) const {
+        program(attribute_pointers, vertex, &input, &defaults);
+    }
+
+private:
+    /// Loads the elements of an attribute pointed to by rax into xmm0 as floats, zeroing the rest
+    void Compile_LoadAttribute(PipelineRegs::VertexAttributeFormat format, u32 elements);
+
+    using CompiledLoader = void(const u8* const* attribute_pointers, u32 vertex, void* input,
+                                const void* defaults);
+    CompiledLoader* program = nullptr;
+};
+
+} // namespace Pica
@@ -26,6 +26,9 @@ std::unique_ptr<GPUBackend> g_gpu;
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
+std::atomic<bool> g_parallel_vertex_shading_enabled;
+std::atomic<u32> g_shader_jit_batch_size;
+std::atomic<bool> g_parallel_rasterization_enabled;
 std::atomic<bool> g_hw_shader_enabled;
 std::atomic<bool> g_separable_shader_enabled;
 std::atomic<bool> g_hw_shader_accurate_mul;
@@ -33,6 +33,9 @@ extern std::unique_ptr<VideoCore::GPUBackend> g_gpu;
 // qt ui)
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
+extern std::atomic<bool> g_parallel_vertex_shading_enabled;
+extern std::atomic<u32> g_shader_jit_batch_size;
+extern std::atomic<bool> g_parallel_rasterization_enabled;
 extern std::atomic<bool> g_hw_shader_enabled;
 extern std::atomic<bool> g_separable_shader_enabled;
 extern std::atomic<bool> g_hw_shader_accurate_mul;